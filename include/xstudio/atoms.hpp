@@ -92,14 +92,20 @@ namespace media {
     class MediaDetail;
     class MediaKey;
     class AVFrameID;
+    class AVFrameIDSpan;
     class StreamDetail;
-    typedef std::map<timebase::flicks, std::shared_ptr<const AVFrameID>> FrameTimeMap;
+    class FrameTimeMap;
     typedef std::vector<std::pair<utility::time_point, std::shared_ptr<const AVFrameID>>>
         AVFrameIDsAndTimePoints;
     typedef std::vector<std::shared_ptr<const AVFrameID>> AVFrameIDs;
+    typedef std::vector<AVFrameIDSpan> AVFrameIDSpans;
     typedef std::vector<MediaKey> MediaKeyVector;
 } // namespace media
 
+namespace media_cache {
+    class SharedImageCache;
+} // namespace media_cache
+
 namespace media_reader {
     class AudioBuffer;
     class AudioBufPtr;
@@ -156,12 +162,14 @@ CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<const xstudio::utility::BlindDataO
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::bookmark::AnnotationBase>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::colour_pipeline::ColourPipeline>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::media::AVFrameID>)
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::media_cache::SharedImageCache>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::media_reader::AudioBuffer>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::media_reader::MediaReaderManager>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(std::shared_ptr<xstudio::plugin::ViewportOverlayRenderer>)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::colour_pipeline::ColourPipelineDataPtr)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media::FrameTimeMap)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media::AVFrameIDs)
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media::AVFrameIDSpans)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media::AVFrameIDsAndTimePoints)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media_reader::AudioBuffer)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(xstudio::media_reader::AudioBufPtr)
@@ -190,6 +198,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_simple_types, first_custom_type_id)
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::MediaKey))
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::AVFrameID))
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::AVFrameIDs))
+    CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::AVFrameIDSpans))
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::AVFrameIDsAndTimePoints))
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::MediaStatus))
     CAF_ADD_TYPE_ID(xstudio_simple_types, (xstudio::media::MediaType))
@@ -249,6 +258,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_complex_types, xstudio_simple_types_last_type_id
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::optional<xstudio::utility::time_point>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<caf::actor, xstudio::utility::JsonStore>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<caf::uri, std::filesystem::file_time_type>))
+    CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<int, bool>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<int, xstudio::utility::time_point>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<int, xstudio::utility::UuidActor>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::pair<xstudio::utility::UuidActor, xstudio::utility::UuidActor>))
@@ -270,6 +280,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_complex_types, xstudio_simple_types_last_type_id
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::bookmark::AnnotationBase>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::colour_pipeline::ColourPipeline>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::media::AVFrameID>))
+    CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::media_cache::SharedImageCache>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::media_reader::AudioBuffer>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::plugin::ViewportOverlayRenderer>))
     CAF_ADD_TYPE_ID(xstudio_complex_types, (std::shared_ptr<xstudio::thumbnail::ThumbnailBuffer>))
@@ -581,9 +592,11 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_playback_atoms, xstudio_session_atoms_last_type_
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::colour_pipeline, get_colour_pipe_params_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::colour_pipeline, get_colour_pipeline_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::colour_pipeline, set_colour_pipe_params_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, buffer_pool_stats_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, cached_frames_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, count_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, erase_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, get_shared_cache_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, keys_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, preserve_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_cache, retrieve_atom)
@@ -593,18 +606,21 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_playback_atoms, xstudio_session_atoms_last_type_
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, cancel_thumbnail_request_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, clear_precache_queue_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, do_precache_work_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, flush_cache_stores_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_audio_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_future_frames_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_image_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_media_detail_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_reader_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, get_thumbnail_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, partial_frames_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, playback_precache_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, precache_audio_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, process_thumbnail_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, push_image_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, read_precache_audio_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, read_precache_image_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, read_policy_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, retire_readers_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, static_precache_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::media_reader, supported_atom)
@@ -661,6 +677,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(xstudio_playback_atoms, xstudio_session_atoms_last_type_
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::playhead, velocity_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::playhead, velocity_multiplier_atom)
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::playhead, viewport_events_group_atom)
+    CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::playhead, viewport_view_atom)
 
     // **************** add new entries here ******************
     CAF_ADD_ATOM(xstudio_playback_atoms, xstudio::playhead, last_frame_media_pointer_atom)
@@ -1,9 +1,12 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <atomic>
 #include <fmt/format.h>
 #include <limits>
 #include <list>
+#include <memory>
+#include <optional>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -12,6 +15,7 @@
 #include "xstudio/utility/container.hpp"
 #include "xstudio/utility/edit_list.hpp"
 #include "xstudio/utility/frame_list.hpp"
+#include "xstudio/utility/hash.hpp"
 #include "xstudio/utility/json_store.hpp"
 #include "xstudio/utility/media_reference.hpp"
 #include "xstudio/utility/timecode.hpp"
@@ -125,52 +129,73 @@ namespace media {
         utility::Timecode timecode_;
     };
 
-    class MediaKey : private std::string {
+    // Identifies a frame of a media stream in the caches. The key is a 128 bit
+    // hash of the string made from the stream's key_format, so lookups and
+    // messages handle two integers instead of a long path. The readable string
+    // is only kept (see MediaKey::set_intern_names) when debugging.
+    class MediaKey {
 
       public:
         MediaKey()                  = default;
         MediaKey(const MediaKey &o) = default;
-        MediaKey(const std::string &o) : std::string(o) {}
+        MediaKey(const std::string &o) { set(o.data(), o.size()); }
         MediaKey(
             const std::string &key_format,
             const caf::uri &uri,
             const int frame,
-            const std::string &stream_id)
-            : std::string(fmt::format(
-                  key_format,
-                  to_string(uri),
-                  (frame == std::numeric_limits<int>::min() ? 0 : frame),
-                  stream_id)) {}
-
-        bool operator==(const MediaKey &o) const {
-            return static_cast<const std::string &>(o) ==
-                   static_cast<const std::string &>(*this);
+            const std::string &stream_id) {
+            // format on the stack, a key is short lived
+            fmt::memory_buffer buffer;
+            const auto path = uri.str();
+            fmt::format_to(
+                std::back_inserter(buffer),
+                key_format,
+                std::string_view(path.data(), path.size()),
+                (frame == std::numeric_limits<int>::min() ? 0 : frame),
+                stream_id);
+            set(buffer.data(), buffer.size());
         }
 
-        bool operator!=(const MediaKey &o) const {
-            return static_cast<const std::string &>(o) !=
-                   static_cast<const std::string &>(*this);
-        }
+        MediaKey &operator=(const MediaKey &o) = default;
 
+        bool operator==(const MediaKey &o) const { return hi_ == o.hi_ and lo_ == o.lo_; }
+        bool operator!=(const MediaKey &o) const { return hi_ != o.hi_ or lo_ != o.lo_; }
         bool operator<(const MediaKey &o) const {
-            return static_cast<const std::string &>(o) <
-                   static_cast<const std::string &>(*this);
+            return hi_ < o.hi_ or (hi_ == o.hi_ and lo_ < o.lo_);
         }
 
+        [[nodiscard]] size_t hash() const { return static_cast<size_t>(lo_); }
+        [[nodiscard]] bool empty() const { return not hi_ and not lo_; }
+
+        // the string the key was made from, if interning is on
+        [[nodiscard]] std::string name() const;
+        static void set_intern_names(const bool intern) { intern_names_ = intern; }
+
         friend std::string to_string(const MediaKey &value);
-        friend fmt::string_view to_string_view(const MediaKey &value);
 
         template <class Inspector> friend bool inspect(Inspector &f, MediaKey &x) {
-            return f.object(x).fields(f.field("data", static_cast<std::string &>(x)));
+            return f.object(x).fields(f.field("hi", x.hi_), f.field("lo", x.lo_));
+        }
+
+      private:
+        void set(const char *data, const size_t size) {
+            std::tie(hi_, lo_) = utility::hash128(data, size);
+            if (intern_names_)
+                intern_name(std::string(data, size));
         }
+        void intern_name(const std::string &name) const;
+
+        inline static std::atomic<bool> intern_names_ = {false};
+
+        uint64_t hi_ = {0};
+        uint64_t lo_ = {0};
     };
 
+    // stable between sessions, unlike name()
     inline std::string to_string(const MediaKey &v) {
-        return static_cast<const std::string>(v);
+        return fmt::format("{:016x}{:016x}", v.hi_, v.lo_);
     }
 
-    inline fmt::string_view to_string_view(const MediaKey &s) { return {s.data(), s.length()}; }
-
     typedef std::vector<MediaKey> MediaKeyVector;
 
     inline MediaKey media_key(
@@ -178,11 +203,7 @@ namespace media {
         const caf::uri &uri,
         const int frame,
         const std::string &stream_id) {
-        return MediaKey(fmt::format(
-            key_format,
-            to_string(uri),
-            (frame == std::numeric_limits<int>::min() ? 0 : frame),
-            stream_id));
+        return MediaKey(key_format, uri, frame, stream_id);
     }
 
 
@@ -275,6 +296,228 @@ namespace media {
         MediaPointerAndTimePoint;
     typedef std::vector<MediaPointerAndTimePoint> AVFrameIDsAndTimePoints;
 
+    /* Consecutive frames from one source, as sources hand them out in place
+    of an AVFrameID per frame. The frames share everything with the first but
+    their frame number, uri and key, so that is all that's kept for each.
+    FrameTimeMap adds a span's frames without making their AVFrameIDs. */
+    class AVFrameIDSpan {
+      public:
+        AVFrameIDSpan() = default;
+        explicit AVFrameIDSpan(std::shared_ptr<const AVFrameID> first);
+
+        // add frame to the end, false if it differs from the first frame in
+        // more than its frame number, uri and key
+        bool push_back(const std::shared_ptr<const AVFrameID> &frame);
+        // add a frame like the first one
+        void push_back(const int frame, const caf::uri &uri, const MediaKey &key);
+
+        [[nodiscard]] size_t size() const { return frames_.size(); }
+        [[nodiscard]] bool empty() const { return frames_.empty(); }
+
+        // made on demand, null for null frames
+        [[nodiscard]] std::shared_ptr<const AVFrameID> frame(const size_t index) const;
+
+      private:
+        friend class FrameTimeMap;
+
+        struct Frame {
+            int frame_;
+            caf::uri uri_;
+            MediaKey key_;
+        };
+
+        std::shared_ptr<const AVFrameID> first_;
+        std::vector<Frame> frames_;
+    };
+
+    // frames, in as few spans as they fit in
+    AVFrameIDSpans make_spans(const AVFrameIDs &frames);
+
+    // how many frames the spans hold
+    size_t span_frames(const AVFrameIDSpans &spans);
+
+    /* The frames a playhead steps through, in time order, with the time each
+    is shown. As with the map this replaces, the last entry is a null frame
+    marking when the last real frame ends.
+
+    Consecutive frames from one source, shown at a steady rate, are kept as a
+    run: a copy of the run's first frame holds everything the frames share
+    (source, reader, colour params, uuids) and each frame only adds its uri,
+    frame number and key. AVFrameIDs are made when they are asked for, so a
+    long timeline costs a few dozen bytes per frame rather than a full
+    AVFrameID each. */
+    class FrameTimeMap {
+      public:
+        class const_iterator {
+          public:
+            const_iterator() = default;
+
+            // the frame's position in the map, which is the playhead's
+            // logical frame
+            [[nodiscard]] size_t index() const { return index_; }
+
+            [[nodiscard]] timebase::flicks time() const { return map_->time(index_); }
+
+            // made on demand, null for null frames
+            [[nodiscard]] std::shared_ptr<const AVFrameID> frame() const {
+                return map_->frame(index_);
+            }
+
+            // the first frame of the run this frame is in, for what every frame
+            // in the run shares, without making the frame. Null for null frames.
+            [[nodiscard]] const AVFrameID *shared() const { return map_->shared(index_); }
+            [[nodiscard]] int media_frame() const { return map_->frames_[index_].frame_; }
+            [[nodiscard]] const MediaKey &key() const { return map_->frames_[index_].key_; }
+
+            const_iterator &operator++() {
+                ++index_;
+                return *this;
+            }
+            const_iterator &operator--() {
+                --index_;
+                return *this;
+            }
+            const_iterator operator++(int) {
+                auto i = *this;
+                ++index_;
+                return i;
+            }
+            const_iterator operator--(int) {
+                auto i = *this;
+                --index_;
+                return i;
+            }
+            const_iterator &operator+=(const std::ptrdiff_t n) {
+                index_ += n;
+                return *this;
+            }
+            const_iterator &operator-=(const std::ptrdiff_t n) {
+                index_ -= n;
+                return *this;
+            }
+            const_iterator operator+(const std::ptrdiff_t n) const {
+                return const_iterator(map_, index_ + n);
+            }
+            const_iterator operator-(const std::ptrdiff_t n) const {
+                return const_iterator(map_, index_ - n);
+            }
+            std::ptrdiff_t operator-(const const_iterator &o) const {
+                return static_cast<std::ptrdiff_t>(index_) -
+                       static_cast<std::ptrdiff_t>(o.index_);
+            }
+
+            bool operator==(const const_iterator &o) const {
+                return map_ == o.map_ and index_ == o.index_;
+            }
+            bool operator!=(const const_iterator &o) const { return not(*this == o); }
+            bool operator<(const const_iterator &o) const { return index_ < o.index_; }
+
+          private:
+            friend class FrameTimeMap;
+            const_iterator(const FrameTimeMap *map, const size_t index)
+                : map_(map), index_(index) {}
+
+            const FrameTimeMap *map_ = {nullptr};
+            size_t index_            = {0};
+        };
+
+        FrameTimeMap() = default;
+
+        // add a frame shown at time, which must be later than the last one.
+        // timecode replaces the frame's own.
+        void push_back(
+            const timebase::flicks time,
+            const std::shared_ptr<const AVFrameID> &frame,
+            const std::optional<utility::Timecode> &timecode = {});
+
+        // add the frame at index in span, as push_back above
+        void push_back(
+            const timebase::flicks time,
+            const AVFrameIDSpan &span,
+            const size_t index,
+            const std::optional<utility::Timecode> &timecode = {});
+
+        // add all of span's frames, period apart from time. timecode is the
+        // first frame's and counts up with the frames.
+        void push_back(
+            const timebase::flicks time,
+            const timebase::flicks period,
+            const AVFrameIDSpan &span,
+            const std::optional<utility::Timecode> &timecode = {});
+
+        [[nodiscard]] size_t size() const { return frames_.size(); }
+        [[nodiscard]] bool empty() const { return frames_.empty(); }
+        void clear() {
+            runs_.clear();
+            frames_.clear();
+        }
+
+        [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+        [[nodiscard]] const_iterator end() const { return const_iterator(this, size()); }
+
+        // as std::map, by the time a frame is shown
+        [[nodiscard]] const_iterator lower_bound(const timebase::flicks time) const;
+        [[nodiscard]] const_iterator upper_bound(const timebase::flicks time) const;
+        [[nodiscard]] const_iterator find(const timebase::flicks time) const;
+
+        // upper_bound for a playhead stepping through in order, which tries
+        // the frames just after hint before searching
+        [[nodiscard]] const_iterator
+        upper_bound(const timebase::flicks time, const const_iterator &hint) const;
+
+        // replace the count entries from first with all but the last entry of
+        // frames, which like ours only marks where its last frame ends. The
+        // entries after them move by the change in duration.
+        void splice(const size_t first, const size_t count, const FrameTimeMap &frames);
+
+        [[nodiscard]] timebase::flicks time(const size_t index) const {
+            return frames_[index].time_;
+        }
+        [[nodiscard]] std::shared_ptr<const AVFrameID> frame(const size_t index) const;
+        [[nodiscard]] const AVFrameID *shared(const size_t index) const {
+            return run(index).first_.get();
+        }
+
+        // number of runs, for tests and diagnostics
+        [[nodiscard]] size_t runs() const { return runs_.size(); }
+
+      private:
+        struct Run {
+            size_t index_;
+            timebase::flicks time_;
+            // zero until the run has a second frame
+            timebase::flicks period_;
+            // whether the timecode counts up with the frames
+            bool timecode_steps_;
+            std::shared_ptr<const AVFrameID> first_;
+        };
+
+        // kept in time order, so lookups by index are direct and lookups by
+        // time are a search of one vector
+        struct Frame {
+            timebase::flicks time_;
+            uint32_t run_;
+            int frame_;
+            caf::uri uri_;
+            MediaKey key_;
+        };
+
+        [[nodiscard]] const Run &run(const size_t index) const {
+            return runs_[frames_[index].run_];
+        }
+
+        // add a frame that matches like in all but its Frame data
+        void add(const AVFrameID *like, const Frame &data, const utility::Timecode &timecode);
+        void append(
+            const FrameTimeMap &other,
+            const size_t first,
+            const size_t last,
+            const timebase::flicks shift);
+
+        std::vector<Run> runs_;
+        std::vector<Frame> frames_;
+    };
+
     class Media : public utility::Container {
       public:
         Media(const utility::JsonStore &jsn);
@@ -420,7 +663,7 @@ namespace media {
 namespace std {
 template <> struct hash<xstudio::media::MediaKey> {
     size_t operator()(const xstudio::media::MediaKey &k) const {
-        return hash<std::string>()(to_string(k));
+        return k.hash();
     }
 };
 } // namespace std
\ No newline at end of file
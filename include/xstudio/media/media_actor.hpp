@@ -98,7 +98,7 @@ namespace media {
         void get_media_pointers_for_frames(
             const MediaType media_type,
             const LogicalFrameRanges &ranges,
-            caf::typed_response_promise<media::AVFrameIDs> rp);
+            caf::typed_response_promise<media::AVFrameIDSpans> rp);
 
         inline static const std::string NAME = "MediaSourceActor";
         void init();
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "xstudio/utility/json_store.hpp"
+
+namespace xstudio {
+namespace media_cache {
+
+    /* BufferPool
+     *
+     *  During playback, once the cache is full, old image buffers are deleted by
+     *  the cache while new image buffers are allocated by the image reader. This
+     *  happens at high frequency (typically at least 24hz) and frame buffers can
+     *  be large, many megabytes possibly even 100s. Handing that memory back to
+     *  the system and asking for it again means every new frame pays for fresh
+     *  pages being faulted in.
+     *
+     *  Instead, frame sized blocks are parked here when the last reference to a
+     *  buffer goes away and handed straight back out when a reader allocates a
+     *  new buffer of the same size class. Size classes are 1/8th of a power of
+     *  two apart, so a uniform format sequence always hits the same class and
+     *  a block is never more than 12.5% bigger than what was asked for.
+     *
+     *  Blocks smaller than min_pooled_size() (audio, thumbnails etc.) aren't
+     *  worth the trouble and come from the normal allocator. Pooled blocks are
+     *  mapped directly, optionally with huge pages, which saves TLB misses when
+     *  the viewport reads a 100MB frame.
+     */
+    class BufferPool {
+      public:
+        struct Stats {
+            size_t system_allocations_ = {0};
+            size_t pool_hits_          = {0};
+            size_t released_           = {0};
+            size_t trimmed_            = {0};
+            size_t pooled_count_       = {0};
+            size_t pooled_size_        = {0};
+        };
+
+        static BufferPool &instance();
+
+        BufferPool(const size_t max_size = 512 * 1024 * 1024) : max_size_(max_size) {}
+        ~BufferPool();
+
+        BufferPool(const BufferPool &)            = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        // returns a block of at least size bytes, capacity is set to the real
+        // size of the block which must be passed back to release()
+        void *allocate(const size_t size, size_t &capacity);
+        void release(void *data, const size_t capacity);
+
+        void set_max_size(const size_t max_size);
+        void set_huge_pages(const bool huge_pages);
+        void clear();
+
+        [[nodiscard]] size_t max_size() const { return max_size_; }
+        [[nodiscard]] bool huge_pages() const { return huge_pages_; }
+        [[nodiscard]] Stats stats() const;
+        [[nodiscard]] utility::JsonStore stats_json() const;
+
+        [[nodiscard]] static size_t size_class(const size_t size);
+        [[nodiscard]] static size_t min_pooled_size() { return 1024 * 1024; }
+
+      private:
+        void *system_allocate(const size_t capacity);
+        void system_free(void *data, const size_t capacity);
+        void trim(const size_t max_size);
+
+        mutable std::mutex mutex_;
+        size_t max_size_;
+        bool huge_pages_ = {false};
+        uint64_t age_    = {0};
+
+        // free blocks by capacity, most recently released at the back
+        std::map<size_t, std::vector<std::pair<uint64_t, void *>>> free_blocks_;
+        // the same blocks oldest first, for trimming
+        std::map<uint64_t, std::pair<size_t, void *>> free_by_age_;
+
+        Stats stats_;
+    };
+
+} // namespace media_cache
+} // namespace xstudio
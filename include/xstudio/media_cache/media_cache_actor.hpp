@@ -7,10 +7,24 @@
 #include <string>
 
 #include "xstudio/media_reader/media_reader.hpp"
+#include "xstudio/utility/sharded_time_cache.hpp"
 #include "xstudio/utility/time_cache.hpp"
 
 namespace xstudio {
 namespace media_cache {
+
+    // The image cache itself, owned by GlobalImageCacheActor. Readers can get
+    // hold of it with get_shared_cache_atom and then retrieve/preserve frames
+    // directly from their own thread instead of messaging the cache actor.
+    class SharedImageCache
+        : public utility::ShardedTimeCache<media::MediaKey, media_reader::ImageBufPtr> {
+      public:
+        using utility::ShardedTimeCache<media::MediaKey, media_reader::ImageBufPtr>::
+            ShardedTimeCache;
+    };
+
+    typedef std::shared_ptr<SharedImageCache> SharedImageCachePtr;
+
     class GlobalImageCacheActor : public caf::event_based_actor {
       public:
         GlobalImageCacheActor(caf::actor_config &cfg);
@@ -24,14 +38,9 @@ namespace media_cache {
 
       private:
         inline static const std::string NAME = "GlobalImageCacheActor";
-        void
-        update_changes(const media::MediaKeyVector &store, const media::MediaKeyVector &erase);
 
         caf::behavior behavior_;
-        utility::TimeCache<media::MediaKey, media_reader::ImageBufPtr> cache_;
-        std::set<media::MediaKey> new_keys_;
-        std::set<media::MediaKey> erased_keys_;
-        bool update_pending_;
+        SharedImageCachePtr cache_;
     };
 
     class GlobalAudioCacheActor : public caf::event_based_actor {
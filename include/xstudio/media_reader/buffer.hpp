@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <iostream>
 #include <malloc.h>
+#include <memory>
 #include <new>
 
 #define UNSET_DTS -1e6
@@ -33,6 +34,20 @@ namespace media_reader {
         */
         void resize(const size_t size);
 
+        /*
+        Use memory that we don't own, instead of allocating. owner is held
+        for as long as the data is referenced by any buffer.
+        */
+        void reference(byte *data, const size_t size, std::shared_ptr<void> owner);
+
+        /*
+        Drop our reference to the data, everything else is kept
+        */
+        void release_data() {
+            buffer_.reset();
+            size_ = 0;
+        }
+
         /*virtual void assign(byte *buffer, const size_t size) {
             buffer_ = std::unique_ptr<byte>(buffer);
             size_   = size;
@@ -44,10 +59,15 @@ namespace media_reader {
         utility::JsonStore &params() { return params_; }
         [[nodiscard]] size_t size() const { return size_; }
         [[nodiscard]] byte *buffer() {
-            return buffer_ ? (byte *)(buffer_->data_.get()) : nullptr;
+            return buffer_ ? buffer_->data_ : nullptr;
         }
         [[nodiscard]] const byte *buffer() const {
-            return buffer_ ? (const byte *)buffer_->data_.get() : nullptr;
+            return buffer_ ? (const byte *)buffer_->data_ : nullptr;
+        }
+        // what keeps referenced memory alive, empty if we own the memory
+        [[nodiscard]] const std::shared_ptr<void> &owner() const {
+            static const std::shared_ptr<void> none;
+            return buffer_ ? buffer_->owner_ : none;
         }
         [[nodiscard]] BufferErrorState error_state() const { return error_state_; }
         [[nodiscard]] const std::string &error_message() const { return error_message_; }
@@ -62,11 +82,21 @@ namespace media_reader {
             error_state_   = HAS_ERROR;
         }
 
+        // pixel memory comes from, and goes back to, media_cache::BufferPool
+        // when the last buffer referencing it is deleted.
+        // Memory referenced with an owner (a decoder's frame, for example) is
+        // left to the owner instead.
         struct BufferData {
-            BufferData(byte *d) { data_.reset(d); }
-            BufferData(size_t sz) { data_.reset(new (std::align_val_t(1024)) byte[sz]); }
-            std::unique_ptr<byte> data_{
-                nullptr}; // using long long which should get result byte alignment
+            BufferData(size_t sz);
+            BufferData(byte *data, std::shared_ptr<void> owner)
+                : data_(data), owner_(std::move(owner)) {}
+            ~BufferData();
+            BufferData(const BufferData &)            = delete;
+            BufferData &operator=(const BufferData &) = delete;
+
+            byte *data_      = {nullptr};
+            size_t capacity_ = {0};
+            std::shared_ptr<void> owner_;
         };
         typedef std::shared_ptr<BufferData> BufferDataPtr;
 
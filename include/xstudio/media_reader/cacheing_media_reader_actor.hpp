@@ -2,8 +2,10 @@
 #pragma once
 
 #include <caf/all.hpp>
+#include <optional>
 
 #include "xstudio/media/media.hpp"
+#include "xstudio/media_cache/media_cache_actor.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
 #include "xstudio/utility/chrono.hpp"
 #include "xstudio/utility/uuid.hpp"
@@ -17,7 +19,8 @@ namespace media_reader {
             caf::actor_config &cfg,
             const utility::Uuid &plugin_uuid,
             caf::actor image_cache = caf::actor(),
-            caf::actor audio_cache = caf::actor());
+            caf::actor audio_cache = caf::actor(),
+            const caf::uri &uri    = caf::uri());
         ~CachingMediaReaderActor() override = default;
 
         caf::behavior make_behavior() override { return behavior_; }
@@ -25,13 +28,22 @@ namespace media_reader {
         const char *name() const override { return NAME.c_str(); }
 
       private:
+        // what a viewport shows, for loading part of a frame
+        struct ViewportView {
+            Imath::V2f visible_min_;
+            Imath::V2f visible_max_;
+            Imath::V2i size_screen_pixels_;
+            Imath::M44f image_transform_;
+        };
+
         struct ImmediateImageReqest {
 
             ImmediateImageReqest(
                 const media::AVFrameID mptr,
                 caf::actor &playhead,
-                const utility::time_point &time)
-                : mptr_(mptr), playhead_(playhead), time_point_(time) {}
+                const utility::time_point &time,
+                std::optional<ViewportView> view = {})
+                : mptr_(mptr), playhead_(playhead), time_point_(time), view_(std::move(view)) {}
 
             ImmediateImageReqest(const ImmediateImageReqest &) = default;
             ImmediateImageReqest()                             = default;
@@ -41,14 +53,21 @@ namespace media_reader {
             media::AVFrameID mptr_;
             caf::actor playhead_;
             utility::time_point time_point_;
+            std::optional<ViewportView> view_;
         };
 
         void do_urgent_get_image();
+        size_t next_precache_worker(const int frame);
+        void retrieve_cached_image(
+            const media::MediaKey &key,
+            std::function<void(const ImageBufPtr &)> on_retrieved,
+            std::function<void(const caf::error &)> on_error);
         void receive_image_buffer_request(
             const media::AVFrameID &mptr,
             caf::actor playhead,
             const utility::Uuid playhead_uuid,
-            const utility::time_point &tp);
+            const utility::time_point &tp,
+            std::optional<ViewportView> view = {});
 
         std::map<const utility::Uuid, ImmediateImageReqest> pending_get_image_requests_;
 
@@ -58,11 +77,20 @@ namespace media_reader {
         // bool sequential_access_;
         caf::actor image_cache_;
         caf::actor audio_cache_;
+        media_cache::SharedImageCachePtr shared_image_cache_;
 
         bool urgent_worker_busy_ = {false};
 
         caf::actor urgent_worker_;
-        caf::actor precache_worker_;
+        // sized from MediaReader::maximum_readers() for the source
+        std::vector<caf::actor> precache_workers_;
+        std::vector<int> precache_worker_load_;
+        std::vector<int> precache_worker_last_frame_;
+        size_t next_precache_worker_   = {0};
+        bool prefer_sequential_access_ = {true};
+        bool can_do_partial_frames_    = {false};
+        // the last partial frame loaded, which the reader may return again
+        ImageBufPtr last_partial_frame_;
         caf::actor audio_worker_;
     };
 } // namespace media_reader
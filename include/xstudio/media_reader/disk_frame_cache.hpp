@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <caf/all.hpp>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "xstudio/media/media.hpp"
+#include "xstudio/media_reader/image_buffer.hpp"
+
+// A second tier under the RAM image cache. Frames pushed out of the RAM cache
+// are written to a local directory (ideally fast local storage rather than the
+// network storage the media lives on) and read back from there when they are
+// needed again, before falling back on the reader plugin.
+//
+// Only the pixel data goes to disk. Everything else about the frame (shader,
+// params, dimensions etc.) is kept in memory as an ImageBuffer with no data,
+// so a frame restored from disk is identical to the one the reader made.
+// Files only live as long as the cache, they are removed on clear and exit.
+
+namespace xstudio {
+namespace media_reader {
+
+    namespace fs = std::filesystem;
+
+    class DiskFrameCache {
+      public:
+        DiskFrameCache(
+            const std::string &path     = "",
+            const size_t max_size       = 0,
+            const int compression_level = 1);
+        ~DiskFrameCache();
+
+        DiskFrameCache(const DiskFrameCache &)            = delete;
+        DiskFrameCache &operator=(const DiskFrameCache &) = delete;
+
+        void set_path(const std::string &path);
+        void set_max_size(const size_t max_size);
+        // 0 stores raw pixels, 1-9 are zlib levels
+        void set_compression_level(const int level) { compression_level_ = level; }
+
+        [[nodiscard]] bool enabled() const { return not cache_path_.empty() and max_size_; }
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] size_t count() const { return entries_.size(); }
+        [[nodiscard]] bool contains(const media::MediaKey &key) const {
+            return entries_.count(key) != 0;
+        }
+
+        bool store(const media::MediaKey &key, const ImageBufPtr &buf);
+        ImageBufPtr retrieve(const media::MediaKey &key);
+        void erase(const media::MediaKey &key);
+        void clear();
+
+      private:
+        struct Entry {
+            ImageBufPtr image_;
+            fs::path file_;
+            size_t file_size_ = {0};
+            size_t data_size_ = {0};
+            bool compressed_  = {false};
+            uint64_t last_used_;
+        };
+
+        void touch(Entry &entry);
+        void make_room(const size_t size);
+
+        fs::path cache_path_;
+        size_t max_size_;
+        int compression_level_;
+        size_t size_        = {0};
+        uint64_t file_id_   = {0};
+        uint64_t use_count_ = {0};
+
+        std::map<media::MediaKey, Entry> entries_;
+        std::map<uint64_t, media::MediaKey> least_recently_used_;
+    };
+
+    // Shared between the DiskFrameCacheActor and whoever feeds it frames.
+    // Feeders check enabled() so that with no disk cache configured they
+    // don't message the actor at all. Frames are pushed out of the RAM cache
+    // faster than they can be written, so writes are only queued while there
+    // is room and are dropped otherwise, which bounds the memory held by the
+    // queue. Every store sent to the actor must have reserved a place with
+    // try_queue_write().
+    class DiskFrameCacheGate {
+      public:
+        inline static const int max_queued_writes = 8;
+
+        [[nodiscard]] bool enabled() const { return enabled_; }
+        void set_enabled(const bool enabled) { enabled_ = enabled; }
+
+        bool try_queue_write();
+        void write_done() { queued_writes_--; }
+        [[nodiscard]] int queued_writes() const { return queued_writes_; }
+
+      private:
+        std::atomic<bool> enabled_      = {false};
+        std::atomic<int> queued_writes_ = {0};
+    };
+    using DiskFrameCacheGatePtr = std::shared_ptr<DiskFrameCacheGate>;
+
+    class DiskFrameCacheActor : public caf::event_based_actor {
+      public:
+        DiskFrameCacheActor(caf::actor_config &cfg, DiskFrameCacheGatePtr gate = {});
+        ~DiskFrameCacheActor() override = default;
+
+        caf::behavior make_behavior() override { return behavior_; }
+        void on_exit() override;
+        const char *name() const override { return NAME.c_str(); }
+
+      private:
+        void update_preferences(const utility::JsonStore &js);
+
+        inline static const std::string NAME = "DiskFrameCacheActor";
+        caf::behavior behavior_;
+        std::string path_;
+        DiskFrameCache cache_;
+        DiskFrameCacheGatePtr gate_;
+    };
+
+} // namespace media_reader
+} // namespace xstudio
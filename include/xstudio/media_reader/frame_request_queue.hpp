@@ -10,6 +10,7 @@
 #include "xstudio/utility/uuid.hpp"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace xstudio {
@@ -58,6 +59,11 @@ namespace media_reader {
      *   playhead changes position. If the reader can't keep up with the playhead
      *   then 'out of date' unfulfilled requests that were needed in the past need
      *   to be pruned and so-on
+     *
+     *   Requests are kept per playhead, ordered by when they are needed, with an
+     *   index on the frame's media key so that repeat requests for a frame are
+     *   merged. A static precache can queue thousands of frames per playhead
+     *   so adding, popping and clearing requests must not touch the whole queue.
      */
     class FrameRequestQueue {
 
@@ -85,13 +91,17 @@ namespace media_reader {
         /**
          *   @brief Get the next ordered frame request
          *
+         *   @details Requests from playheads that already have max_in_flight
+         *   requests outstanding (as counted in requests_in_flight) are skipped.
          */
-        std::optional<FrameRequest>
-        pop_request(const std::map<utility::Uuid, int> &exclude_playheads);
+        std::optional<FrameRequest> pop_request(
+            const std::map<utility::Uuid, int> &requests_in_flight, const int max_in_flight = 1);
 
         /**
          *   @brief Add a request to the queue
          *
+         *   @details If the playhead has already asked for the frame the request
+         *   is merged with the existing one, keeping the earlier required_by.
          */
         void add_frame_request(
             const media::AVFrameID &frame_info,
@@ -112,8 +122,30 @@ namespace media_reader {
          */
         void clear_pending_requests(const utility::Uuid &playhead_uuid);
 
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] size_t size(const utility::Uuid &playhead_uuid) const {
+            auto p = playheads_.find(playhead_uuid);
+            return p == playheads_.end() ? 0 : p->second.by_deadline_.size();
+        }
+        [[nodiscard]] bool empty() const { return size_ == 0; }
+
       private:
-        std::vector<std::shared_ptr<FrameRequest>> queue_;
+        // requests are ordered by required_by_, then by the order they came in
+        typedef std::pair<utility::time_point, uint64_t> Deadline;
+
+        struct PlayheadRequests {
+            std::map<Deadline, FrameRequest> by_deadline_;
+            std::unordered_map<media::MediaKey, Deadline> by_key_;
+        };
+
+        void add(
+            std::shared_ptr<const media::AVFrameID> frame,
+            const utility::time_point &required_by,
+            const utility::Uuid &requesting_playhead_uuid);
+
+        std::map<utility::Uuid, PlayheadRequests> playheads_;
+        uint64_t sequence_ = {0};
+        size_t size_       = {0};
     };
 
 } // namespace media_reader
@@ -28,6 +28,10 @@ namespace media_reader {
 
         byte *allocate(const size_t size) override;
 
+        // the size allocate() really gives a buffer, for the texture upload.
+        // Memory passed to reference() must be at least this big.
+        static size_t padded_size(const size_t size);
+
         void set_shader(const ui::viewport::GPUShaderPtr &shader) { shader_ = shader; }
         [[nodiscard]] ui::viewport::GPUShaderPtr shader() const { return shader_; }
 
@@ -46,6 +46,11 @@ namespace thumbnail {
 }
 namespace media_reader {
 
+    /* A partial frame holds only part of the image, so it gets a key of its
+    own, made from the full frame's key and the part of the image it holds.
+    It can't then stand in for the full frame in caches or textures. */
+    media::MediaKey partial_frame_key(const media::MediaKey &key, const ImageBufPtr &buf);
+
     class MediaReader {
       public:
         MediaReader(std::string name, const utility::JsonStore &prefs = utility::JsonStore());
@@ -57,6 +62,12 @@ namespace media_reader {
 
         virtual ImageBufPtr image(const media::AVFrameID &mptr);
 
+        /* Load only as much of the frame as the viewport shows.
+        viewport_visible_area is in viewport coordinates (-1 to 1 across the
+        viewport), image_transform takes those to image space and
+        viewport_size_screen_pixels is the viewport's size on screen, so
+        readers can load fewer pixels when zoomed out. current_loaded is what
+        was returned last time, which may be returned again if it's enough. */
         virtual ImageBufPtr partial_image(
             const media::AVFrameID &mptr,
             ImageBufPtr &current_loaded,
@@ -145,31 +156,35 @@ namespace media_reader {
                 },
 
                 [=](get_image_atom, const media::AVFrameID &mptr) -> result<ImageBufPtr> {
-                    ImageBufPtr mb;
-                    try {
-                        std::string path = utility::uri_to_posix_path(mptr.uri_);
-                        mb               = media_reader_.image(mptr);
-                        if (mb) {
-                            mb->set_media_key(mptr.key_);
-                            mb->set_pixel_picker_func(media_reader_.pixel_picker_func());
-                            if (mb->audio_) {
-                                mb->audio_->set_media_key(mptr.key_);
-                            }
-                            mb->set_params(utility::JsonStore(
-                                nlohmann::json({{"path", path}, {"frame", mptr.frame_}})));
-                        }
-                    } catch (const media_missing_error &e) {
-                        return make_error(media::media_error::missing, e.what());
-                    } catch (const media_corrupt_error &e) {
-                        return make_error(media::media_error::corrupt, e.what());
-                    } catch (const media_unsupported_error &e) {
-                        return make_error(media::media_error::unsupported, e.what());
-                    } catch (const media_unreadable_error &e) {
-                        return make_error(media::media_error::unreadable, e.what());
-                    } catch (const std::exception &e) {
-                        return make_error(xstudio_error::error, e.what());
-                    }
-                    return mb;
+                    return read_image(
+                        mptr, false, ImageBufPtr(), [&]() { return media_reader_.image(mptr); });
+                },
+
+                [=](get_image_atom,
+                    const media::AVFrameID &mptr,
+                    ImageBufPtr current_loaded,
+                    const Imath::V2f &viewport_visible_min,
+                    const Imath::V2f &viewport_visible_max,
+                    const Imath::V2i &viewport_size_screen_pixels,
+                    const Imath::M44f &image_transform) -> result<ImageBufPtr> {
+                    const bool partial = media_reader_.can_do_partial_frames();
+                    return read_image(mptr, partial, current_loaded, [&]() {
+                        return media_reader_.partial_image(
+                            mptr,
+                            current_loaded,
+                            Imath::Box2f(viewport_visible_min, viewport_visible_max),
+                            viewport_size_screen_pixels,
+                            image_transform);
+                    });
+                },
+
+                // whether get_image_atom can load part of a frame
+                [=](partial_frames_atom) -> bool { return media_reader_.can_do_partial_frames(); },
+
+                [=](read_policy_atom, const caf::uri &_uri) -> std::pair<int, bool> {
+                    return std::make_pair(
+                        static_cast<int>(media_reader_.maximum_readers(_uri)),
+                        media_reader_.prefer_sequential_access(_uri));
                 },
 
                 [=](get_media_detail_atom, const caf::uri &_uri) -> result<media::MediaDetail> {
@@ -242,6 +257,43 @@ namespace media_reader {
         caf::behavior make_behavior() override { return behavior_; }
 
       private:
+        // image or partial_image, with the buffer labelled and errors mapped
+        template <typename F>
+        caf::result<ImageBufPtr> read_image(
+            const media::AVFrameID &mptr,
+            const bool partial,
+            const ImageBufPtr &current_loaded,
+            F &&read) {
+            ImageBufPtr mb;
+            try {
+                std::string path = utility::uri_to_posix_path(mptr.uri_);
+                mb               = read();
+                // a partial_image can hand back what it was given, which is
+                // already labelled and may be in use elsewhere
+                if (mb && mb != current_loaded) {
+                    const auto key = partial ? partial_frame_key(mptr.key_, mb) : mptr.key_;
+                    mb->set_media_key(key);
+                    mb->set_pixel_picker_func(media_reader_.pixel_picker_func());
+                    if (mb->audio_) {
+                        mb->audio_->set_media_key(key);
+                    }
+                    mb->set_params(utility::JsonStore(
+                        nlohmann::json({{"path", path}, {"frame", mptr.frame_}})));
+                }
+            } catch (const media_missing_error &e) {
+                return make_error(media::media_error::missing, e.what());
+            } catch (const media_corrupt_error &e) {
+                return make_error(media::media_error::corrupt, e.what());
+            } catch (const media_unsupported_error &e) {
+                return make_error(media::media_error::unsupported, e.what());
+            } catch (const media_unreadable_error &e) {
+                return make_error(media::media_error::unreadable, e.what());
+            } catch (const std::exception &e) {
+                return make_error(xstudio_error::error, e.what());
+            }
+            return mb;
+        }
+
         caf::behavior behavior_;
         T media_reader_;
     };
@@ -2,8 +2,11 @@
 #pragma once
 
 #include <caf/all.hpp>
+#include <deque>
 
 #include "xstudio/media/media.hpp"
+#include "xstudio/media_cache/media_cache_actor.hpp"
+#include "xstudio/media_reader/disk_frame_cache.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
 #include "xstudio/utility/chrono.hpp"
 #include "xstudio/utility/uuid.hpp"
@@ -43,6 +46,21 @@ namespace media_reader {
         caf::actor get_reader(
             const caf::uri &_uri, const caf::actor_addr &_key, const std::string &hint = "");
         void do_precache();
+        void fetch_static_precache_frames();
+        void stop_static_precache(const utility::Uuid &playhead_uuid);
+
+        void retrieve_cached_image(
+            const media::MediaKey &key,
+            std::function<void(const ImageBufPtr &)> on_retrieved,
+            std::function<void(const caf::error &)> on_error);
+
+        // send the frame to the playhead from the cache, or have its reader
+        // load it and send it with send_request
+        void get_urgent_image(
+            const media::AVFrameID &mptr,
+            caf::actor playhead,
+            const utility::time_point &tp,
+            std::function<void(caf::actor)> send_request);
 
         void keep_cache_hot(
             const media::MediaKey &new_entry,
@@ -55,12 +73,24 @@ namespace media_reader {
             const utility::time_point cache_out_of_date_threshold,
             const bool is_background_cache);
 
+        void image_read_complete(
+            const utility::Uuid &playhead_uuid, const uint64_t id, const ImageBufPtr &buf);
+
+        void store_precached_image(
+            const FrameRequest &fr,
+            const ImageBufPtr &buf,
+            const utility::time_point cache_out_of_date_threshold,
+            const bool is_background_cache);
+
         void read_and_cache_audio(
             caf::actor reader,
             const FrameRequest fr,
             const utility::time_point cache_out_of_date_threshold,
             const bool is_background_cache);
 
+        void queue_cache_store();
+        void flush_cache_stores();
+
         void continue_precacheing();
 
         void mark_playhead_waiting_for_precache_result(const utility::Uuid &playhead_uuid);
@@ -72,9 +102,66 @@ namespace media_reader {
         void process_get_media_detail_queue();
 
       private:
+        // a precache read for a playhead, held until the reads requested before
+        // it have come back so that frames go into the cache in order.
+        struct PendingImageStore {
+            PendingImageStore(
+                const uint64_t id,
+                const FrameRequest &fr,
+                const utility::time_point &threshold,
+                const bool background)
+                : id_(id),
+                  request_(fr),
+                  cache_out_of_date_threshold_(threshold),
+                  is_background_cache_(background) {}
+
+            uint64_t id_;
+            FrameRequest request_;
+            utility::time_point cache_out_of_date_threshold_;
+            bool is_background_cache_;
+            bool done_ = {false};
+            ImageBufPtr buf_;
+        };
+
+        // precached frames waiting to go to a cache, sent as one message
+        template <typename B> struct CacheStoreBatch {
+            void add(
+                const media::MediaKey &key,
+                const B &buf,
+                const utility::time_point &when,
+                const utility::time_point &out_of_date) {
+                keys_.push_back(key);
+                bufs_.push_back(buf);
+                when_.push_back(when);
+                out_of_date_.push_back(out_of_date);
+            }
+
+            media::MediaKeyVector keys_;
+            std::vector<B> bufs_;
+            std::vector<utility::time_point> when_;
+            std::vector<utility::time_point> out_of_date_;
+        };
+        // keyed on the playhead and whether it's background cacheing
+        typedef std::pair<utility::Uuid, bool> CacheStoreBatchKey;
+
+        // where to get more frames for a playhead's idle precache
+        struct StaticPrecacheCursor {
+            StaticPrecacheCursor() = default;
+            StaticPrecacheCursor(caf::actor source, const uint64_t id)
+                : source_(std::move(source)), id_(id) {}
+
+            caf::actor source_;
+            uint64_t id_   = {0};
+            bool fetching_ = {false};
+            bool fetched_  = {false};
+        };
+
         caf::actor pool_;
         caf::actor image_cache_;
         caf::actor audio_cache_;
+        caf::actor disk_cache_;
+        DiskFrameCacheGatePtr disk_cache_gate_;
+        media_cache::SharedImageCachePtr shared_image_cache_;
         caf::behavior behavior_;
         utility::Uuid uuid_;
         std::map<std::string, caf::actor> readers_;
@@ -84,6 +171,16 @@ namespace media_reader {
         std::map<utility::Uuid, utility::time_point> background_cached_ref_timepoint_;
 
         std::map<utility::Uuid, int> playheads_with_precache_requests_in_flight_;
+        std::map<utility::Uuid, std::deque<PendingImageStore>> pending_image_stores_;
+        std::map<utility::Uuid, StaticPrecacheCursor> static_precache_cursors_;
+        uint64_t next_static_precache_id_ = {0};
+        uint64_t next_precache_id_        = {0};
+        int max_inflight_per_playhead_    = {4};
+
+        std::map<CacheStoreBatchKey, CacheStoreBatch<ImageBufPtr>> image_store_batches_;
+        std::map<CacheStoreBatchKey, CacheStoreBatch<AudioBufPtr>> audio_store_batches_;
+        size_t batched_store_count_ = {0};
+        bool store_flush_pending_   = {false};
 
         std::vector<caf::actor> plugins_;
         std::map<std::string, utility::Uuid> plugins_map_;
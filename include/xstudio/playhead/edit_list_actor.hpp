@@ -37,17 +37,37 @@ namespace playhead {
             const utility::FrameRate &override_rate,
             const media::MediaType media_type,
             const int clip_index,
+            const int end_clip_index,
             const timebase::flicks clip_start_time_point,
             std::shared_ptr<media::FrameTimeMap> result,
             caf::typed_response_promise<media::FrameTimeMap> rp);
 
+        void set_sources(const std::vector<caf::actor> &sources);
+        void replace_sources(
+            const size_t first, const size_t count, const std::vector<caf::actor> &sources);
+        void apply_sources(
+            const size_t first,
+            const size_t count,
+            const std::vector<caf::actor> &sources,
+            const std::vector<std::pair<utility::EditList, utility::Uuid>> &edit_lists);
+        void source_changed(const caf::actor &source);
+        void refresh_changed_sources();
+
       private:
         caf::behavior behavior_;
         caf::actor event_group_;
         std::map<utility::Uuid, caf::actor> source_actors_per_uuid_;
         std::vector<caf::actor> source_actors_;
+        // per source, its uuid and how many sections of edit_list_ it has
+        std::vector<utility::Uuid> source_uuids_;
+        std::vector<size_t> source_sections_;
         utility::EditList edit_list_;
         int frames_offset_;
+
+        // counts changes to the edit list, so playheads can tell if they
+        // have missed one
+        int edits_ = {0};
+        std::vector<caf::actor> changed_sources_;
     };
 } // namespace playhead
 } // namespace xstudio
@@ -46,9 +46,11 @@ namespace playhead {
         void clear_child_playheads();
         caf::actor make_child_playhead(caf::actor source);
         caf::actor make_audio_child_playhead(caf::actor source);
+        void send_viewport_view(caf::actor sub_playhead);
         void rebuild();
         void connect_to_playlist_selection_actor(caf::actor playlist_selection);
         void new_source_list(const std::vector<caf::actor> &sl);
+        void sources_changed();
         void switch_key_playhead(int idx);
         void calculate_duration();
         void update_child_playhead_positions(
@@ -103,6 +105,8 @@ namespace playhead {
         caf::actor playhead_media_events_group_;
         std::vector<caf::actor> playheads_;
         std::vector<caf::actor> source_wrappers_;
+        // in string compare mode, the EditListActor that strings the sources
+        caf::actor string_edit_list_;
         std::vector<caf::actor> source_actors_;
         caf::actor key_playhead_;
         caf::actor audio_output_actor_;
@@ -121,6 +125,12 @@ namespace playhead {
         std::set<media::MediaKey> frames_cached_;
 
         media::MediaKeyVector all_frames_keys_;
+        // what the viewport shows, passed on to child playheads
+        bool have_viewport_view_ = {false};
+        Imath::V2f viewport_visible_min_, viewport_visible_max_;
+        Imath::V2i viewport_size_screen_pixels_;
+        Imath::M44f viewport_image_transform_;
+
         bool updating_source_list_                      = {false};
         bool child_playhead_changed_                    = {false};
         timebase::flicks vid_refresh_sync_phase_adjust_ = timebase::flicks{0};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <caf/all.hpp>
+#include <optional>
 // #include <chrono>
 
 #include "xstudio/colour_pipeline/colour_pipeline.hpp"
@@ -62,6 +63,18 @@ namespace playhead {
         std::vector<timebase::flicks> get_lookahead_frame_pointers(
             media::AVFrameIDsAndTimePoints &result, const int max_num_frames);
 
+        bool walk_frames(
+            media::AVFrameIDsAndTimePoints &result,
+            std::vector<timebase::flicks> *tps,
+            media::FrameTimeMap::const_iterator &frame,
+            const media::FrameTimeMap::const_iterator &start_point,
+            const bool forwards,
+            utility::time_point &tt,
+            int max_num_frames);
+
+        void get_static_precache_frames(
+            media::AVFrameIDsAndTimePoints &result, const int max_num_frames);
+
         void request_future_frames();
 
         void update_playback_precache_requests(caf::typed_response_promise<bool> &rp);
@@ -75,6 +88,14 @@ namespace playhead {
             const utility::time_point tp);
 
         void get_full_timeline_frame_list(caf::typed_response_promise<caf::actor> rp);
+        void fetch_full_timeline_frames(
+            caf::typed_response_promise<caf::actor> rp, const int edit);
+        void splice_edit(
+            const int edit,
+            const int first_section,
+            const utility::EditList &removed,
+            const int added_sections);
+        void full_timeline_frames_changed();
 
         std::shared_ptr<const media::AVFrameID> get_frame(
             const timebase::flicks &time,
@@ -125,9 +146,37 @@ namespace playhead {
         const media::MediaType media_type_;
         std::shared_ptr<const media::AVFrameID> previous_frame_;
 
-        std::map<timebase::flicks, int> timeline_logical_frame_pts_;
         media::FrameTimeMap full_timeline_frames_;
-        media::FrameTimeMap::iterator in_frame_, out_frame_, first_frame_, last_frame_;
+        media::FrameTimeMap::const_iterator in_frame_, out_frame_, first_frame_, last_frame_;
+        // the frame last shown, where the next look up by time starts
+        media::FrameTimeMap::const_iterator current_frame_;
+
+        // sources that are edited in place, like EditListActor, number their
+        // edits. We ask on the first full read, and stop asking once the
+        // source says it doesn't. edit_ is the last edit that
+        // full_timeline_frames_ includes, or -1 if we can't tell.
+        bool editable_source_ = {true};
+        int edit_             = {-1};
+
+        // how far the idle precache has got. The reader asks for frames from
+        // here as it has room for them, rather than being sent the whole range.
+        struct StaticPrecacheCursor {
+            bool active_   = {false};
+            bool forwards_ = {true};
+            timebase::flicks position_;
+            timebase::flicks start_;
+            utility::time_point tt_;
+        } static_precache_cursor_;
+
+        // what the viewport shows, set by the parent playhead. When we
+        // scrub, the reader may load just this part of the frame.
+        struct ViewportView {
+            Imath::V2f visible_min_;
+            Imath::V2f visible_max_;
+            Imath::V2i size_screen_pixels_;
+            Imath::M44f image_transform_;
+        };
+        std::optional<ViewportView> viewport_view_;
 
         typedef std::pair<media_reader::ImageBufPtr, colour_pipeline::ColourPipelineDataPtr>
             ImageAndLut;
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <caf/all.hpp>
+#include <functional>
 
 #include "xstudio/timeline/clip.hpp"
 #include "xstudio/timeline/stack.hpp"
@@ -28,6 +29,17 @@ namespace timeline {
         inline static const std::string NAME = "ClipActor";
         void init();
 
+        // the media's logical frame at a clip time, rounded at override_rate
+        [[nodiscard]] int to_logical_frame(
+            const utility::FrameRate &timepoint, const utility::FrameRate &override_rate) const;
+
+        // media pointers for logical frames, from the cache or the media,
+        // passed to deliver
+        void get_media_pointers(
+            const media::MediaType media_type,
+            const std::vector<int> &logical_frames,
+            std::function<void(const media::AVFrameIDs &)> deliver);
+
         caf::behavior make_behavior() override { return behavior_; }
 
       private:
@@ -3,7 +3,9 @@
 
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <caf/all.hpp>
 
 #include "xstudio/utility/frame_range.hpp"
@@ -29,6 +31,14 @@ namespace timeline {
     class Item;
     using Items = std::list<Item>;
 
+    // A stretch of time over which an item resolves to the same clip, with the
+    // clip's time advancing in step, or to nothing (item_ is null).
+    struct ResolvedSpan {
+        const Item *item_ = {nullptr};
+        utility::FrameRate time_;
+        utility::FrameRate duration_;
+    };
+
     typedef std::function<void(const utility::JsonStore &event, Item &item)> ItemEventFunc;
 
     class Item : private Items {
@@ -69,35 +79,99 @@ namespace timeline {
         }
         Item(const utility::JsonStore &jsn, caf::actor_system *system = nullptr);
 
-        using Items::clear;
+        // Anything that can change an item, including handing out a non-const
+        // reference to its children, counts as a change (see TimeIndex).
         using Items::empty;
         using Items::size;
 
-        using Items::begin;
         using Items::cbegin;
         using Items::cend;
-        using Items::end;
-
         using Items::crbegin;
         using Items::crend;
-        using Items::rbegin;
-        using Items::rend;
 
-        using Items::back;
-        using Items::front;
+        Items::const_iterator begin() const { return Items::begin(); }
+        Items::const_iterator end() const { return Items::end(); }
+        Items::const_reverse_iterator rbegin() const { return Items::rbegin(); }
+        Items::const_reverse_iterator rend() const { return Items::rend(); }
+        const Item &front() const { return Items::front(); }
+        const Item &back() const { return Items::back(); }
 
-        // using Items::insert;
-        using Items::emplace_back;
-        using Items::emplace_front;
-        using Items::pop_back;
-        using Items::pop_front;
-        using Items::push_back;
-        using Items::push_front;
-        using Items::splice;
+        Items::iterator begin() {
+            changed();
+            return Items::begin();
+        }
+        Items::iterator end() {
+            changed();
+            return Items::end();
+        }
+        Items::reverse_iterator rbegin() {
+            changed();
+            return Items::rbegin();
+        }
+        Items::reverse_iterator rend() {
+            changed();
+            return Items::rend();
+        }
+        Item &front() {
+            changed();
+            return Items::front();
+        }
+        Item &back() {
+            changed();
+            return Items::back();
+        }
 
+        // using Items::insert;
+        void clear() {
+            changed();
+            Items::clear();
+        }
+        template <class... Args> Item &emplace_back(Args &&...args) {
+            changed();
+            return Items::emplace_back(std::forward<Args>(args)...);
+        }
+        template <class... Args> Item &emplace_front(Args &&...args) {
+            changed();
+            return Items::emplace_front(std::forward<Args>(args)...);
+        }
+        void pop_back() {
+            changed();
+            Items::pop_back();
+        }
+        void pop_front() {
+            changed();
+            Items::pop_front();
+        }
+        void push_back(const Item &value) {
+            changed();
+            Items::push_back(value);
+        }
+        void push_back(Item &&value) {
+            changed();
+            Items::push_back(std::move(value));
+        }
+        void push_front(const Item &value) {
+            changed();
+            Items::push_front(value);
+        }
+        void push_front(Item &&value) {
+            changed();
+            Items::push_front(std::move(value));
+        }
+        void splice(Items::const_iterator pos, Items &other) {
+            changed();
+            Items::splice(pos, other);
+        }
+        void splice(Items::const_iterator pos, Items &other, Items::const_iterator it) {
+            changed();
+            Items::splice(pos, other, it);
+        }
 
         [[nodiscard]] const Items &children() const { return *this; }
-        [[nodiscard]] Items &children() { return *this; }
+        [[nodiscard]] Items &children() {
+            changed();
+            return *this;
+        }
 
         [[nodiscard]] bool valid_child(const Item &child) const;
         [[nodiscard]] bool valid() const;
@@ -194,6 +268,19 @@ namespace timeline {
             const utility::FrameRate &time,
             const media::MediaType mt = media::MediaType::MT_IMAGE) const;
 
+        // resolve_time for a span of time starting at time, so callers can
+        // resolve a timeline once per edit rather than once per frame. The
+        // duration is zero past the end of the item.
+        [[nodiscard]] ResolvedSpan resolve_span(
+            const utility::FrameRate &time,
+            const media::MediaType mt = media::MediaType::MT_IMAGE) const;
+
+        // the children of a track that overlap duration from time, each with
+        // the time it starts at, on the same terms as time. Empty for items
+        // that aren't tracks.
+        [[nodiscard]] std::vector<std::pair<const Item *, utility::FrameRate>>
+        children_in_range(const utility::FrameRate &time, const utility::FrameRate &duration) const;
+
         void undo(const utility::JsonStore &event);
         void redo(const utility::JsonStore &event);
 
@@ -206,6 +293,49 @@ namespace timeline {
         [[nodiscard]] utility::JsonStore make_actor_addr_update() const;
 
       private:
+        /* Where each child of a track ends, relative to the track's start, so
+        resolve_time can binary search for the child at a time instead of
+        walking the list. It's built on first use and rebuilt once the track's
+        generation_ has moved on. A copied item has different children, so the
+        index isn't copied. */
+        class TimeIndex {
+          public:
+            TimeIndex() = default;
+            TimeIndex(const TimeIndex &) {}
+            TimeIndex &operator=(const TimeIndex &) {
+                // the item has been replaced
+                std::lock_guard<std::mutex> l(mutex_);
+                generation_ = 0;
+                ends_.clear();
+                items_.clear();
+                return *this;
+            }
+
+            // the child at time and the child's own time, for resolve_time
+            std::optional<std::tuple<const Item *, utility::FrameRate>>
+            find(const Item &track, const utility::FrameRate &time) const;
+
+            // the children overlapping [start, end) and where each starts
+            std::vector<std::pair<const Item *, utility::FrameRate>> find_range(
+                const Item &track,
+                const utility::FrameRate &start,
+                const utility::FrameRate &end) const;
+
+          private:
+            // with mutex_ held
+            void update(const Item &track) const;
+
+            mutable std::mutex mutex_;
+            mutable uint64_t generation_{0};
+            mutable std::vector<utility::FrameRate> ends_;
+            mutable std::vector<const Item *> items_;
+        };
+
+        // Changes to this item, or to its children as far as it can tell. The
+        // update/event path and refresh() count a child's change against its
+        // parent, and so does handing out non-const access to the children.
+        void changed() { ++generation_; }
+
         bool process_event(const utility::JsonStore &event);
         void splice_direct(
             Items::const_iterator pos,
@@ -235,6 +365,10 @@ namespace timeline {
         // not sure if this is safe..
         caf::actor_system *the_system_{nullptr};
         ItemEventFunc item_event_callback_{nullptr};
+        TimeIndex time_index_;
+
+        // starts at 1, so an index that has never been built is out of date
+        uint64_t generation_{1};
     };
 
     inline Items::const_iterator find_item(const Items &items, const utility::Uuid &uuid) {
@@ -290,6 +290,10 @@ namespace ui {
 
             void update_matrix();
 
+            // tell the playhead what part of the image is in view, so readers
+            // can load just that part while scrubbing
+            void send_view_to_playhead();
+
             void get_colour_pipeline();
 
             void update_pixel_picker_info(const PointerEvent &pointer_event);
@@ -317,6 +321,8 @@ namespace ui {
             caf::actor media_cache_actor_;
 
             caf::actor_addr playhead_addr_;
+            Imath::M44f view_sent_transform_;
+            Imath::V2i view_sent_size_;
 
             caf::actor overlay_actor_;
 
@@ -43,6 +43,19 @@ namespace utility {
         [[nodiscard]] std::vector<std::pair<Uuid, timebase::flicks>>
         flick_durations(const TimeSourceMode tsm, const FrameRate &fr = FrameRate()) const;
 
+        // the frames a playhead steps through for count sections from first,
+        // each at the override rate in FIXED mode or its own rate otherwise
+        [[nodiscard]] size_t section_frames(
+            const size_t first,
+            const size_t count,
+            const TimeSourceMode tsm,
+            const FrameRate &override_rate) const;
+        [[nodiscard]] timebase::flicks section_flicks(
+            const size_t first,
+            const size_t count,
+            const TimeSourceMode tsm,
+            const FrameRate &override_rate) const;
+
         [[nodiscard]] timebase::flicks flicks_from_logical(
             const int logical_frame,
             const TimeSourceMode tsm,
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace xstudio {
+namespace utility {
+
+    // MurmurHash3 x64 128 (Austin Appleby, public domain). Stable across
+    // processes and platforms, so hashes can be persisted.
+    inline std::pair<uint64_t, uint64_t>
+    hash128(const void *key, const size_t len, const uint64_t seed = 0) {
+        const auto *data     = static_cast<const uint8_t *>(key);
+        const size_t nblocks = len / 16;
+
+        uint64_t h1 = seed;
+        uint64_t h2 = seed;
+
+        const uint64_t c1 = 0x87c37b91114253d5ULL;
+        const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+        const auto rotl = [](const uint64_t x, const int r) -> uint64_t {
+            return (x << r) | (x >> (64 - r));
+        };
+        const auto fmix = [](uint64_t k) -> uint64_t {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ULL;
+            k ^= k >> 33;
+            return k;
+        };
+
+        for (size_t i = 0; i < nblocks; i++) {
+            uint64_t k1, k2;
+            std::memcpy(&k1, data + i * 16, 8);
+            std::memcpy(&k2, data + i * 16 + 8, 8);
+
+            k1 *= c1;
+            k1 = rotl(k1, 31);
+            k1 *= c2;
+            h1 ^= k1;
+            h1 = rotl(h1, 27);
+            h1 += h2;
+            h1 = h1 * 5 + 0x52dce729;
+
+            k2 *= c2;
+            k2 = rotl(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+            h2 = rotl(h2, 31);
+            h2 += h1;
+            h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        const uint8_t *tail = data + nblocks * 16;
+        uint64_t k1         = 0;
+        uint64_t k2         = 0;
+
+        switch (len & 15) {
+        case 15:
+            k2 ^= uint64_t(tail[14]) << 48;
+            [[fallthrough]];
+        case 14:
+            k2 ^= uint64_t(tail[13]) << 40;
+            [[fallthrough]];
+        case 13:
+            k2 ^= uint64_t(tail[12]) << 32;
+            [[fallthrough]];
+        case 12:
+            k2 ^= uint64_t(tail[11]) << 24;
+            [[fallthrough]];
+        case 11:
+            k2 ^= uint64_t(tail[10]) << 16;
+            [[fallthrough]];
+        case 10:
+            k2 ^= uint64_t(tail[9]) << 8;
+            [[fallthrough]];
+        case 9:
+            k2 ^= uint64_t(tail[8]);
+            k2 *= c2;
+            k2 = rotl(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+            [[fallthrough]];
+        case 8:
+            k1 ^= uint64_t(tail[7]) << 56;
+            [[fallthrough]];
+        case 7:
+            k1 ^= uint64_t(tail[6]) << 48;
+            [[fallthrough]];
+        case 6:
+            k1 ^= uint64_t(tail[5]) << 40;
+            [[fallthrough]];
+        case 5:
+            k1 ^= uint64_t(tail[4]) << 32;
+            [[fallthrough]];
+        case 4:
+            k1 ^= uint64_t(tail[3]) << 24;
+            [[fallthrough]];
+        case 3:
+            k1 ^= uint64_t(tail[2]) << 16;
+            [[fallthrough]];
+        case 2:
+            k1 ^= uint64_t(tail[1]) << 8;
+            [[fallthrough]];
+        case 1:
+            k1 ^= uint64_t(tail[0]);
+            k1 *= c1;
+            k1 = rotl(k1, 31);
+            k1 *= c2;
+            h1 ^= k1;
+        }
+
+        h1 ^= uint64_t(len);
+        h2 ^= uint64_t(len);
+
+        h1 += h2;
+        h2 += h1;
+
+        h1 = fmix(h1);
+        h2 = fmix(h2);
+
+        h1 += h2;
+        h2 += h1;
+
+        return std::make_pair(h1, h2);
+    }
+
+} // namespace utility
+} // namespace xstudio
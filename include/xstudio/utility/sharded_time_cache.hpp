@@ -0,0 +1,420 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "xstudio/utility/time_cache.hpp"
+
+namespace xstudio {
+namespace utility {
+
+    // A TimeCache split into shards by key hash, each with its own lock, so one
+    // cache can be shared between actors and hit from any thread without going
+    // through a mailbox. The size/count budget is shared by all the shards. When
+    // a store needs room, each shard offers the entry TimeCache would release
+    // next and the one furthest from now goes, so entries leave in the same
+    // order as from a single TimeCache. Stores racing each other for the last
+    // of the budget can take the cache over it by those entries, until the next
+    // store makes room.
+    // Store/erase notifications are gathered up rather than passed on per call,
+    // the change callback only says there is something new for take_changes().
+    template <typename K, typename V, typename Hash = std::hash<K>> class ShardedTimeCache {
+      public:
+        ShardedTimeCache(
+            const size_t shard_count = 16,
+            const size_t max_size    = std::numeric_limits<size_t>::max(),
+            const size_t max_count   = std::numeric_limits<size_t>::max());
+        virtual ~ShardedTimeCache() = default;
+
+        bool store(
+            const K &key,
+            V value,
+            const time_point &time    = utility::clock::now(),
+            const bool force_eviction = false,
+            const utility::Uuid &uuid = utility::Uuid());
+
+        bool store(
+            const K &key,
+            V value,
+            const time_point &time,
+            const utility::Uuid &uuid,
+            const time_point &out_of_date_time);
+
+        V retrieve(
+            const K &key,
+            const time_point &time    = utility::clock::now(),
+            const utility::Uuid &uuid = utility::Uuid());
+
+        bool preserve(
+            const K &key,
+            const time_point &time    = utility::clock::now(),
+            const utility::Uuid &uuid = utility::Uuid());
+
+        void make_entries_hot(const std::vector<std::pair<media::MediaKey, utility::time_point>>
+                                  &keys_and_timepoints);
+
+        void unpreserve(const utility::Uuid &uuid);
+
+        void clear();
+        bool erase(const K &key);
+        bool erase(const utility::Uuid &uuid);
+        bool erase(const K &key, const utility::Uuid &uuid);
+        std::vector<K> erase(const std::vector<K> &keys);
+
+        [[nodiscard]] std::vector<K> keys() const;
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] size_t count() const { return count_; }
+
+        [[nodiscard]] size_t max_size() const { return max_size_; }
+        [[nodiscard]] size_t max_count() const { return max_count_; }
+        [[nodiscard]] size_t shard_count() const { return shards_.size(); }
+
+        void set_max_size(const size_t max_size);
+        void set_max_count(const size_t max_count);
+
+        void bind_change_callback(std::function<void()> fn) {
+            std::lock_guard<std::mutex> l(changes_mutex_);
+            change_callback_ = std::move(fn);
+        }
+
+        // called from whichever thread's store pushed the value out.
+        void bind_eviction_callback(std::function<void(const K &key, const V &value)> fn) {
+            for (auto &s : shards_) {
+                std::lock_guard<std::mutex> l(s->mutex_);
+                s->cache_.bind_eviction_callback(fn);
+            }
+        }
+
+        // hand over the keys stored and erased since the last call.
+        void take_changes(std::vector<K> &stored, std::vector<K> &erased);
+
+      private:
+        struct Shard {
+            mutable std::mutex mutex_;
+            TimeCache<K, V> cache_;
+        };
+
+        [[nodiscard]] Shard &shard(const K &key) const {
+            return *(shards_[hash_(key) % shards_.size()]);
+        }
+
+        // run fn on a shard under its lock, keeping the totals up to date.
+        template <typename F> auto update(Shard &s, F &&fn) {
+            std::lock_guard<std::mutex> l(s.mutex_);
+            const size_t size  = s.cache_.size();
+            const size_t count = s.cache_.count();
+            struct Totals {
+                ShardedTimeCache &c_;
+                Shard &s_;
+                size_t size_, count_;
+                ~Totals() {
+                    c_.size_ += s_.cache_.size() - size_;
+                    c_.count_ += s_.cache_.count() - count_;
+                }
+            } totals{*this, s, size, count};
+            return fn(s.cache_);
+        }
+
+        // release entries until there is room for count more entries of size,
+        // taking the one rank puts highest across all the shards each time.
+        bool make_room_by(
+            const size_t size,
+            const size_t count,
+            const std::function<long int(TimeCache<K, V> &, const time_point &)> &rank,
+            const std::function<bool(TimeCache<K, V> &, const time_point &)> &release);
+        bool make_room(
+            const size_t size,
+            const size_t count,
+            const time_point &time,
+            const bool force_eviction);
+        bool make_room(const size_t size, const time_point &out_of_date_time);
+
+        void record_changes(const std::vector<K> &stored, const std::vector<K> &erased);
+
+        std::vector<std::unique_ptr<Shard>> shards_;
+        Hash hash_;
+        std::atomic<size_t> max_size_;
+        std::atomic<size_t> max_count_;
+        std::atomic<size_t> size_  = {0};
+        std::atomic<size_t> count_ = {0};
+
+        std::mutex changes_mutex_;
+        std::function<void()> change_callback_;
+        std::set<K> stored_keys_;
+        std::set<K> erased_keys_;
+    };
+
+    template <typename K, typename V, typename Hash>
+    ShardedTimeCache<K, V, Hash>::ShardedTimeCache(
+        const size_t shard_count, const size_t max_size, const size_t max_count)
+        : max_size_(max_size), max_count_(max_count) {
+        for (size_t i = 0; i < std::max(size_t(1), shard_count); i++)
+            shards_.emplace_back(std::make_unique<Shard>());
+
+        // the shards have no limits of their own, we make room across them all
+        for (auto &s : shards_) {
+            s->cache_.bind_change_callback(
+                [this](const std::vector<K> &stored, const std::vector<K> &erased) {
+                    record_changes(stored, erased);
+                });
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    void ShardedTimeCache<K, V, Hash>::record_changes(
+        const std::vector<K> &stored, const std::vector<K> &erased) {
+        std::function<void()> notify;
+        {
+            std::lock_guard<std::mutex> l(changes_mutex_);
+            const bool was_empty = stored_keys_.empty() and erased_keys_.empty();
+
+            for (const auto &i : stored) {
+                stored_keys_.insert(i);
+                erased_keys_.erase(i);
+            }
+
+            for (const auto &i : erased) {
+                stored_keys_.erase(i);
+                erased_keys_.insert(i);
+            }
+
+            if (was_empty and (not stored_keys_.empty() or not erased_keys_.empty()))
+                notify = change_callback_;
+        }
+
+        if (notify)
+            notify();
+    }
+
+    template <typename K, typename V, typename Hash>
+    void
+    ShardedTimeCache<K, V, Hash>::take_changes(std::vector<K> &stored, std::vector<K> &erased) {
+        std::lock_guard<std::mutex> l(changes_mutex_);
+        stored = std::vector<K>(stored_keys_.begin(), stored_keys_.end());
+        erased = std::vector<K>(erased_keys_.begin(), erased_keys_.end());
+        stored_keys_.clear();
+        erased_keys_.clear();
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::store(
+        const K &key,
+        V value,
+        const time_point &time,
+        const bool force_eviction,
+        const utility::Uuid &uuid) {
+        auto &s = shard(key);
+        {
+            std::lock_guard<std::mutex> l(s.mutex_);
+            if (s.cache_.contains(key))
+                return s.cache_.store(key, value, time, force_eviction, uuid);
+        }
+
+        if (not make_room(value ? value->size() : 0, 1, time, force_eviction))
+            return false;
+        return update(s, [&](auto &c) { return c.store(key, value, time, force_eviction, uuid); });
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::store(
+        const K &key,
+        V value,
+        const time_point &time,
+        const utility::Uuid &uuid,
+        const time_point &out_of_date_time) {
+        auto &s = shard(key);
+        {
+            std::lock_guard<std::mutex> l(s.mutex_);
+            if (s.cache_.contains(key))
+                return s.cache_.store(key, value, time, uuid, out_of_date_time);
+        }
+
+        if (not make_room(value ? value->size() : 0, out_of_date_time))
+            return false;
+        return update(
+            s, [&](auto &c) { return c.store(key, value, time, uuid, out_of_date_time); });
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::make_room_by(
+        const size_t size,
+        const size_t count,
+        const std::function<long int(TimeCache<K, V> &, const time_point &)> &rank,
+        const std::function<bool(TimeCache<K, V> &, const time_point &)> &release) {
+        const size_t max_size       = max_size_;
+        const size_t max_count      = max_count_;
+        const size_t required_size  = max_size > size ? max_size - size : 0;
+        const size_t required_count = max_count > count ? max_count - count : 0;
+
+        while (size_ > required_size or count_ > required_count) {
+            // the shard holding the entry that should go first. Shards are
+            // looked at one at a time, so this can be out by whatever other
+            // threads change meanwhile.
+            const auto now = utility::clock::now();
+            Shard *victim  = nullptr;
+            long int best  = std::numeric_limits<long int>::min();
+            for (auto &s : shards_) {
+                std::lock_guard<std::mutex> l(s->mutex_);
+                if (not s->cache_.count())
+                    continue;
+                const auto r = rank(s->cache_, now);
+                if (not victim or r > best) {
+                    victim = s.get();
+                    best   = r;
+                }
+            }
+
+            if (not victim or not update(*victim, [&](auto &c) { return release(c, now); }))
+                return false;
+        }
+        return true;
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::make_room(
+        const size_t size,
+        const size_t count,
+        const time_point &time,
+        const bool force_eviction) {
+        return make_room_by(
+            size,
+            count,
+            [](TimeCache<K, V> &c, const time_point &now) { return c.release_offset(now); },
+            [&](TimeCache<K, V> &c, const time_point &now) {
+                return bool(c.release(now, time, force_eviction));
+            });
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::make_room(
+        const size_t size, const time_point &out_of_date_time) {
+        // the entry wanted longest ago goes first
+        return make_room_by(
+            size,
+            1,
+            [](TimeCache<K, V> &c, const time_point &now) -> long int {
+                const auto tp = c.out_of_date_candidate();
+                if (tp == time_point::min())
+                    return std::numeric_limits<long int>::max();
+                return std::chrono::duration_cast<std::chrono::microseconds>(now - tp).count();
+            },
+            [&](TimeCache<K, V> &c, const time_point &) {
+                return bool(c.release_out_of_date(out_of_date_time));
+            });
+    }
+
+    template <typename K, typename V, typename Hash>
+    V ShardedTimeCache<K, V, Hash>::retrieve(
+        const K &key, const time_point &time, const utility::Uuid &uuid) {
+        auto &s = shard(key);
+        std::lock_guard<std::mutex> l(s.mutex_);
+        return s.cache_.retrieve(key, time, uuid);
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::preserve(
+        const K &key, const time_point &time, const utility::Uuid &uuid) {
+        auto &s = shard(key);
+        std::lock_guard<std::mutex> l(s.mutex_);
+        return s.cache_.preserve(key, time, uuid);
+    }
+
+    template <typename K, typename V, typename Hash>
+    void ShardedTimeCache<K, V, Hash>::make_entries_hot(
+        const std::vector<std::pair<media::MediaKey, utility::time_point>>
+            &keys_and_timepoints) {
+        if (keys_and_timepoints.empty())
+            return;
+
+        // TimeCache shifts everything relative to the first entry, so each shard
+        // gets the overall first entry at the front of its list.
+        std::vector<std::vector<std::pair<media::MediaKey, utility::time_point>>> per_shard(
+            shards_.size(),
+            std::vector<std::pair<media::MediaKey, utility::time_point>>(
+                {keys_and_timepoints.front()}));
+
+        for (const auto &i : keys_and_timepoints)
+            per_shard[hash_(i.first) % shards_.size()].push_back(i);
+
+        for (size_t i = 0; i < shards_.size(); i++) {
+            if (per_shard[i].size() > 1) {
+                std::lock_guard<std::mutex> l(shards_[i]->mutex_);
+                shards_[i]->cache_.make_entries_hot(per_shard[i]);
+            }
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    void ShardedTimeCache<K, V, Hash>::unpreserve(const utility::Uuid &uuid) {
+        for (auto &s : shards_) {
+            std::lock_guard<std::mutex> l(s->mutex_);
+            s->cache_.unpreserve(uuid);
+        }
+    }
+
+    template <typename K, typename V, typename Hash> void ShardedTimeCache<K, V, Hash>::clear() {
+        for (auto &s : shards_)
+            update(*s, [](auto &c) { c.clear(); });
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::erase(const K &key) {
+        return update(shard(key), [&](auto &c) { return c.erase(key); });
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::erase(const utility::Uuid &uuid) {
+        bool result = false;
+        for (auto &s : shards_) {
+            if (update(*s, [&](auto &c) { return c.erase(uuid); }))
+                result = true;
+        }
+        return result;
+    }
+
+    template <typename K, typename V, typename Hash>
+    bool ShardedTimeCache<K, V, Hash>::erase(const K &key, const utility::Uuid &uuid) {
+        return update(shard(key), [&](auto &c) { return c.erase(key, uuid); });
+    }
+
+    template <typename K, typename V, typename Hash>
+    std::vector<K> ShardedTimeCache<K, V, Hash>::erase(const std::vector<K> &keys) {
+        std::vector<K> result;
+        for (const auto &i : keys) {
+            if (erase(i))
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    template <typename K, typename V, typename Hash>
+    std::vector<K> ShardedTimeCache<K, V, Hash>::keys() const {
+        std::vector<K> result;
+        for (const auto &s : shards_) {
+            std::lock_guard<std::mutex> l(s->mutex_);
+            const auto k = s->cache_.keys();
+            result.insert(result.end(), k.begin(), k.end());
+        }
+        return result;
+    }
+
+    template <typename K, typename V, typename Hash>
+    void ShardedTimeCache<K, V, Hash>::set_max_size(const size_t max_size) {
+        max_size_ = max_size;
+        make_room(0, 0, utility::clock::now(), true);
+    }
+
+    template <typename K, typename V, typename Hash>
+    void ShardedTimeCache<K, V, Hash>::set_max_count(const size_t max_count) {
+        max_count_ = max_count;
+        make_room(0, 0, utility::clock::now(), true);
+    }
+
+} // namespace utility
+} // namespace xstudio
@@ -87,6 +87,13 @@ namespace utility {
 
         V release_out_of_date(const time_point &out_of_date_time = utility::clock::now());
 
+        // How far from ntp the entry release() would take next is, or -1 if
+        // empty. Caches that share one budget use it to agree on which goes first.
+        long int release_offset(const time_point &ntp = utility::clock::now());
+        // the latest time point of the entry release_out_of_date() would take
+        // next, or time_point::max() if empty.
+        [[nodiscard]] time_point out_of_date_candidate() const;
+
         V reuse(
             const size_t min_size,
             const time_point &ntp     = utility::clock::now(),
@@ -113,6 +120,7 @@ namespace utility {
 
         [[nodiscard]] size_t size() const { return size_; }
         [[nodiscard]] size_t count() const { return count_; }
+        [[nodiscard]] bool contains(const K &key) const { return cache_.count(key) != 0; }
 
         [[nodiscard]] size_t max_size() const { return max_size_; }
         [[nodiscard]] size_t max_count() const { return max_count_; }
@@ -150,9 +158,53 @@ namespace utility {
                 change_callback_(store, erase);
         }
 
+        // called with entries pushed out of the cache to make room, not ones
+        // that are explicitly erased.
+        void bind_eviction_callback(std::function<void(const K &key, const V &value)> fn) {
+            eviction_callback_ = std::move(fn);
+        }
+
       private:
+        // Eviction index. Each entry is filed under the time point nearest to the
+        // last evaluated 'now', either in nearest_behind_ (keyed by its closest past
+        // time point) or nearest_ahead_ (keyed by its closest future time point), so
+        // the entry furthest from 'now' is always at one end of one of those sets.
+        // As 'now' advances an entry's nearest time point changes, index_events_
+        // holds the time at which that next happens so the entry can be refiled.
+        using index_entry_type = std::pair<time_point, K>;
+
+        struct EarliestFirst {
+            bool operator()(const index_entry_type &a, const index_entry_type &b) const {
+                if (a.first != b.first)
+                    return a.first < b.first;
+                return b.second < a.second;
+            }
+        };
+
+        struct IndexSlot {
+            bool behind{true};
+            time_point nearest;
+            time_point event;
+            time_point latest;
+        };
+
+        long int release_candidate(const time_point &ntp, K &key);
+
+        void index_entry(const K &key);
+        void unindex_entry(const K &key);
+        void reindex_entry(const K &key);
+        void advance_index(const time_point &now);
+
+        std::map<K, IndexSlot> index_slots_;
+        std::set<index_entry_type, EarliestFirst> nearest_behind_;
+        std::set<index_entry_type> nearest_ahead_;
+        std::set<index_entry_type> index_events_;
+        std::set<index_entry_type> latest_timepoints_;
+        time_point index_now_{utility::clock::now()};
+
         std::function<void(const std::vector<K> &store, const std::vector<K> &erase)>
             change_callback_;
+        std::function<void(const K &key, const V &value)> eviction_callback_;
 
         void clean_timepoints(const K &key);
         void add_timepoint_reference(
@@ -187,6 +239,95 @@ namespace utility {
             timepoint_cache_[key].insert(time);
         else
             timepoint_cache_[key] = std::set<time_point>{time};
+        reindex_entry(key);
+    }
+
+    template <typename K, typename V> void TimeCache<K, V>::index_entry(const K &key) {
+        IndexSlot slot;
+        const auto &tps = timepoint_cache_[key];
+
+        if (tps.empty()) {
+            // nothing references it, it goes first.
+            slot.nearest = time_point::min();
+            slot.event   = time_point::max();
+            slot.latest  = time_point::min();
+        } else {
+            const auto next = tps.upper_bound(index_now_);
+            slot.latest     = *(tps.rbegin());
+
+            if (next == std::begin(tps)) {
+                slot.behind  = false;
+                slot.nearest = *next;
+                slot.event   = *next;
+            } else if (next == std::end(tps)) {
+                slot.nearest = *std::prev(next);
+                slot.event   = time_point::max();
+            } else {
+                // straddles now, nearest is the past time point until we pass the
+                // midpoint between it and the next one.
+                const auto last = *std::prev(next);
+                const auto mid  = last + (*next - last) / 2;
+                if (index_now_ <= mid) {
+                    slot.nearest = last;
+                    slot.event   = mid + time_point::duration(1);
+                } else {
+                    slot.behind  = false;
+                    slot.nearest = *next;
+                    slot.event   = *next;
+                }
+            }
+        }
+
+        if (slot.behind)
+            nearest_behind_.emplace(slot.nearest, key);
+        else
+            nearest_ahead_.emplace(slot.nearest, key);
+
+        if (slot.event != time_point::max())
+            index_events_.emplace(slot.event, key);
+
+        latest_timepoints_.emplace(slot.latest, key);
+        index_slots_[key] = slot;
+    }
+
+    template <typename K, typename V> void TimeCache<K, V>::unindex_entry(const K &key) {
+        const auto it = index_slots_.find(key);
+        if (it == std::end(index_slots_))
+            return;
+
+        const auto &slot = it->second;
+        if (slot.behind)
+            nearest_behind_.erase(index_entry_type(slot.nearest, key));
+        else
+            nearest_ahead_.erase(index_entry_type(slot.nearest, key));
+
+        if (slot.event != time_point::max())
+            index_events_.erase(index_entry_type(slot.event, key));
+
+        latest_timepoints_.erase(index_entry_type(slot.latest, key));
+        index_slots_.erase(it);
+    }
+
+    template <typename K, typename V> void TimeCache<K, V>::reindex_entry(const K &key) {
+        unindex_entry(key);
+        index_entry(key);
+    }
+
+    template <typename K, typename V>
+    void TimeCache<K, V>::advance_index(const time_point &now) {
+        if (now < index_now_) {
+            // time went backwards, refile everything.
+            index_now_ = now;
+            for (const auto &i : timepoint_cache_)
+                reindex_entry(i.first);
+            return;
+        }
+
+        index_now_ = now;
+        while (not index_events_.empty() and index_events_.begin()->first <= now) {
+            const K key = index_events_.begin()->second;
+            reindex_entry(key);
+        }
     }
 
     template <typename K, typename V>
@@ -348,6 +489,11 @@ namespace utility {
         cache_.clear();
         uuid_cache_.clear();
         timepoint_cache_.clear();
+        index_slots_.clear();
+        nearest_behind_.clear();
+        nearest_ahead_.clear();
+        index_events_.clear();
+        latest_timepoints_.clear();
         count_ = 0;
         size_  = 0;
     }
@@ -395,6 +541,7 @@ namespace utility {
         if (it->second)
             size_ -= it->second->size();
         count_--;
+        unindex_entry(it->first);
         uuid_cache_.erase(uuid_cache_.find(it->first));
         timepoint_cache_.erase(timepoint_cache_.find(it->first));
         call_change_callback({}, {it->first});
@@ -427,44 +574,72 @@ namespace utility {
         if (cache_.empty())
             return ptr;
 
-        // release in special time order..
-        long int max_offset(0);
         K key;
+        const long int min_offset = release_candidate(ntp, key);
+        long int max_offset(0);
 
         // set to our proposed time, if we're bigger than every chache entry we fail.
         if (not force_eviction)
             max_offset = std::abs(
                 std::chrono::duration_cast<std::chrono::microseconds>(ntp - newtp).count());
 
-        for (const auto &i : timepoint_cache_) {
-            long int min_offset(std::numeric_limits<long int>::max());
-
-            // calculate offset in time from now,
-            for (const auto &tp : i.second) {
-                long int offset = std::abs(
-                    std::chrono::duration_cast<std::chrono::microseconds>(ntp - tp).count());
-                if (min_offset > offset)
-                    min_offset = offset;
+        if (min_offset >= max_offset) {
+            auto it = cache_.find(key);
+            if (it != cache_.end()) {
+                ptr = it->second;
+                if (eviction_callback_)
+                    eviction_callback_(it->first, ptr);
+                erase(it);
             }
+        }
+        return ptr;
+    }
 
-            if (min_offset >= max_offset) {
-                max_offset = min_offset;
-                key        = i.first;
-            }
+    // release in special time order..
+    // the entry whose nearest time point is furthest from now goes first.
+    template <typename K, typename V>
+    long int TimeCache<K, V>::release_candidate(const time_point &ntp, K &key) {
+        advance_index(ntp);
+
+        const auto offset = [&ntp](const time_point &tp) -> long int {
+            if (tp == time_point::min())
+                return std::numeric_limits<long int>::max();
+            return std::abs(
+                std::chrono::duration_cast<std::chrono::microseconds>(ntp - tp).count());
+        };
+
+        long int min_offset(-1);
+
+        if (not nearest_behind_.empty()) {
+            min_offset = offset(nearest_behind_.begin()->first);
+            key        = nearest_behind_.begin()->second;
         }
-        // valid key ?
-        auto it = cache_.find(key);
-        if (it != cache_.end()) {
-            ptr                 = it->second;
-            const auto &old_tps = timepoint_cache_[key];
-            auto ms             = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          utility::clock::now() - *(old_tps.begin()))
-                          .count();
-            erase(it);
-            // spdlog::debug("Release buffer {} which has timestamp {} milliseconds from
-            // now", key, ms);
+
+        if (not nearest_ahead_.empty()) {
+            const auto &candidate       = *(nearest_ahead_.rbegin());
+            const auto candidate_offset = offset(candidate.first);
+            if (candidate_offset > min_offset or
+                (candidate_offset == min_offset and key < candidate.second)) {
+                min_offset = candidate_offset;
+                key        = candidate.second;
+            }
         }
-        return ptr;
+        return min_offset;
+    }
+
+    template <typename K, typename V>
+    long int TimeCache<K, V>::release_offset(const time_point &ntp) {
+        if (cache_.empty())
+            return -1;
+        K key;
+        return release_candidate(ntp, key);
+    }
+
+    template <typename K, typename V>
+    time_point TimeCache<K, V>::out_of_date_candidate() const {
+        if (cache_.empty() or latest_timepoints_.empty())
+            return time_point::max();
+        return latest_timepoints_.begin()->first;
     }
 
     // release the oldest item that is older than out_of_date_time
@@ -472,38 +647,22 @@ namespace utility {
     V TimeCache<K, V>::release_out_of_date(const time_point &out_of_date_time) {
 
         V ptr;
-        if (cache_.empty())
+        if (cache_.empty() or latest_timepoints_.empty())
             return ptr;
 
-        K key;
-
-        long int maxx = 0;
-        std::vector<time_point> bb;
-        for (const auto &i : timepoint_cache_) {
-
-            // calculate offset in time from now,
-            long int ctt = std::numeric_limits<long int>::max();
-            std::vector<time_point> cc;
-            for (const auto &tp : i.second) {
-                ctt = std::min(
-                    ctt,
-                    static_cast<long int>(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                              out_of_date_time - tp)
-                                              .count()));
-                cc.push_back(tp);
-            }
-            if (ctt > maxx) {
-                maxx = ctt;
-                key  = i.first;
-                bb   = cc;
+        // the entry whose most recent time point is oldest
+        const auto &oldest = *(latest_timepoints_.begin());
+        if (oldest.first == time_point::min() or
+            std::chrono::duration_cast<std::chrono::milliseconds>(out_of_date_time - oldest.first)
+                    .count() > 0) {
+            auto it = cache_.find(oldest.second);
+            if (it != cache_.end()) {
+                ptr = it->second;
+                if (eviction_callback_)
+                    eviction_callback_(it->first, ptr);
+                erase(it);
             }
         }
-        // valid key ?
-        auto it = cache_.find(key);
-        if (it != cache_.end()) {
-            ptr = it->second;
-            erase(it);
-        }
         return ptr;
     }
 
@@ -572,6 +731,7 @@ namespace utility {
             auto it = cache_.find(key.first);
             if (it != std::end(cache_)) {
                 timepoint_cache_[key.first] = std::set<time_point>({key.second + delta});
+                reindex_entry(key.first);
             }
         }
     }
@@ -589,6 +749,7 @@ namespace utility {
                     ntp.insert(tp - std::chrono::hours(1));
                 }
                 timepoint_cache_[it->first] = ntp;
+                reindex_entry(it->first);
             }
             it++;
         }
@@ -597,19 +758,14 @@ namespace utility {
     // remove timepoints older than now, but keep the most recent of these.
     template <typename K, typename V> void TimeCache<K, V>::clean_timepoints(const K &key) {
         const time_point now = utility::clock::now();
-        time_point newest;
-
-        for (auto i = std::begin(timepoint_cache_[key]);
-             i != std::end(timepoint_cache_[key]);) {
-            if (*i < now) {
-                if (*i > newest)
-                    newest = *i;
-                i = timepoint_cache_[key].erase(i);
-            } else
-                ++i;
-        }
-        if (newest != time_point())
-            timepoint_cache_[key].insert(newest);
+        auto &tps            = timepoint_cache_[key];
+
+        // set is ordered, keep the last one before now.
+        auto last_past = tps.lower_bound(now);
+        if (last_past != std::begin(tps))
+            tps.erase(std::begin(tps), std::prev(last_past));
+
+        reindex_entry(key);
     }
 } // namespace utility
 } // namespace xstudio
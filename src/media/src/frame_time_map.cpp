@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "xstudio/media/media.hpp"
+
+using namespace xstudio;
+using namespace xstudio::media;
+
+namespace {
+
+// can frame be made from first, the first frame of a run, by changing only
+// what changes per frame
+bool same_run(const AVFrameID *first, const AVFrameID *frame) {
+    if (not first or not frame)
+        return not first and not frame;
+
+    return first->rate_ == frame->rate_ and first->first_frame_ == frame->first_frame_ and
+           first->media_type_ == frame->media_type_ and
+           first->actor_addr_ == frame->actor_addr_ and
+           first->source_uuid_ == frame->source_uuid_ and
+           first->media_uuid_ == frame->media_uuid_ and first->stream_id_ == frame->stream_id_ and
+           first->reader_ == frame->reader_ and first->error_ == frame->error_ and
+           first->params_ == frame->params_;
+}
+
+timebase::flicks::rep to_rep(const size_t n) { return static_cast<timebase::flicks::rep>(n); }
+
+} // namespace
+
+AVFrameIDSpan::AVFrameIDSpan(std::shared_ptr<const AVFrameID> first) : first_(std::move(first)) {
+    if (first_)
+        frames_.push_back(Frame{first_->frame_, first_->uri_, first_->key_});
+    else
+        frames_.push_back(Frame{std::numeric_limits<int>::min(), caf::uri(), MediaKey()});
+}
+
+bool AVFrameIDSpan::push_back(const std::shared_ptr<const AVFrameID> &frame) {
+    if (frames_.empty()) {
+        *this = AVFrameIDSpan(frame);
+        return true;
+    }
+
+    if (not same_run(first_.get(), frame.get()) or
+        (frame and not(frame->timecode_ == first_->timecode_)))
+        return false;
+
+    if (frame)
+        frames_.push_back(Frame{frame->frame_, frame->uri_, frame->key_});
+    else
+        frames_.push_back(Frame{std::numeric_limits<int>::min(), caf::uri(), MediaKey()});
+    return true;
+}
+
+void AVFrameIDSpan::push_back(const int frame, const caf::uri &uri, const MediaKey &key) {
+    frames_.push_back(Frame{frame, uri, key});
+}
+
+std::shared_ptr<const AVFrameID> AVFrameIDSpan::frame(const size_t index) const {
+    if (not first_ or not index)
+        return first_;
+
+    const auto &f  = frames_[index];
+    auto result    = std::make_shared<AVFrameID>(*first_);
+    result->uri_   = f.uri_;
+    result->frame_ = f.frame_;
+    result->key_   = f.key_;
+    return result;
+}
+
+AVFrameIDSpans xstudio::media::make_spans(const AVFrameIDs &frames) {
+    AVFrameIDSpans result;
+    for (const auto &frame : frames) {
+        if (result.empty() or not result.back().push_back(frame))
+            result.emplace_back(frame);
+    }
+    return result;
+}
+
+size_t xstudio::media::span_frames(const AVFrameIDSpans &spans) {
+    size_t result = 0;
+    for (const auto &span : spans)
+        result += span.size();
+    return result;
+}
+
+void FrameTimeMap::push_back(
+    const timebase::flicks time,
+    const std::shared_ptr<const AVFrameID> &frame,
+    const std::optional<utility::Timecode> &timecode) {
+
+    const auto tc = timecode ? *timecode : (frame ? frame->timecode_ : utility::Timecode());
+    add(frame.get(),
+        frame ? Frame{time, 0, frame->frame_, frame->uri_, frame->key_}
+              : Frame{time, 0, std::numeric_limits<int>::min(), caf::uri(), MediaKey()},
+        tc);
+}
+
+void FrameTimeMap::push_back(
+    const timebase::flicks time,
+    const AVFrameIDSpan &span,
+    const size_t index,
+    const std::optional<utility::Timecode> &timecode) {
+
+    const auto like = span.first_.get();
+    const auto &f   = span.frames_[index];
+    const auto tc   = timecode ? *timecode : (like ? like->timecode_ : utility::Timecode());
+    add(like, Frame{time, 0, f.frame_, f.uri_, f.key_}, tc);
+}
+
+void FrameTimeMap::push_back(
+    const timebase::flicks time,
+    const timebase::flicks period,
+    const AVFrameIDSpan &span,
+    const std::optional<utility::Timecode> &timecode) {
+
+    for (size_t i = 0; i < span.size(); i++) {
+        push_back(
+            time + period * to_rep(i),
+            span,
+            i,
+            timecode ? std::optional<utility::Timecode>(*timecode + static_cast<int>(i))
+                     : std::nullopt);
+    }
+}
+
+void FrameTimeMap::add(
+    const AVFrameID *like, const Frame &data, const utility::Timecode &timecode) {
+
+    const auto &time = data.time_;
+
+    if (not runs_.empty()) {
+        auto &run         = runs_.back();
+        const auto offset = frames_.size() - run.index_;
+        const auto period = offset == 1 ? time - run.time_ : run.period_;
+
+        // timecodes either count up with the frames or stay put, frames
+        // without one all have the default
+        auto steps = run.timecode_steps_;
+        if (run.first_ and offset == 1)
+            steps = not(timecode == run.first_->timecode_);
+        const auto same_timecode =
+            not run.first_ or
+            (steps ? run.first_->timecode_ + static_cast<int>(offset) == timecode
+                   : run.first_->timecode_ == timecode);
+
+        if (period > timebase::flicks(0) and time == run.time_ + period * to_rep(offset) and
+            same_run(run.first_.get(), like) and same_timecode) {
+            run.period_         = period;
+            run.timecode_steps_ = steps;
+            frames_.push_back(data);
+            frames_.back().run_ = static_cast<uint32_t>(runs_.size() - 1);
+            return;
+        }
+    }
+
+    auto first = std::shared_ptr<const AVFrameID>();
+    if (like) {
+        auto f                     = std::make_shared<AVFrameID>(*like);
+        f->uri_                    = data.uri_;
+        f->frame_                  = data.frame_;
+        f->key_                    = data.key_;
+        f->timecode_               = timecode;
+        f->playhead_logical_frame_ = static_cast<int>(frames_.size());
+        first                      = f;
+    }
+
+    runs_.push_back(Run{frames_.size(), time, timebase::flicks(0), false, first});
+    frames_.push_back(data);
+    frames_.back().run_ = static_cast<uint32_t>(runs_.size() - 1);
+}
+
+void FrameTimeMap::append(
+    const FrameTimeMap &other,
+    const size_t first,
+    const size_t last,
+    const timebase::flicks shift) {
+
+    for (auto i = first; i < last; i++) {
+        const auto &r = other.run(i);
+        auto data     = other.frames_[i];
+        data.time_ += shift;
+
+        auto tc = r.first_ ? r.first_->timecode_ : utility::Timecode();
+        if (r.timecode_steps_)
+            tc = tc + static_cast<int>(i - r.index_);
+
+        add(r.first_.get(), data, tc);
+    }
+}
+
+void FrameTimeMap::splice(const size_t first, const size_t count, const FrameTimeMap &frames) {
+    // our last entry has to stay to mark the end
+    if (first + count >= size())
+        throw std::runtime_error("FrameTimeMap::splice range out of bounds");
+
+    const auto start    = time(first);
+    const auto removed  = time(first + count) - start;
+    const auto inserted = frames.empty() ? timebase::flicks(0)
+                                         : frames.time(frames.size() - 1) - frames.time(0);
+
+    // frames after the splice may now join the runs before it, so rebuild the
+    // runs as we go. Only the frames passed in had to be resolved.
+    FrameTimeMap result;
+    result.runs_.reserve(runs_.size());
+    result.frames_.reserve(size() - count + frames.size());
+
+    result.append(*this, 0, first, timebase::flicks(0));
+    if (not frames.empty())
+        result.append(frames, 0, frames.size() - 1, start - frames.time(0));
+    result.append(*this, first + count, size(), inserted - removed);
+
+    *this = std::move(result);
+}
+
+FrameTimeMap::const_iterator FrameTimeMap::lower_bound(const timebase::flicks time) const {
+    auto i = std::lower_bound(
+        frames_.begin(), frames_.end(), time, [](const Frame &frame, const timebase::flicks t) {
+            return frame.time_ < t;
+        });
+    return const_iterator(this, static_cast<size_t>(i - frames_.begin()));
+}
+
+FrameTimeMap::const_iterator FrameTimeMap::upper_bound(const timebase::flicks time) const {
+    auto i = std::upper_bound(
+        frames_.begin(), frames_.end(), time, [](const timebase::flicks t, const Frame &frame) {
+            return t < frame.time_;
+        });
+    return const_iterator(this, static_cast<size_t>(i - frames_.begin()));
+}
+
+FrameTimeMap::const_iterator
+FrameTimeMap::upper_bound(const timebase::flicks time, const const_iterator &hint) const {
+    auto i = hint.index_;
+    if (hint.map_ == this and i < frames_.size() and frames_[i].time_ <= time) {
+        for (const auto end = std::min(i + 3, frames_.size()); i < end; i++) {
+            if (frames_[i].time_ > time)
+                return const_iterator(this, i);
+        }
+    }
+    return upper_bound(time);
+}
+
+FrameTimeMap::const_iterator FrameTimeMap::find(const timebase::flicks time) const {
+    auto i = lower_bound(time);
+    if (i != end() and i.time() != time)
+        return end();
+    return i;
+}
+
+std::shared_ptr<const AVFrameID> FrameTimeMap::frame(const size_t index) const {
+    const auto &r = run(index);
+    if (not r.first_)
+        return {};
+
+    const auto offset = index - r.index_;
+    if (not offset)
+        return r.first_;
+
+    const auto &f                   = frames_[index];
+    auto result                     = std::make_shared<AVFrameID>(*(r.first_));
+    result->uri_                    = f.uri_;
+    result->frame_                  = f.frame_;
+    result->key_                    = f.key_;
+    result->playhead_logical_frame_ = static_cast<int>(index);
+    if (r.timecode_steps_)
+        result->timecode_ = r.first_->timecode_ + static_cast<int>(offset);
+    return result;
+}
@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <iostream>
+#include <map>
+#include <mutex>
 
 #include "xstudio/media/media.hpp"
 #include "xstudio/utility/json_store.hpp"
@@ -7,6 +9,25 @@
 using namespace xstudio::media;
 using namespace xstudio::utility;
 
+namespace {
+std::mutex media_key_names_mutex;
+std::map<std::pair<uint64_t, uint64_t>, std::string> media_key_names;
+} // namespace
+
+void MediaKey::intern_name(const std::string &name) const {
+    std::lock_guard<std::mutex> l(media_key_names_mutex);
+    media_key_names.emplace(std::make_pair(hi_, lo_), name);
+}
+
+std::string MediaKey::name() const {
+    {
+        std::lock_guard<std::mutex> l(media_key_names_mutex);
+        auto p = media_key_names.find(std::make_pair(hi_, lo_));
+        if (p != media_key_names.end())
+            return p->second;
+    }
+    return to_string(*this);
+}
 
 Media::Media(const JsonStore &jsn)
     : Container(static_cast<utility::JsonStore>(jsn["container"])) {
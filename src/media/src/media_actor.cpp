@@ -444,11 +444,11 @@ void MediaActor::init() {
         [=](get_media_pointers_atom atom,
             const MediaType media_type,
             const LogicalFrameRanges &ranges,
-            const FrameRate &override_rate) -> caf::result<media::AVFrameIDs> {
+            const FrameRate &override_rate) -> caf::result<media::AVFrameIDSpans> {
             if (base_.empty() or not media_sources_.count(base_.current(media_type)))
                 return make_error(xstudio_error::error, "No MediaSources");
 
-            auto rp = make_response_promise<media::AVFrameIDs>();
+            auto rp = make_response_promise<media::AVFrameIDSpans>();
             // we need to ensure the media detail has been acquired before
             // we can deliver AVFrameIDs
             request(
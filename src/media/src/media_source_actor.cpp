@@ -627,7 +627,7 @@ void MediaSourceActor::init() {
 
         [=](get_media_pointers_atom,
             const MediaType media_type,
-            const LogicalFrameRanges &ranges) -> caf::result<media::AVFrameIDs> {
+            const LogicalFrameRanges &ranges) -> caf::result<media::AVFrameIDSpans> {
             if (base_.empty()) {
                 if (base_.error_detail().empty()) {
                     return make_error(xstudio_error::error, "No MediaStreams");
@@ -636,7 +636,7 @@ void MediaSourceActor::init() {
                 }
             }
 
-            auto rp = make_response_promise<media::AVFrameIDs>();
+            auto rp = make_response_promise<media::AVFrameIDSpans>();
             get_media_pointers_for_frames(media_type, ranges, rp);
             return rp;
         },
@@ -1279,20 +1279,21 @@ void MediaSourceActor::send_stream_details_to_ui(caf::actor ui_actor) {
 void MediaSourceActor::get_media_pointers_for_frames(
     const MediaType media_type,
     const LogicalFrameRanges &ranges,
-    caf::typed_response_promise<media::AVFrameIDs> rp) {
+    caf::typed_response_promise<media::AVFrameIDSpans> rp) {
     if (base_.current(media_type).is_null()) {
         // in the case where there is no source, return list of empty frames.
         // This is useful for sources that have no audio or no video, to keep
         // them compatible with the video based frame request/deliver playback
         // system
-        media::AVFrameIDs result;
+        auto blank_frame = media::make_blank_frame(media_type);
+        media::AVFrameIDSpans result;
         for (const auto &i : ranges) {
-            for (auto ii = i.first; ii <= i.second; ii++)
-                result.emplace_back(media::make_blank_frame(media_type)
-                                    // std::shared_ptr<const media::AVFrameID>(
-                                    //     new media::AVFrameID()
-                                    //     )
-                );
+            for (auto ii = i.first; ii <= i.second; ii++) {
+                if (result.empty())
+                    result.emplace_back(blank_frame);
+                else
+                    result.back().push_back(blank_frame);
+            }
         }
         rp.deliver(result);
         return;
@@ -1308,8 +1309,12 @@ void MediaSourceActor::get_media_pointers_for_frames(
                     get_stream_detail_atom_v)
                     .then(
                         [=](const StreamDetail &detail) mutable {
-                            media::AVFrameIDs result;
+                            // our frames only differ in their frame number, uri
+                            // and key, so they go in one span unless frames we
+                            // can't find break it up
+                            media::AVFrameIDSpans result;
                             media::AVFrameID mptr;
+                            bool in_span = false;
 
                             for (const auto &i : ranges) {
                                 for (auto logical_frame = i.first; logical_frame <= i.second;
@@ -1325,6 +1330,9 @@ void MediaSourceActor::get_media_pointers_for_frames(
                                         if (not _uri)
                                             throw std::runtime_error("Time out of range");
 
+                                        const auto key = media::MediaKey(
+                                            detail.key_format_, *_uri, frame, detail.name_);
+
                                         if (mptr.is_nil()) {
                                             mptr = media::AVFrameID(
                                                 *_uri,
@@ -1339,19 +1347,25 @@ void MediaSourceActor::get_media_pointers_for_frames(
                                                 base_.current(media_type),
                                                 parent_uuid_,
                                                 media_type);
+                                        }
+
+                                        if (in_span) {
+                                            result.back().push_back(frame, *_uri, key);
                                         } else {
                                             mptr.uri_   = *_uri;
                                             mptr.frame_ = frame;
-                                            mptr.key_   = media::MediaKey(
-                                                detail.key_format_, *_uri, frame, detail.name_);
+                                            mptr.key_   = key;
+                                            result.emplace_back(
+                                                std::make_shared<const media::AVFrameID>(mptr));
+                                            in_span = true;
                                         }
-
-                                        result.emplace_back(
-                                            std::shared_ptr<const media::AVFrameID>(
-                                                new media::AVFrameID(mptr)));
                                     } catch (const std::exception &e) {
-                                        result.emplace_back(
-                                            media::make_blank_frame(media_type));
+                                        auto blank_frame = media::make_blank_frame(media_type);
+                                        if (in_span or result.empty())
+                                            result.emplace_back(blank_frame);
+                                        else
+                                            result.back().push_back(blank_frame);
+                                        in_span = false;
                                     }
                                 }
                             }
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <gtest/gtest.h>
+#include <map>
+
+#include "xstudio/media/media.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace xstudio;
+using namespace xstudio::utility;
+using namespace xstudio::media;
+
+namespace {
+
+std::shared_ptr<const AVFrameID>
+make_frame(const Uuid &media_uuid, const int frame, const bool sequence = true) {
+    const auto path = sequence ? fmt::format("file:///tmp/test.{:04d}.exr", frame)
+                               : std::string("file:///tmp/test.mov");
+    return std::make_shared<const AVFrameID>(
+        *caf::make_uri(path),
+        frame,
+        1001,
+        FrameRate(timebase::k_flicks_24fps),
+        "Main",
+        "{0}@{1}/{2}",
+        "OpenEXR",
+        caf::actor_addr(),
+        JsonStore(R"({"colour": "params"})"_json),
+        Uuid(),
+        media_uuid);
+}
+
+} // namespace
+
+TEST(FrameTimeMapTest, MatchesMap) {
+    FrameTimeMap frames;
+    std::map<timebase::flicks, std::shared_ptr<const AVFrameID>> expected;
+
+    const auto a = Uuid::generate();
+    const auto b = Uuid::generate();
+
+    auto t = timebase::flicks(0);
+    auto add = [&](const std::shared_ptr<const AVFrameID> &frame, const timebase::flicks d) {
+        frames.push_back(t, frame);
+        expected[t] = frame;
+        t += d;
+    };
+
+    // a sequence, a movie at a different rate, a blank and a single frame
+    for (auto i = 1001; i < 1011; i++)
+        add(make_frame(a, i), timebase::k_flicks_24fps);
+    for (auto i = 0; i < 5; i++)
+        add(make_frame(b, i, false), timebase::k_flicks_25fps);
+    add(make_blank_frame(MT_IMAGE), timebase::k_flicks_24fps);
+    add(make_frame(a, 1001), timebase::k_flicks_24fps);
+    frames.push_back(t, nullptr);
+    expected[t] = nullptr;
+
+    EXPECT_EQ(frames.size(), expected.size());
+    EXPECT_EQ(frames.runs(), 5u);
+
+    auto frame = frames.begin();
+    for (const auto &[time, mptr] : expected) {
+        EXPECT_EQ(frame.time(), time);
+        auto f = frame.frame();
+        EXPECT_EQ(static_cast<bool>(f), static_cast<bool>(mptr));
+        if (f and mptr) {
+            EXPECT_EQ(f->uri_, mptr->uri_);
+            EXPECT_EQ(f->frame_, mptr->frame_);
+            EXPECT_EQ(f->key_, mptr->key_);
+            EXPECT_EQ(f->media_uuid_, mptr->media_uuid_);
+            EXPECT_EQ(f->params_, mptr->params_);
+            EXPECT_EQ(f->playhead_logical_frame_, static_cast<int>(frame.index()));
+            EXPECT_EQ(frame.key(), mptr->key_);
+            EXPECT_EQ(frame.media_frame(), mptr->frame_);
+            EXPECT_EQ(frame.shared()->media_uuid_, mptr->media_uuid_);
+        }
+        frame++;
+    }
+    EXPECT_EQ(frame, frames.end());
+
+    // look ups either side of every frame
+    for (const auto &i : expected) {
+        for (const auto time :
+             {i.first - timebase::flicks(1), i.first, i.first + timebase::flicks(1)}) {
+            EXPECT_EQ(
+                frames.upper_bound(time) - frames.begin(),
+                std::distance(expected.begin(), expected.upper_bound(time)));
+            EXPECT_EQ(
+                frames.lower_bound(time) - frames.begin(),
+                std::distance(expected.begin(), expected.lower_bound(time)));
+            EXPECT_EQ(frames.find(time) == frames.end(), expected.find(time) == expected.end());
+        }
+    }
+
+    // stepping on from the last look up, as a playhead does, then back to the start
+    auto hint = frames.begin();
+    for (const auto &i : expected) {
+        for (const auto time : {i.first, i.first + timebase::flicks(1), timebase::flicks(0)}) {
+            auto frame = frames.upper_bound(time, hint);
+            EXPECT_EQ(
+                frame - frames.begin(),
+                std::distance(expected.begin(), expected.upper_bound(time)));
+            hint = frame - 1;
+        }
+    }
+}
+
+TEST(FrameTimeMapTest, Timecode) {
+    FrameTimeMap frames;
+    const auto a  = Uuid::generate();
+    const auto tc = Timecode("01:00:00:00", 24.0);
+
+    for (auto i = 0; i < 10; i++)
+        frames.push_back(timebase::k_flicks_24fps * i, make_frame(a, 1001 + i), tc + i);
+
+    // a jump in timecode starts a new run
+    frames.push_back(timebase::k_flicks_24fps * 10, make_frame(a, 1011), tc);
+    frames.push_back(timebase::k_flicks_24fps * 11, nullptr);
+
+    EXPECT_EQ(frames.runs(), 3u);
+    EXPECT_EQ((frames.begin() + 5).frame()->timecode_, tc + 5);
+    EXPECT_EQ((frames.begin() + 10).frame()->timecode_, tc);
+}
+
+TEST(FrameTimeMapTest, Splice) {
+    // clips of 10, 5 and 8 frames, then the same with the middle one swapped
+    // for one of 3 frames at another rate
+    const auto a = Uuid::generate();
+    const auto b = Uuid::generate();
+    const auto c = Uuid::generate();
+    const auto d = Uuid::generate();
+
+    auto add = [](FrameTimeMap &frames,
+                  const Uuid &uuid,
+                  const int count,
+                  const timebase::flicks period,
+                  timebase::flicks &t) {
+        for (auto i = 0; i < count; i++, t += period)
+            frames.push_back(t, make_frame(uuid, i));
+    };
+
+    FrameTimeMap frames, expected, middle;
+    auto t = timebase::flicks(0);
+    add(frames, a, 10, timebase::k_flicks_24fps, t);
+    add(frames, b, 5, timebase::k_flicks_24fps, t);
+    add(frames, c, 8, timebase::k_flicks_24fps, t);
+    frames.push_back(t, nullptr);
+
+    t = timebase::flicks(0);
+    add(expected, a, 10, timebase::k_flicks_24fps, t);
+    auto m = t;
+    add(middle, d, 3, timebase::k_flicks_25fps, m);
+    middle.push_back(m, nullptr);
+    add(expected, d, 3, timebase::k_flicks_25fps, t);
+    add(expected, c, 8, timebase::k_flicks_24fps, t);
+    expected.push_back(t, nullptr);
+
+    frames.splice(10, 5, middle);
+
+    EXPECT_EQ(frames.size(), expected.size());
+    EXPECT_EQ(frames.runs(), expected.runs());
+    for (auto i = expected.begin(), j = frames.begin(); i != expected.end(); i++, j++) {
+        EXPECT_EQ(j.time(), i.time());
+        EXPECT_EQ(static_cast<bool>(j.frame()), static_cast<bool>(i.frame()));
+        if (i.frame()) {
+            EXPECT_EQ(j.key(), i.key());
+            EXPECT_EQ(j.frame()->media_uuid_, i.frame()->media_uuid_);
+            EXPECT_EQ(j.frame()->playhead_logical_frame_, i.frame()->playhead_logical_frame_);
+        }
+    }
+
+    // appending in front of the end marker, and the marker has to stay
+    FrameTimeMap more;
+    m = timebase::flicks(0);
+    add(more, c, 2, timebase::k_flicks_24fps, m);
+    more.push_back(m, nullptr);
+    frames.splice(frames.size() - 1, 0, more);
+    EXPECT_EQ(frames.size(), expected.size() + 2);
+    EXPECT_EQ((frames.end() - 1).time(), t + m);
+    EXPECT_THROW(frames.splice(0, frames.size(), more), std::runtime_error);
+}
+
+TEST(FrameTimeMapTest, Spans) {
+    // frames handed out as spans expand to the frames pushed one at a time
+    const auto a  = Uuid::generate();
+    const auto b  = Uuid::generate();
+    const auto tc = Timecode("01:00:00:00", 24.0);
+
+    AVFrameIDs mps;
+    for (auto i = 1001; i < 1011; i++)
+        mps.push_back(make_frame(a, i));
+    mps.push_back(make_blank_frame(MT_IMAGE));
+    mps.push_back(make_blank_frame(MT_IMAGE));
+    for (auto i = 0; i < 5; i++)
+        mps.push_back(make_frame(b, i, false));
+
+    const auto spans = make_spans(mps);
+    ASSERT_EQ(spans.size(), 3u);
+    EXPECT_EQ(span_frames(spans), mps.size());
+    EXPECT_EQ(spans[0].size(), 10u);
+    EXPECT_EQ(*spans[0].frame(3), *mps[3]);
+    EXPECT_EQ(*spans[2].frame(4), *mps[16]);
+
+    // a frame from another source doesn't join a span
+    auto span = AVFrameIDSpan(mps[0]);
+    EXPECT_FALSE(span.push_back(mps[12]));
+    EXPECT_TRUE(span.push_back(mps[1]));
+    EXPECT_EQ(span.size(), 2u);
+
+    FrameTimeMap frames, expected;
+    auto t = timebase::flicks(0);
+    for (size_t i = 0; i < mps.size(); i++, t += timebase::k_flicks_24fps)
+        expected.push_back(t, mps[i], tc + static_cast<int>(i));
+    expected.push_back(t, nullptr);
+
+    t      = timebase::flicks(0);
+    auto f = 0;
+    for (const auto &i : spans) {
+        frames.push_back(t, timebase::k_flicks_24fps, i, tc + f);
+        t += timebase::k_flicks_24fps * static_cast<timebase::flicks::rep>(i.size());
+        f += static_cast<int>(i.size());
+    }
+    frames.push_back(t, nullptr);
+
+    EXPECT_EQ(frames.size(), expected.size());
+    EXPECT_EQ(frames.runs(), expected.runs());
+    for (auto i = expected.begin(), j = frames.begin(); i != expected.end(); i++, j++) {
+        EXPECT_EQ(j.time(), i.time());
+        ASSERT_EQ(static_cast<bool>(j.frame()), static_cast<bool>(i.frame()));
+        if (i.frame())
+            EXPECT_EQ(*j.frame(), *i.frame());
+    }
+}
+
+TEST(FrameTimeMapTest, Size) {
+    // the memory a long sequence takes, compared with an AVFrameID per frame
+    const auto count = 100000;
+    const auto a     = Uuid::generate();
+
+    FrameTimeMap frames;
+    for (auto i = 0; i < count; i++)
+        frames.push_back(timebase::k_flicks_24fps * i, make_frame(a, i));
+    frames.push_back(timebase::k_flicks_24fps * count, nullptr);
+
+    EXPECT_EQ(frames.runs(), 2u);
+    EXPECT_EQ((frames.begin() + count / 2).frame()->frame_, count / 2);
+
+    spdlog::info(
+        "FrameTimeMap {} frames in {} runs, AVFrameID is {} bytes",
+        frames.size(),
+        frames.runs(),
+        sizeof(AVFrameID));
+}
+
+TEST(FrameTimeMapTest, DISABLED_StepBenchmark) {
+    // a long timeline of short clips, looked up as a playhead at 60fps would
+    const auto clips  = 5000;
+    const auto length = 100;
+    const auto step   = timebase::to_flicks(1.0 / 60.0);
+
+    FrameTimeMap frames;
+    std::map<timebase::flicks, std::shared_ptr<const AVFrameID>> baseline;
+    auto t = timebase::flicks(0);
+    for (auto c = 0; c < clips; c++) {
+        const auto uuid = Uuid::generate();
+        for (auto i = 0; i < length; i++) {
+            auto frame = make_frame(uuid, i);
+            frames.push_back(t, frame);
+            baseline[t] = frame;
+            t += timebase::k_flicks_24fps;
+        }
+    }
+    frames.push_back(t, nullptr);
+    baseline[t] = nullptr;
+
+    auto lookup = [&](const timebase::flicks position, FrameTimeMap::const_iterator &hint) {
+        auto frame = frames.upper_bound(position, hint);
+        if (frame != frames.begin())
+            frame--;
+        hint = frame;
+        return frame;
+    };
+
+    // every step of the hinted look up matches a plain search
+    auto hint  = frames.begin();
+    auto steps = 0;
+    for (auto position = timebase::flicks(0); position < t; position += step, steps++) {
+        auto frame = lookup(position, hint);
+        EXPECT_EQ(frame.time(), (--baseline.upper_bound(position))->first);
+    }
+
+    hint       = frames.begin();
+    auto start = utility::clock::now();
+    auto check = 0;
+    for (auto position = timebase::flicks(0); position < t; position += step)
+        check += static_cast<int>(lookup(position, hint).index() & 1);
+    const auto indexed = utility::clock::now() - start;
+
+    // what the playhead did before: search, then walk to the logical frame
+    start       = utility::clock::now();
+    auto walked = 0;
+    for (auto position = timebase::flicks(0); position < t; position += step * 6000) {
+        auto frame = --baseline.upper_bound(position);
+        walked += static_cast<int>(std::distance(baseline.begin(), frame) & 1);
+    }
+    const auto walk = utility::clock::now() - start;
+
+    spdlog::info(
+        "FrameTimeMap {} steps over {} frames in {}us, map walk {}us for 1 step in 6000 ({} {})",
+        steps,
+        frames.size(),
+        std::chrono::duration_cast<std::chrono::microseconds>(indexed).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(walk).count(),
+        check,
+        walked);
+}
@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <chrono>
 #include <gtest/gtest.h>
+#include <map>
 
 #include "xstudio/media/media.hpp"
 #include "xstudio/utility/frame_list.hpp"
@@ -77,3 +79,81 @@ TEST(MediaSourceTest, Test) {
 }
 
 TEST(MediaStreamTest, Test) {}
+
+TEST(MediaKeyTest, Test) {
+    const std::string key_format("{0}@{1}/{2}");
+    caf::uri path(posix_path_to_uri("/tmp/test/test.{:04d}.exr"));
+
+    // same as a key made from the formatted string
+    MediaKey key(key_format, path, 1, "main");
+    EXPECT_EQ(key, MediaKey(fmt::format(key_format, to_string(path), 1, "main")));
+    EXPECT_NE(key, MediaKey(key_format, path, 2, "main"));
+    EXPECT_NE(key, MediaKey(key_format, path, 1, "other"));
+    EXPECT_FALSE(key.empty());
+    EXPECT_TRUE(MediaKey().empty());
+    EXPECT_EQ(sizeof(MediaKey), size_t(16));
+
+    // stable, these are used in the thumbnail cache
+    EXPECT_EQ(to_string(MediaKey("hello")), "cbd8a7b341bd9b025b1e906a48ae1d19");
+
+    EXPECT_EQ(key.name(), to_string(key));
+    MediaKey::set_intern_names(true);
+    MediaKey named(key_format, path, 1, "main");
+    MediaKey::set_intern_names(false);
+    EXPECT_EQ(named, key);
+    EXPECT_EQ(key.name(), fmt::format(key_format, to_string(path), 1, "main"));
+}
+
+TEST(MediaKeyTest, Lookup) {
+    // a 10k frame timeline of long paths
+    const std::string key_format("{0}@{1}/{2}");
+    caf::uri path(posix_path_to_uri(
+        "/jobs/show/sequence/shot/plates/main/v001/4448x3096/shot_plate_main_v001.{:04d}.exr"));
+    const int frames = 10000;
+
+    std::map<std::string, int> by_string;
+    std::map<MediaKey, int> by_key;
+    std::vector<std::string> strings;
+    std::vector<MediaKey> keys;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+        strings.push_back(fmt::format(key_format, to_string(path), i, "main"));
+    auto string_build = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+        keys.emplace_back(key_format, path, i, "main");
+    auto key_build = std::chrono::steady_clock::now() - start;
+
+    for (int i = 0; i < frames; i++) {
+        by_string[strings[i]] = i;
+        by_key[keys[i]]       = i;
+    }
+
+    size_t found = 0;
+    start        = std::chrono::steady_clock::now();
+    for (int r = 0; r < 10; r++)
+        for (const auto &i : strings)
+            found += by_string.count(i);
+    auto string_lookup = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < 10; r++)
+        for (const auto &i : keys)
+            found += by_key.count(i);
+    auto key_lookup = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(found, size_t(frames * 20));
+    EXPECT_EQ(by_key.size(), size_t(frames));
+
+    using ms = std::chrono::duration<double, std::milli>;
+    spdlog::info(
+        "{} keys, string: build {:.2f}ms lookup {:.2f}ms, MediaKey: build {:.2f}ms lookup "
+        "{:.2f}ms",
+        frames,
+        ms(string_build).count(),
+        ms(string_lookup).count(),
+        ms(key_build).count(),
+        ms(key_lookup).count());
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+#include "xstudio/media_cache/buffer_pool.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace xstudio;
+using namespace xstudio::media_cache;
+
+namespace {
+// buffers have always been 1024 byte aligned, mapped blocks are page aligned
+const size_t small_block_alignment = 1024;
+const size_t huge_page_size        = 2 * 1024 * 1024;
+} // namespace
+
+BufferPool &BufferPool::instance() {
+    // never destroyed, buffers can outlive any other static
+    static auto *pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::~BufferPool() { clear(); }
+
+size_t BufferPool::size_class(const size_t size) {
+    if (size < min_pooled_size())
+        return size;
+
+    size_t power = 1;
+    while (power < size)
+        power <<= 1;
+
+    const size_t step = power / 8;
+    return ((size + step - 1) / step) * step;
+}
+
+void *BufferPool::allocate(const size_t size, size_t &capacity) {
+    capacity = size_class(size);
+
+    if (capacity < min_pooled_size())
+        return new (std::align_val_t(small_block_alignment)) std::byte[capacity];
+
+    {
+        std::lock_guard<std::mutex> l(mutex_);
+        auto p = free_blocks_.find(capacity);
+        if (p != free_blocks_.end() and not p->second.empty()) {
+            auto block = p->second.back();
+            p->second.pop_back();
+            if (p->second.empty())
+                free_blocks_.erase(p);
+            free_by_age_.erase(block.first);
+
+            stats_.pool_hits_++;
+            stats_.pooled_count_--;
+            stats_.pooled_size_ -= capacity;
+            return block.second;
+        }
+        stats_.system_allocations_++;
+    }
+
+    return system_allocate(capacity);
+}
+
+void BufferPool::release(void *data, const size_t capacity) {
+    if (not data)
+        return;
+
+    if (capacity < min_pooled_size()) {
+        ::operator delete[](data, std::align_val_t(small_block_alignment));
+        return;
+    }
+
+    std::lock_guard<std::mutex> l(mutex_);
+    stats_.released_++;
+
+    if (capacity > max_size_) {
+        system_free(data, capacity);
+        return;
+    }
+
+    // make room, oldest blocks first. If the user is playing through mixed
+    // formats these are probably a size that nobody is asking for any more.
+    trim(max_size_ - capacity);
+
+    const auto age = age_++;
+    free_blocks_[capacity].emplace_back(age, data);
+    free_by_age_[age] = std::make_pair(capacity, data);
+    stats_.pooled_count_++;
+    stats_.pooled_size_ += capacity;
+}
+
+void BufferPool::trim(const size_t max_size) {
+    while (stats_.pooled_size_ > max_size and not free_by_age_.empty()) {
+        auto oldest         = free_by_age_.begin();
+        const auto capacity = oldest->second.first;
+        void *data          = oldest->second.second;
+
+        auto &blocks = free_blocks_[capacity];
+        blocks.erase(
+            std::find(blocks.begin(), blocks.end(), std::make_pair(oldest->first, data)));
+        if (blocks.empty())
+            free_blocks_.erase(capacity);
+        free_by_age_.erase(oldest);
+
+        system_free(data, capacity);
+        stats_.trimmed_++;
+        stats_.pooled_count_--;
+        stats_.pooled_size_ -= capacity;
+    }
+}
+
+void *BufferPool::system_allocate(const size_t capacity) {
+    void *data = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // only succeeds if the system has huge pages reserved
+    if (huge_pages_ and capacity % huge_page_size == 0)
+        data = mmap(
+            nullptr,
+            capacity,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0);
+#endif
+
+    if (data == MAP_FAILED) {
+        data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        // otherwise ask for transparent huge pages
+        if (huge_pages_ and madvise(data, capacity, MADV_HUGEPAGE) != 0)
+            spdlog::debug("{} madvise failed", __PRETTY_FUNCTION__);
+#endif
+    }
+
+    return data;
+}
+
+void BufferPool::system_free(void *data, const size_t capacity) { munmap(data, capacity); }
+
+void BufferPool::set_max_size(const size_t max_size) {
+    std::lock_guard<std::mutex> l(mutex_);
+    max_size_ = max_size;
+    trim(max_size_);
+}
+
+void BufferPool::set_huge_pages(const bool huge_pages) {
+    std::lock_guard<std::mutex> l(mutex_);
+    huge_pages_ = huge_pages;
+}
+
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> l(mutex_);
+    trim(0);
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    std::lock_guard<std::mutex> l(mutex_);
+    return stats_;
+}
+
+utility::JsonStore BufferPool::stats_json() const {
+    std::lock_guard<std::mutex> l(mutex_);
+    utility::JsonStore result;
+    result["system_allocations"] = stats_.system_allocations_;
+    result["pool_hits"]          = stats_.pool_hits_;
+    result["released"]           = stats_.released_;
+    result["trimmed"]            = stats_.trimmed_;
+    result["pooled_count"]       = stats_.pooled_count_;
+    result["pooled_size"]        = stats_.pooled_size_;
+    result["max_size"]           = max_size_;
+    result["huge_pages"]         = huge_pages_;
+    return result;
+}
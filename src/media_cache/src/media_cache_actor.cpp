@@ -7,6 +7,7 @@
 #include "xstudio/broadcast/broadcast_actor.hpp"
 #include "xstudio/colour_pipeline/colour_pipeline.hpp"
 #include "xstudio/global_store/global_store.hpp"
+#include "xstudio/media_cache/buffer_pool.hpp"
 #include "xstudio/media_cache/media_cache_actor.hpp"
 #include "xstudio/utility/helpers.hpp"
 #include "xstudio/utility/json_store.hpp"
@@ -43,8 +44,21 @@ TrimActor::TrimActor(caf::actor_config &cfg) : caf::event_based_actor(cfg) {
     });
 }
 
+namespace {
+void update_buffer_pool(const JsonStore &js) {
+    try {
+        BufferPool::instance().set_max_size(
+            preference_value<size_t>(js, "/core/image_cache/buffer_pool_size") * 1024 * 1024);
+        BufferPool::instance().set_huge_pages(
+            preference_value<bool>(js, "/core/image_cache/huge_pages"));
+    } catch (const std::exception &err) {
+        spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+    }
+}
+} // namespace
+
 GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
-    : caf::event_based_actor(cfg), update_pending_(false) {
+    : caf::event_based_actor(cfg), cache_(std::make_shared<SharedImageCache>()) {
     print_on_exit(this, "GlobalImageCacheActor");
 
     system().registry().put(image_cache_registry, this);
@@ -57,13 +71,19 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
         join_broadcast(this, prefs.get_group(j));
         max_count = preference_value<size_t>(j, "/core/image_cache/max_count");
         max_size  = preference_value<size_t>(j, "/core/image_cache/max_size") * 1024 * 1024;
+        update_buffer_pool(j);
     } catch (...) {
     }
 
-    cache_.set_max_size(max_size);
-    cache_.set_max_count(max_count);
-    cache_.bind_change_callback([this](auto &&PH1, auto &&PH2) {
-        update_changes(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2));
+    cache_->set_max_size(max_size);
+    cache_->set_max_count(max_count);
+
+    // readers can change the cache from their own threads, so we only hear
+    // that something changed and collect the keys when we broadcast.
+    cache_->bind_change_callback([addr = caf::actor_cast<caf::actor_addr>(this)]() {
+        auto dest = caf::actor_cast<caf::actor>(addr);
+        if (dest)
+            delayed_anon_send(dest, std::chrono::milliseconds(250), keys_atom_v, true);
     });
 
     auto event_group_ = spawn<broadcast::BroadcastActor>(this);
@@ -75,24 +95,24 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
     behavior_.assign(
         [=](xstudio::broadcast::broadcast_down_atom, const caf::actor_addr &) {},
         [=](clear_atom) -> bool {
-            cache_.clear();
+            cache_->clear();
             return true;
         },
 
-        [=](count_atom) -> size_t { return cache_.count(); },
+        [=](count_atom) -> size_t { return cache_->count(); },
 
-        [=](erase_atom, const media::MediaKey &key) { cache_.erase(key); },
+        [=](erase_atom, const media::MediaKey &key) { cache_->erase(key); },
 
         [=](erase_atom, const media::MediaKey &key, const utility::Uuid &uuid) {
-            cache_.erase(key, uuid);
+            cache_->erase(key, uuid);
         },
 
         [=](erase_atom, const media::MediaKeyVector &keys) -> media::MediaKeyVector {
-            return cache_.erase(keys);
+            return cache_->erase(keys);
         },
 
         [=](erase_atom, const utility::Uuid &uuid) -> bool {
-            cache_.erase(uuid);
+            cache_->erase(uuid);
             return true;
         },
 
@@ -108,49 +128,54 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
                 auto new_count = preference_value<size_t>(js, "/core/image_cache/max_count");
                 auto new_size =
                     preference_value<size_t>(js, "/core/image_cache/max_size") * 1024 * 1024;
-                if (cache_.max_size() != new_size)
-                    cache_.set_max_size(new_size);
-                if (cache_.max_count() != new_count)
-                    cache_.set_max_count(new_count);
+                if (cache_->max_size() != new_size)
+                    cache_->set_max_size(new_size);
+                if (cache_->max_count() != new_count)
+                    cache_->set_max_count(new_count);
             } catch (const std::exception &err) {
                 spdlog::warn("{} {}", __PRETTY_FUNCTION__, err.what());
             }
+            update_buffer_pool(js);
         },
 
-        [=](keys_atom) -> media::MediaKeyVector { return cache_.keys(); },
+        [=](keys_atom) -> media::MediaKeyVector { return cache_->keys(); },
 
         [=](keys_atom, bool) {
-            if (not erased_keys_.empty() or not new_keys_.empty()) {
+            media::MediaKeyVector new_keys;
+            media::MediaKeyVector erased_keys;
+            cache_->take_changes(new_keys, erased_keys);
+
+            if (not erased_keys.empty() or not new_keys.empty()) {
                 // force purge of memory..
-                if (not erased_keys_.empty())
-                    anon_send(trim, unpreserve_atom_v, erased_keys_.size());
+                if (not erased_keys.empty())
+                    anon_send(trim, unpreserve_atom_v, erased_keys.size());
 
                 send(
                     event_group_,
                     utility::event_atom_v,
                     media_cache::keys_atom_v,
-                    media::MediaKeyVector(new_keys_.begin(), new_keys_.end()),
-                    media::MediaKeyVector(erased_keys_.begin(), erased_keys_.end()));
+                    new_keys,
+                    erased_keys);
             }
-
-            new_keys_.clear();
-            erased_keys_.clear();
-            update_pending_ = false;
         },
 
+        [=](get_shared_cache_atom) -> SharedImageCachePtr { return cache_; },
+
+        [=](buffer_pool_stats_atom) -> JsonStore { return BufferPool::instance().stats_json(); },
+
         [=](unpreserve_atom, const utility::Uuid &uuid) -> bool {
-            cache_.unpreserve(uuid);
+            cache_->unpreserve(uuid);
             return true;
         },
 
-        [=](preserve_atom, const media::MediaKey &key) -> bool { return cache_.preserve(key); },
+        [=](preserve_atom, const media::MediaKey &key) -> bool { return cache_->preserve(key); },
 
         [=](preserve_atom, const media::MediaKey &key, const time_point &time) -> bool {
-            return cache_.preserve(key, time);
+            return cache_->preserve(key, time);
         },
 
         [=](preserve_atom, const media::MediaKey &key, const time_point &time, const Uuid &uuid)
-            -> bool { return cache_.preserve(key, time, uuid); },
+            -> bool { return cache_->preserve(key, time, uuid); },
 
         // given a list of frame pointers, check which frames are in the cache
         // and return a list of those that *aren't* in the cache
@@ -159,7 +184,7 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
             const Uuid &uuid) -> media::AVFrameIDsAndTimePoints {
             media::AVFrameIDsAndTimePoints result;
             for (const auto &p : mpts) {
-                if (!cache_.preserve(p.second->key_, p.first, uuid)) {
+                if (!cache_->preserve(p.second->key_, p.first, uuid)) {
                     result.push_back(p);
                 }
             }
@@ -169,12 +194,12 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
         [=](preserve_atom,
             const std::vector<std::pair<media::MediaKey, utility::time_point>>
                 &keys_and_timepoints) -> bool {
-            cache_.make_entries_hot(keys_and_timepoints);
+            cache_->make_entries_hot(keys_and_timepoints);
             return true;
         },
 
         [=](retrieve_atom, const media::MediaKey &key) -> media_reader::ImageBufPtr {
-            return cache_.retrieve(key);
+            return cache_->retrieve(key);
         },
 
         [=](retrieve_atom, const media::AVFrameIDsAndTimePoints &mptr_and_timepoints)
@@ -182,7 +207,7 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
             std::vector<media_reader::ImageBufPtr> result(mptr_and_timepoints.size());
             auto r = result.begin();
             for (const auto &p : mptr_and_timepoints) {
-                *r                    = cache_.retrieve(p.second->key_, p.first);
+                *r                    = cache_->retrieve(p.second->key_, p.first);
                 (*r).when_to_display_ = p.first;
                 r++;
             }
@@ -190,28 +215,28 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
         },
 
         [=](retrieve_atom, const media::MediaKey &key, const time_point &time)
-            -> media_reader::ImageBufPtr { return cache_.retrieve(key, time); },
+            -> media_reader::ImageBufPtr { return cache_->retrieve(key, time); },
 
         [=](retrieve_atom, const media::MediaKey &key, const time_point &time, const Uuid &uuid)
-            -> media_reader::ImageBufPtr { return cache_.retrieve(key, time, uuid); },
+            -> media_reader::ImageBufPtr { return cache_->retrieve(key, time, uuid); },
 
-        [=](size_atom) -> size_t { return cache_.size(); },
+        [=](size_atom) -> size_t { return cache_->size(); },
 
         [=](store_atom, const media::MediaKey &key, media_reader::ImageBufPtr buf) -> bool {
-            return cache_.store(key, buf);
+            return cache_->store(key, buf);
         },
 
         [=](store_atom,
             const media::MediaKey &key,
             const media_reader::ImageBufPtr &buf,
-            const time_point &when) -> bool { return cache_.store(key, buf, when); },
+            const time_point &when) -> bool { return cache_->store(key, buf, when); },
 
         [=](store_atom,
             const media::MediaKey &key,
             const media_reader::ImageBufPtr &buf,
             const time_point &when,
             const utility::Uuid &uuid) -> bool {
-            return cache_.store(key, buf, when, false, uuid);
+            return cache_->store(key, buf, when, false, uuid);
         },
 
         [=](store_atom,
@@ -219,7 +244,7 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
             const media_reader::ImageBufPtr &buf,
             const time_point &when,
             const utility::Uuid &uuid) -> bool {
-            return cache_.store(key, buf, when, false, uuid);
+            return cache_->store(key, buf, when, false, uuid);
         },
         [=](store_atom,
             const media::MediaKey &key,
@@ -227,30 +252,42 @@ GlobalImageCacheActor::GlobalImageCacheActor(caf::actor_config &cfg)
             const time_point &when,
             const utility::Uuid &uuid,
             const time_point &cache_out_date_tp) -> bool {
-            return cache_.store(key, buf, when, uuid, cache_out_date_tp);
+            return cache_->store(key, buf, when, uuid, cache_out_date_tp);
         },
 
-        [=](utility::get_event_group_atom) -> caf::actor { return event_group_; });
-}
+        // batches of precached frames for a playhead, returns which were stored
+        [=](store_atom,
+            const media::MediaKeyVector &keys,
+            const std::vector<media_reader::ImageBufPtr> &bufs,
+            const std::vector<time_point> &when,
+            const utility::Uuid &uuid) -> std::vector<bool> {
+            std::vector<bool> result(keys.size(), false);
+            for (size_t i = 0; i < keys.size() and i < bufs.size() and i < when.size(); i++)
+                result[i] = cache_->store(keys[i], bufs[i], when[i], false, uuid);
+            return result;
+        },
 
-void GlobalImageCacheActor::update_changes(
-    const media::MediaKeyVector &store, const media::MediaKeyVector &erase) {
-    for (const auto &i : store) {
-        new_keys_.insert(i);
-        erased_keys_.erase(i);
-    }
+        [=](store_atom,
+            const media::MediaKeyVector &keys,
+            const std::vector<media_reader::ImageBufPtr> &bufs,
+            const std::vector<time_point> &when,
+            const utility::Uuid &uuid,
+            const std::vector<time_point> &cache_out_date_tps) -> std::vector<bool> {
+            std::vector<bool> result(keys.size(), false);
+            for (size_t i = 0; i < keys.size() and i < bufs.size() and i < when.size() and
+                               i < cache_out_date_tps.size();
+                 i++)
+                result[i] = cache_->store(keys[i], bufs[i], when[i], uuid, cache_out_date_tps[i]);
+            return result;
+        },
 
-    for (const auto &i : erase) {
-        new_keys_.erase(i);
-        erased_keys_.insert(i);
-    }
-    if (not update_pending_ and (not new_keys_.empty() or not erased_keys_.empty())) {
-        update_pending_ = true;
-        delayed_anon_send(this, std::chrono::milliseconds(250), keys_atom_v, true);
-    }
+        [=](utility::get_event_group_atom) -> caf::actor { return event_group_; });
 }
 
-void GlobalImageCacheActor::on_exit() { system().registry().erase(image_cache_registry); }
+void GlobalImageCacheActor::on_exit() {
+    cache_->bind_change_callback(std::function<void()>());
+    system().registry().erase(image_cache_registry);
+}
 
 
 GlobalAudioCacheActor::GlobalAudioCacheActor(caf::actor_config &cfg)
@@ -410,6 +447,31 @@ GlobalAudioCacheActor::GlobalAudioCacheActor(caf::actor_config &cfg)
             return cache_.store(key, buf, when, uuid, cache_out_date_tp);
         },
 
+        [=](store_atom,
+            const media::MediaKeyVector &keys,
+            const std::vector<media_reader::AudioBufPtr> &bufs,
+            const std::vector<time_point> &when,
+            const utility::Uuid &uuid) -> std::vector<bool> {
+            std::vector<bool> result(keys.size(), false);
+            for (size_t i = 0; i < keys.size() and i < bufs.size() and i < when.size(); i++)
+                result[i] = cache_.store(keys[i], bufs[i], when[i], false, uuid);
+            return result;
+        },
+
+        [=](store_atom,
+            const media::MediaKeyVector &keys,
+            const std::vector<media_reader::AudioBufPtr> &bufs,
+            const std::vector<time_point> &when,
+            const utility::Uuid &uuid,
+            const std::vector<time_point> &cache_out_date_tps) -> std::vector<bool> {
+            std::vector<bool> result(keys.size(), false);
+            for (size_t i = 0; i < keys.size() and i < bufs.size() and i < when.size() and
+                               i < cache_out_date_tps.size();
+                 i++)
+                result[i] = cache_.store(keys[i], bufs[i], when[i], uuid, cache_out_date_tps[i]);
+            return result;
+        },
+
         [=](utility::get_event_group_atom) -> caf::actor { return event_group_; });
 }
 
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <new>
+#include <sys/resource.h>
+
+#include "xstudio/media_cache/buffer_pool.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace xstudio::media_cache;
+
+namespace {
+long minor_page_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+} // namespace
+
+TEST(BufferPoolTest, SizeClass) {
+    // small blocks aren't rounded
+    EXPECT_EQ(BufferPool::size_class(1000), size_t(1000));
+    // no more than 1/8th of the power of two over
+    EXPECT_EQ(BufferPool::size_class(1024 * 1024), size_t(1024 * 1024));
+    EXPECT_EQ(BufferPool::size_class(1024 * 1024 + 1), size_t(1024 * 1024 + 256 * 1024));
+    const size_t uhd = 3840 * 2160 * 4;
+    EXPECT_GE(BufferPool::size_class(uhd), uhd);
+    EXPECT_LE(BufferPool::size_class(uhd), uhd + uhd / 8);
+    EXPECT_EQ(BufferPool::size_class(uhd), BufferPool::size_class(uhd - 100));
+}
+
+TEST(BufferPoolTest, Reuse) {
+    BufferPool pool(64 * 1024 * 1024);
+    size_t capacity = 0;
+
+    auto small = pool.allocate(100, capacity);
+    EXPECT_EQ(capacity, size_t(100));
+    pool.release(small, capacity);
+    EXPECT_EQ(pool.stats().pooled_count_, size_t(0));
+
+    auto a = pool.allocate(8 * 1024 * 1024, capacity);
+    std::memset(a, 1, capacity);
+    pool.release(a, capacity);
+    EXPECT_EQ(pool.stats().pooled_count_, size_t(1));
+
+    // same size class comes straight back
+    auto b = pool.allocate(8 * 1024 * 1024 - 10, capacity);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(pool.stats().pool_hits_, size_t(1));
+    EXPECT_EQ(pool.stats().system_allocations_, size_t(1));
+    EXPECT_EQ(pool.stats().pooled_count_, size_t(0));
+    pool.release(b, capacity);
+
+    // a different size class doesn't
+    auto c = pool.allocate(2 * 1024 * 1024, capacity);
+    EXPECT_NE(a, c);
+    pool.release(c, capacity);
+    EXPECT_EQ(pool.stats().pooled_count_, size_t(2));
+
+    // oldest go first when over budget
+    pool.set_max_size(4 * 1024 * 1024);
+    EXPECT_EQ(pool.stats().pooled_count_, size_t(1));
+    EXPECT_EQ(pool.stats().pooled_size_, size_t(2 * 1024 * 1024));
+    EXPECT_EQ(pool.stats().trimmed_, size_t(1));
+
+    pool.clear();
+    EXPECT_EQ(pool.stats().pooled_size_, size_t(0));
+}
+
+TEST(BufferPoolTest, DISABLED_PlaybackChurn) {
+    // a cache that's full, deleting one 4K frame for every frame read
+    const size_t frame_size = 4096 * 2160 * 4;
+    const size_t frames     = 200;
+    const size_t in_flight  = 4;
+
+    auto churn = [&](auto allocate, auto release) {
+        std::vector<std::pair<void *, size_t>> live;
+        auto faults = minor_page_faults();
+        auto start  = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; i++) {
+            auto buffer = allocate(frame_size);
+            // the reader writes every pixel
+            std::memset(buffer.first, int(i), frame_size);
+            live.push_back(buffer);
+            if (live.size() > in_flight) {
+                release(live.front());
+                live.erase(live.begin());
+            }
+        }
+        for (auto &i : live)
+            release(i);
+        return std::make_pair(
+            minor_page_faults() - faults,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    auto system = churn(
+        [](const size_t size) {
+            return std::make_pair(
+                static_cast<void *>(new (std::align_val_t(1024)) std::byte[size]), size);
+        },
+        [](const std::pair<void *, size_t> &b) {
+            ::operator delete[](b.first, std::align_val_t(1024));
+        });
+
+    BufferPool pool(frame_size * in_flight * 2);
+    auto pooled = churn(
+        [&pool](const size_t size) {
+            size_t capacity = 0;
+            auto data       = pool.allocate(size, capacity);
+            return std::make_pair(data, capacity);
+        },
+        [&pool](const std::pair<void *, size_t> &b) { pool.release(b.first, b.second); });
+
+    const auto stats = pool.stats();
+    spdlog::info(
+        "{} frames, system allocator: {} allocations {} page faults {:.3f}s",
+        frames,
+        frames,
+        system.first,
+        system.second);
+    spdlog::info(
+        "{} frames, buffer pool: {} allocations {} page faults {:.3f}s",
+        frames,
+        stats.system_allocations_,
+        pooled.first,
+        pooled.second);
+
+    EXPECT_EQ(stats.system_allocations_ + stats.pool_hits_, frames);
+    EXPECT_LE(stats.system_allocations_, in_flight + 1);
+    EXPECT_LT(pooled.first, system.first);
+}
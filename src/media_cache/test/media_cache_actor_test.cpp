@@ -1,10 +1,13 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <atomic>
 #include <caf/all.hpp>
 #include <gtest/gtest.h>
+#include <thread>
 
 #include "xstudio/atoms.hpp"
 #include "xstudio/media_cache/media_cache_actor.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
+#include "xstudio/utility/helpers.hpp"
 
 using namespace xstudio;
 using namespace xstudio::utility;
@@ -32,3 +35,60 @@ TEST(MediaCacheActorTest, Test) {
 
     // f.self->send_exit(tmp, caf::exit_reason::user_shutdown);
 }
+
+// Timing only, so only run on request with --gtest_also_run_disabled_tests
+TEST(MediaCacheActorTest, DISABLED_SharedCacheBenchmark) {
+    // Logs retrieves per second from several threads, going through the cache
+    // actor's mailbox and going straight to the shared cache.
+    fixture f;
+    const size_t entries    = 2000;
+    const size_t threads    = 8;
+    const size_t iterations = 2000;
+
+    auto cache_actor = f.self->spawn<GlobalImageCacheActor>();
+    auto shared_cache =
+        request_receive<SharedImageCachePtr>(*(f.self), cache_actor, get_shared_cache_atom_v);
+    ASSERT_TRUE(shared_cache);
+
+    std::vector<media::MediaKey> keys;
+    for (size_t i = 0; i < entries; i++) {
+        keys.emplace_back(std::to_string(i));
+        media_reader::ImageBufPtr buf(new media_reader::ImageBuffer());
+        buf->allocate(1024);
+        shared_cache->store(keys.back(), buf);
+    }
+
+    auto retrieves_per_second = [&](auto retrieve) {
+        std::atomic<size_t> hits{0};
+        std::vector<std::thread> pool;
+        auto start = clock::now();
+        for (size_t t = 0; t < threads; t++)
+            pool.emplace_back([&, t]() {
+                scoped_actor self{f.system};
+                for (size_t i = 0; i < iterations; i++) {
+                    if (retrieve(self, keys[(i * threads + t) % entries]))
+                        hits++;
+                }
+            });
+        for (auto &i : pool)
+            i.join();
+        EXPECT_EQ(hits, threads * iterations);
+        return (threads * iterations) / std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    const auto actor_rate = retrieves_per_second([&](scoped_actor &self, const auto &key) {
+        return request_receive<media_reader::ImageBufPtr>(
+            *self, cache_actor, retrieve_atom_v, key);
+    });
+    const auto shared_rate = retrieves_per_second(
+        [&](scoped_actor &, const auto &key) { return shared_cache->retrieve(key); });
+
+    spdlog::info(
+        "{} threads, {} retrieves: cache actor {:.0f}/sec, shared cache {:.0f}/sec",
+        threads,
+        threads * iterations,
+        actor_rate,
+        shared_rate);
+
+    f.self->send_exit(cache_actor, caf::exit_reason::user_shutdown);
+}
@@ -1,7 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <limits>
+
 #include "xstudio/media_reader/cacheing_media_reader_actor.hpp"
 #include "xstudio/global_store/global_store.hpp"
 #include "xstudio/atoms.hpp"
+#include "xstudio/media_cache/media_cache_actor.hpp"
 #include "xstudio/utility/helpers.hpp"
 #include "xstudio/utility/json_store.hpp"
 #include "xstudio/utility/time_cache.hpp"
@@ -18,7 +22,8 @@ CachingMediaReaderActor::CachingMediaReaderActor(
     caf::actor_config &cfg,
     const utility::Uuid &media_reader_plugin_uuid,
     caf::actor image_cache,
-    caf::actor audio_cache)
+    caf::actor audio_cache,
+    const caf::uri &uri)
     : caf::event_based_actor(cfg),
       image_cache_(std::move(image_cache)),
       audio_cache_(std::move(audio_cache)) {
@@ -35,9 +40,41 @@ CachingMediaReaderActor::CachingMediaReaderActor(
         auto pm = system().registry().template get<caf::actor>(plugin_manager_registry);
         scoped_actor sys{system()};
 
-        precache_worker_ = request_receive<caf::actor>(
-            *sys, pm, plugin_manager::spawn_plugin_atom_v, media_reader_plugin_uuid, js);
-        link_to(precache_worker_);
+        precache_workers_.push_back(request_receive<caf::actor>(
+            *sys, pm, plugin_manager::spawn_plugin_atom_v, media_reader_plugin_uuid, js));
+        link_to(precache_workers_.back());
+
+        // the reader plugin tells us how many readers it's happy to have open
+        // on this source, and whether they should be fed runs of frames.
+        size_t precache_worker_count = 1;
+        if (not uri.empty()) {
+            try {
+                const auto policy = request_receive<std::pair<int, bool>>(
+                    *sys, precache_workers_.front(), read_policy_atom_v, uri);
+                precache_worker_count     = std::max(1, policy.first);
+                prefer_sequential_access_ = policy.second;
+            } catch (const std::exception &err) {
+                spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+            }
+        }
+
+        // and whether it can load just the part of a frame that's on screen
+        try {
+            can_do_partial_frames_ =
+                request_receive<bool>(*sys, precache_workers_.front(), partial_frames_atom_v);
+        } catch (const std::exception &err) {
+            spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+        }
+
+        while (precache_workers_.size() < precache_worker_count) {
+            precache_workers_.push_back(request_receive<caf::actor>(
+                *sys, pm, plugin_manager::spawn_plugin_atom_v, media_reader_plugin_uuid, js));
+            link_to(precache_workers_.back());
+        }
+        precache_worker_load_.resize(precache_workers_.size(), 0);
+        precache_worker_last_frame_.resize(
+            precache_workers_.size(), std::numeric_limits<int>::min());
+
         urgent_worker_ = request_receive<caf::actor>(
             *sys, pm, plugin_manager::spawn_plugin_atom_v, media_reader_plugin_uuid, js);
         link_to(urgent_worker_);
@@ -51,6 +88,15 @@ CachingMediaReaderActor::CachingMediaReaderActor(
     if (not audio_cache_)
         audio_cache_ = system().registry().template get<caf::actor>(audio_cache_registry);
 
+    try {
+        scoped_actor sys{system()};
+        shared_image_cache_ = request_receive<media_cache::SharedImageCachePtr>(
+            *sys, image_cache_, media_cache::get_shared_cache_atom_v);
+    } catch (const std::exception &err) {
+        // fall back to messaging the cache actor
+        spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+    }
+
     behavior_.assign(
         [=](xstudio::broadcast::broadcast_down_atom, const caf::actor_addr &) {},
 
@@ -67,54 +113,54 @@ CachingMediaReaderActor::CachingMediaReaderActor(
             const utility::Uuid &playhead_uuid) -> result<ImageBufPtr> {
             auto rp = make_response_promise<media_reader::ImageBufPtr>();
             // first, check if the image we want is cached
-            request(image_cache_, infinite, media_cache::retrieve_atom_v, mptr.key_)
-                .then(
-                    [=](media_reader::ImageBufPtr buf) mutable {
-                        if (buf) {
-                            rp.deliver(buf);
-                        } else {
-                            request(urgent_worker_, infinite, get_image_atom_v, mptr)
-                                .then(
-                                    [=](media_reader::ImageBufPtr buf) mutable {
-                                        rp.deliver(buf);
-                                        // store the image in our cache
-                                        anon_send<message_priority::high>(
-                                            image_cache_,
-                                            media_cache::store_atom_v,
-                                            mptr.key_,
-                                            buf,
-                                            utility::clock::now() +
-                                                (pin ? std::chrono::minutes(10)
-                                                     : std::chrono::minutes(0)),
-                                            playhead_uuid);
-                                    },
-                                    [=](const caf::error &err) mutable {
-                                        // make an empty image buffer that holds the error
-                                        // message
-                                        std::stringstream err_msg;
-                                        std::string caf_error_string = to_string(err);
-                                        // strip the caf error formatting
-                                        if (caf_error_string.find("error(\"") !=
-                                            std::string::npos) {
-                                            caf_error_string = std::string(caf_error_string, 7);
-                                            // strip off the ") at the end too
-                                            caf_error_string = std::string(
-                                                caf_error_string,
-                                                0,
-                                                caf_error_string.length() - 2);
-                                        }
-
-                                        err_msg << "Error loading file \""
-                                                << to_string(mptr.uri_)
-                                                << "\": " << caf_error_string;
-
-                                        media_reader::ImageBufPtr buf(
-                                            new media_reader::ImageBuffer(err_msg.str()));
-                                        rp.deliver(buf);
-                                    });
-                        }
-                    },
-                    [=](const caf::error &err) mutable { rp.deliver(err); });
+            retrieve_cached_image(
+                mptr.key_,
+                [=](media_reader::ImageBufPtr buf) mutable {
+                    if (buf) {
+                        rp.deliver(buf);
+                    } else {
+                        request(urgent_worker_, infinite, get_image_atom_v, mptr)
+                            .then(
+                                [=](media_reader::ImageBufPtr buf) mutable {
+                                    rp.deliver(buf);
+                                    // store the image in our cache
+                                    anon_send<message_priority::high>(
+                                        image_cache_,
+                                        media_cache::store_atom_v,
+                                        mptr.key_,
+                                        buf,
+                                        utility::clock::now() +
+                                            (pin ? std::chrono::minutes(10)
+                                                 : std::chrono::minutes(0)),
+                                        playhead_uuid);
+                                },
+                                [=](const caf::error &err) mutable {
+                                    // make an empty image buffer that holds the error
+                                    // message
+                                    std::stringstream err_msg;
+                                    std::string caf_error_string = to_string(err);
+                                    // strip the caf error formatting
+                                    if (caf_error_string.find("error(\"") !=
+                                        std::string::npos) {
+                                        caf_error_string = std::string(caf_error_string, 7);
+                                        // strip off the ") at the end too
+                                        caf_error_string = std::string(
+                                            caf_error_string,
+                                            0,
+                                            caf_error_string.length() - 2);
+                                    }
+
+                                    err_msg << "Error loading file \""
+                                            << to_string(mptr.uri_)
+                                            << "\": " << caf_error_string;
+
+                                    media_reader::ImageBufPtr buf(
+                                        new media_reader::ImageBuffer(err_msg.str()));
+                                    rp.deliver(buf);
+                                });
+                    }
+                },
+                [=](const caf::error &err) mutable { rp.deliver(err); });
             return rp;
         },
 
@@ -163,25 +209,62 @@ CachingMediaReaderActor::CachingMediaReaderActor(
             receive_image_buffer_request(mptr, playhead, playhead_uuid, tp);
         },
 
+        [=](get_image_atom,
+            const media::AVFrameID &mptr,
+            caf::actor playhead,
+            const utility::Uuid playhead_uuid,
+            const time_point &tp,
+            const Imath::V2f &viewport_visible_min,
+            const Imath::V2f &viewport_visible_max,
+            const Imath::V2i &viewport_size_screen_pixels,
+            const Imath::M44f &image_transform) {
+            receive_image_buffer_request(
+                mptr,
+                playhead,
+                playhead_uuid,
+                tp,
+                ViewportView{
+                    viewport_visible_min,
+                    viewport_visible_max,
+                    viewport_size_screen_pixels,
+                    image_transform});
+        },
+
         [=](read_precache_image_atom, const media::AVFrameID &mptr) -> result<ImageBufPtr> {
             // note the caller (GlobalMediaReaderActor) handles the cacheing
             // of this image buffer
-            auto rp = make_response_promise<media_reader::ImageBufPtr>();
-            request(precache_worker_, infinite, get_image_atom_v, mptr)
+            auto rp          = make_response_promise<media_reader::ImageBufPtr>();
+            const auto index = next_precache_worker(mptr.frame_);
+            precache_worker_load_[index]++;
+            request(precache_workers_[index], infinite, get_image_atom_v, mptr)
                 .then(
-                    [=](media_reader::ImageBufPtr buf) mutable { rp.deliver(buf); },
-                    [=](const caf::error &err) mutable { rp.deliver(err); });
+                    [=](media_reader::ImageBufPtr buf) mutable {
+                        precache_worker_load_[index]--;
+                        rp.deliver(buf);
+                    },
+                    [=](const caf::error &err) mutable {
+                        precache_worker_load_[index]--;
+                        rp.deliver(err);
+                    });
             return rp;
         },
 
         [=](read_precache_audio_atom, const media::AVFrameID &mptr) -> result<AudioBufPtr> {
             // note the caller (GlobalMediaReaderActor) handles the cacheing
             // of this image buffer
-            auto rp = make_response_promise<media_reader::AudioBufPtr>();
-            request(precache_worker_, infinite, get_audio_atom_v, mptr)
+            auto rp          = make_response_promise<media_reader::AudioBufPtr>();
+            const auto index = next_precache_worker(mptr.frame_);
+            precache_worker_load_[index]++;
+            request(precache_workers_[index], infinite, get_audio_atom_v, mptr)
                 .then(
-                    [=](media_reader::AudioBufPtr buf) mutable { rp.deliver(buf); },
-                    [=](const caf::error &err) mutable { rp.deliver(err); });
+                    [=](media_reader::AudioBufPtr buf) mutable {
+                        precache_worker_load_[index]--;
+                        rp.deliver(buf);
+                    },
+                    [=](const caf::error &err) mutable {
+                        precache_worker_load_[index]--;
+                        rp.deliver(err);
+                    });
             return rp;
         },
 
@@ -199,9 +282,42 @@ void CachingMediaReaderActor::do_urgent_get_image() {
     caf::actor playhead         = p->second.playhead_;
     auto tp                     = p->second.time_point_;
     auto playhead_uuid          = p->first;
+    const auto view             = p->second.view_;
     pending_get_image_requests_.erase(p);
 
     urgent_worker_busy_ = true;
+
+    if (view && can_do_partial_frames_) {
+        // only the part of the frame in view. It's not the full frame, so it
+        // stays out of the cache.
+        request(
+            urgent_worker_,
+            infinite,
+            get_image_atom_v,
+            mptr,
+            last_partial_frame_,
+            view->visible_min_,
+            view->visible_max_,
+            view->size_screen_pixels_,
+            view->image_transform_)
+            .then(
+                [=](media_reader::ImageBufPtr buf) mutable {
+                    last_partial_frame_ = buf;
+                    send(playhead, push_image_atom_v, buf, mptr, tp);
+                    urgent_worker_busy_ = false;
+                    anon_send(this, get_image_atom_v);
+                },
+                [=](const caf::error &) mutable {
+                    // the full frame read reports the error, unless a newer
+                    // request has come in
+                    pending_get_image_requests_.emplace(
+                        playhead_uuid, ImmediateImageReqest(mptr, playhead, tp));
+                    urgent_worker_busy_ = false;
+                    anon_send(this, get_image_atom_v);
+                });
+        return;
+    }
+
     request(urgent_worker_, infinite, get_image_atom_v, mptr)
         .then(
             [=](media_reader::ImageBufPtr buf) mutable {
@@ -246,28 +362,75 @@ void CachingMediaReaderActor::do_urgent_get_image() {
             });
 }
 
+size_t CachingMediaReaderActor::next_precache_worker(const int frame) {
+    size_t result = 0;
+
+    if (prefer_sequential_access_) {
+        // Long GOP sources decode much faster reading forwards than seeking, so
+        // a frame that follows on from the last one a worker was given goes to
+        // that worker. So does the frame before it, as the decoder only holds
+        // a window of frames for reverse playback when it sees a run of
+        // descending requests. Anything else starts a new run on the least
+        // busy worker.
+        auto run = std::find_if(
+            precache_worker_last_frame_.begin(),
+            precache_worker_last_frame_.end(),
+            [frame](const int last) { return last == frame - 1 || last == frame + 1; });
+        if (run != precache_worker_last_frame_.end()) {
+            result = std::distance(precache_worker_last_frame_.begin(), run);
+        } else {
+            for (size_t i = 1; i < precache_worker_load_.size(); i++) {
+                if (precache_worker_load_[i] < precache_worker_load_[result])
+                    result = i;
+            }
+        }
+    } else {
+        // frames are independent (e.g. image sequences), spread them out
+        result = next_precache_worker_++ % precache_workers_.size();
+    }
+
+    precache_worker_last_frame_[result] = frame;
+    return result;
+}
+
+void CachingMediaReaderActor::retrieve_cached_image(
+    const media::MediaKey &key,
+    std::function<void(const ImageBufPtr &)> on_retrieved,
+    std::function<void(const caf::error &)> on_error) {
+    if (shared_image_cache_) {
+        on_retrieved(shared_image_cache_->retrieve(key));
+    } else {
+        request(image_cache_, infinite, media_cache::retrieve_atom_v, key)
+            .then(
+                [=](const ImageBufPtr &buf) mutable { on_retrieved(buf); },
+                [=](const caf::error &err) mutable { on_error(err); });
+    }
+}
+
 void CachingMediaReaderActor::receive_image_buffer_request(
     const media::AVFrameID &mptr,
     caf::actor playhead,
     const utility::Uuid playhead_uuid,
-    const time_point &tp) {
+    const time_point &tp,
+    std::optional<ViewportView> view) {
 
     // first, check if the image we want is cached
-    request(image_cache_, infinite, media_cache::retrieve_atom_v, mptr.key_)
-        .then(
-            [=](media_reader::ImageBufPtr buf) mutable {
-                if (buf) {
-                    std::string path = uri_to_posix_path(mptr.uri_);
-                    // send the image back to the playhead that requested it
-                    send(playhead, push_image_atom_v, buf, mptr, tp);
-                } else {
-                    // image is not cached. Update the request to load the image
-                    pending_get_image_requests_[playhead_uuid] =
-                        ImmediateImageReqest(mptr, playhead, tp);
-                    send(this, get_image_atom_v);
-                }
-            },
-            [=](const caf::error &err) mutable {
-                spdlog::warn("Failed cache retrieve buffer {} {}", mptr.key_, to_string(err));
-            });
-}
\ No newline at end of file
+    retrieve_cached_image(
+        mptr.key_,
+        [=](media_reader::ImageBufPtr buf) mutable {
+            if (buf) {
+                std::string path = uri_to_posix_path(mptr.uri_);
+                // send the image back to the playhead that requested it
+                send(playhead, push_image_atom_v, buf, mptr, tp);
+            } else {
+                // image is not cached. Update the request to load the image
+                pending_get_image_requests_[playhead_uuid] =
+                    ImmediateImageReqest(mptr, playhead, tp, view);
+                send(this, get_image_atom_v);
+            }
+        },
+        [=](const caf::error &err) mutable {
+            spdlog::warn(
+                "Failed cache retrieve buffer {} {}", to_string(mptr.key_), to_string(err));
+        });
+}
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <cstdio>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "xstudio/atoms.hpp"
+#include "xstudio/broadcast/broadcast_actor.hpp"
+#include "xstudio/global_store/global_store.hpp"
+#include "xstudio/media_reader/disk_frame_cache.hpp"
+#include "xstudio/utility/helpers.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace caf;
+using namespace xstudio;
+using namespace xstudio::global_store;
+using namespace xstudio::media_reader;
+using namespace xstudio::utility;
+
+namespace {
+using file_ptr = std::unique_ptr<FILE, decltype(&fclose)>;
+
+file_ptr open_file(const fs::path &path, const char *mode) {
+    return file_ptr(fopen(path.c_str(), mode), &fclose);
+}
+} // namespace
+
+DiskFrameCache::DiskFrameCache(
+    const std::string &path, const size_t max_size, const int compression_level)
+    : max_size_(max_size), compression_level_(compression_level) {
+    set_path(path);
+}
+
+DiskFrameCache::~DiskFrameCache() { set_path(""); }
+
+void DiskFrameCache::set_path(const std::string &path) {
+    if (not cache_path_.empty()) {
+        clear();
+        std::error_code ec;
+        fs::remove_all(cache_path_, ec);
+        cache_path_.clear();
+    }
+
+    if (path.empty())
+        return;
+
+    // each process gets its own directory, the files are meaningless once
+    // the in memory index has gone.
+    auto cache_path = fs::path(expand_envvars(path)) / fmt::format("frames_{}", getpid());
+    std::error_code ec;
+    fs::remove_all(cache_path, ec);
+    if (not fs::create_directories(cache_path, ec)) {
+        spdlog::warn(
+            "{} Failed to create frame cache directory {} {}",
+            __PRETTY_FUNCTION__,
+            cache_path.string(),
+            ec.message());
+        return;
+    }
+    cache_path_ = cache_path;
+}
+
+void DiskFrameCache::set_max_size(const size_t max_size) {
+    max_size_ = max_size;
+    make_room(0);
+}
+
+void DiskFrameCache::touch(Entry &entry) {
+    least_recently_used_.erase(entry.last_used_);
+    entry.last_used_ = use_count_++;
+    least_recently_used_[entry.last_used_] = entry.image_->media_key();
+}
+
+void DiskFrameCache::make_room(const size_t size) {
+    while (not least_recently_used_.empty() and size_ + size > max_size_)
+        erase(least_recently_used_.begin()->second);
+}
+
+bool DiskFrameCache::store(const media::MediaKey &key, const ImageBufPtr &buf) {
+    if (not enabled() or not buf or not buf->size() or
+        buf->error_state() != NO_ERROR)
+        return false;
+
+    auto existing = entries_.find(key);
+    if (existing != entries_.end()) {
+        touch(existing->second);
+        return true;
+    }
+
+    const Bytef *data = reinterpret_cast<const Bytef *>(buf->buffer());
+    size_t file_size  = buf->size();
+    bool compressed   = false;
+    std::vector<Bytef> packed;
+
+    if (compression_level_ > 0) {
+        uLongf packed_size = compressBound(buf->size());
+        packed.resize(packed_size);
+        if (compress2(packed.data(), &packed_size, data, buf->size(), compression_level_) ==
+                Z_OK and
+            packed_size < buf->size()) {
+            data       = packed.data();
+            file_size  = packed_size;
+            compressed = true;
+        }
+    }
+
+    if (file_size > max_size_)
+        return false;
+    make_room(file_size);
+
+    const auto path = cache_path_ / fmt::format("{}.frame", file_id_++);
+    auto fp         = open_file(path, "wb");
+    if (not fp or fwrite(data, 1, file_size, fp.get()) != file_size) {
+        spdlog::warn("{} Failed to write {}", __PRETTY_FUNCTION__, path.string());
+        fp.reset();
+        std::error_code ec;
+        fs::remove(path, ec);
+        return false;
+    }
+
+    // keep everything but the pixels
+    Entry entry;
+    entry.image_ = ImageBufPtr(new ImageBuffer(*buf));
+    entry.image_->release_data();
+    entry.image_->set_media_key(key);
+    entry.file_       = path;
+    entry.file_size_  = file_size;
+    entry.data_size_  = buf->size();
+    entry.compressed_ = compressed;
+    entry.last_used_  = use_count_++;
+
+    least_recently_used_[entry.last_used_] = key;
+    entries_[key]                          = entry;
+    size_ += file_size;
+
+    return true;
+}
+
+ImageBufPtr DiskFrameCache::retrieve(const media::MediaKey &key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+        return ImageBufPtr();
+
+    auto &entry = it->second;
+    ImageBufPtr result(new ImageBuffer(*(entry.image_)));
+    auto *data = reinterpret_cast<Bytef *>(result->allocate(entry.data_size_));
+
+    bool ok = false;
+    if (auto fp = open_file(entry.file_, "rb")) {
+        if (entry.compressed_) {
+            std::vector<Bytef> packed(entry.file_size_);
+            uLongf data_size = entry.data_size_;
+            ok = fread(packed.data(), 1, packed.size(), fp.get()) == packed.size() and
+                 uncompress(data, &data_size, packed.data(), packed.size()) == Z_OK and
+                 data_size == entry.data_size_;
+        } else {
+            ok = fread(data, 1, entry.data_size_, fp.get()) == entry.data_size_;
+        }
+    }
+
+    if (not ok) {
+        spdlog::warn("{} Failed to read {}", __PRETTY_FUNCTION__, entry.file_.string());
+        erase(key);
+        return ImageBufPtr();
+    }
+
+    touch(entry);
+    return result;
+}
+
+void DiskFrameCache::erase(const media::MediaKey &key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+        return;
+
+    std::error_code ec;
+    fs::remove(it->second.file_, ec);
+    size_ -= it->second.file_size_;
+    least_recently_used_.erase(it->second.last_used_);
+    entries_.erase(it);
+}
+
+void DiskFrameCache::clear() {
+    while (not entries_.empty())
+        erase(entries_.begin()->first);
+}
+
+bool DiskFrameCacheGate::try_queue_write() {
+    int queued = queued_writes_;
+    while (queued < max_queued_writes) {
+        if (queued_writes_.compare_exchange_weak(queued, queued + 1))
+            return true;
+    }
+    return false;
+}
+
+DiskFrameCacheActor::DiskFrameCacheActor(caf::actor_config &cfg, DiskFrameCacheGatePtr gate)
+    : caf::event_based_actor(cfg), gate_(std::move(gate)) {
+
+    try {
+        auto prefs = GlobalStoreHelper(system());
+        JsonStore js;
+        join_broadcast(this, prefs.get_group(js));
+        update_preferences(js);
+    } catch (const std::exception &err) {
+        spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+    }
+
+    behavior_.assign(
+        [=](xstudio::broadcast::broadcast_down_atom, const caf::actor_addr &) {},
+
+        [=](json_store::update_atom,
+            const JsonStore & /*change*/,
+            const std::string & /*path*/,
+            const JsonStore &full) {
+            delegate(actor_cast<caf::actor>(this), json_store::update_atom_v, full);
+        },
+
+        [=](json_store::update_atom, const JsonStore &js) { update_preferences(js); },
+
+        [=](media_cache::store_atom, const media::MediaKey &key, const ImageBufPtr &buf)
+            -> bool {
+            const bool stored = cache_.store(key, buf);
+            if (gate_)
+                gate_->write_done();
+            return stored;
+        },
+
+        [=](media_cache::retrieve_atom, const media::MediaKey &key) -> ImageBufPtr {
+            return cache_.retrieve(key);
+        },
+
+        [=](media_cache::erase_atom, const media::MediaKey &key) { cache_.erase(key); },
+
+        [=](clear_atom) -> bool {
+            cache_.clear();
+            return true;
+        },
+
+        [=](media_cache::count_atom) -> size_t { return cache_.count(); },
+
+        [=](media_cache::size_atom) -> size_t { return cache_.size(); });
+}
+
+void DiskFrameCacheActor::on_exit() { cache_.set_path(""); }
+
+void DiskFrameCacheActor::update_preferences(const JsonStore &js) {
+    try {
+        const auto path = preference_value<std::string>(js, "/core/image_cache/disk_cache_path");
+        cache_.set_compression_level(
+            preference_value<int>(js, "/core/image_cache/disk_cache_compression"));
+        cache_.set_max_size(
+            preference_value<size_t>(js, "/core/image_cache/disk_cache_size") * 1024 * 1024);
+        if (path != path_) {
+            path_ = path;
+            cache_.set_path(path_);
+        }
+        if (gate_)
+            gate_->set_enabled(cache_.enabled());
+    } catch (const std::exception &err) {
+        spdlog::warn("{} {}", __PRETTY_FUNCTION__, err.what());
+    }
+}
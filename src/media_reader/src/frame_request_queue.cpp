@@ -5,115 +5,110 @@
 using namespace xstudio::media_reader;
 using namespace xstudio;
 
-void FrameRequestQueue::add_frame_request(
-    const media::AVFrameID &frame_info,
+void FrameRequestQueue::add(
+    std::shared_ptr<const media::AVFrameID> frame,
     const utility::time_point &required_by,
     const utility::Uuid &requesting_playhead_uuid) {
 
-    // auto tt = utility::clock::now();
-    // spdlog::warn("{}",to_string(frame_info.uri_));
-
-    bool matches_existing_request = false;
-    for (auto pp = queue_.rbegin(); pp != queue_.rend(); ++pp) {
-
-        if ((*pp)->requested_frame_->frame_ == frame_info.frame_ &&
-            (*pp)->requested_frame_->uri_ == frame_info.uri_) {
-            if ((*pp)->required_by_ > required_by) {
-                (*pp)->required_by_ = required_by;
-            }
-            matches_existing_request = true;
-            break;
+    auto &requests = playheads_[requesting_playhead_uuid];
+    const auto key = frame->key_;
+
+    auto existing = requests.by_key_.find(key);
+    if (existing != requests.by_key_.end()) {
+        // already asked for, move it forward if it's needed sooner
+        if (existing->second.first > required_by) {
+            auto node                  = requests.by_deadline_.extract(existing->second);
+            node.key()                 = Deadline(required_by, node.key().second);
+            node.mapped().required_by_ = required_by;
+            existing->second           = node.key();
+            requests.by_deadline_.insert(std::move(node));
         }
+        return;
     }
 
-    if (!matches_existing_request) {
-
-        queue_.emplace_back(new FrameRequest(
-            std::shared_ptr<const media::AVFrameID>(new media::AVFrameID(frame_info)),
-            required_by,
-            requesting_playhead_uuid));
-    }
+    const Deadline deadline(required_by, sequence_++);
+    requests.by_deadline_.emplace(
+        deadline, FrameRequest(std::move(frame), required_by, requesting_playhead_uuid));
+    requests.by_key_.emplace(key, deadline);
+    size_++;
+}
 
-    std::sort(
-        queue_.begin(),
-        queue_.end(),
-        [](const std::shared_ptr<FrameRequest> &a, const std::shared_ptr<FrameRequest> &b)
-            -> bool { return a->required_by_ < b->required_by_; });
+void FrameRequestQueue::add_frame_request(
+    const media::AVFrameID &frame_info,
+    const utility::time_point &required_by,
+    const utility::Uuid &requesting_playhead_uuid) {
+    add(std::make_shared<const media::AVFrameID>(frame_info),
+        required_by,
+        requesting_playhead_uuid);
 }
 
 void FrameRequestQueue::add_frame_requests(
     const media::AVFrameIDsAndTimePoints &frames_info,
     const utility::Uuid &requesting_playhead_uuid) {
 
-    for (const auto &p : frames_info) {
-        const std::shared_ptr<const media::AVFrameID> &frame_info = (p.second);
-        const utility::time_point &required_by                    = p.first;
-        queue_.emplace_back(
-            new FrameRequest(frame_info, required_by, requesting_playhead_uuid));
+    for (const auto &p : frames_info)
+        add(p.second, p.first, requesting_playhead_uuid);
+}
+
+std::optional<FrameRequest> FrameRequestQueue::pop_request(
+    const std::map<utility::Uuid, int> &requests_in_flight, const int max_in_flight) {
+
+    // the soonest needed request from any playhead that has room for another
+    // request in flight. There are only ever a handful of playheads.
+    auto next = playheads_.end();
+    for (auto p = playheads_.begin(); p != playheads_.end(); p++) {
+        auto in_flight = requests_in_flight.find(p->first);
+        if (in_flight != requests_in_flight.end() && in_flight->second >= max_in_flight)
+            continue;
+        if (next == playheads_.end() or
+            p->second.by_deadline_.begin()->first < next->second.by_deadline_.begin()->first)
+            next = p;
     }
 
-    std::sort(
-        queue_.begin(),
-        queue_.end(),
-        [](const std::shared_ptr<FrameRequest> &a, const std::shared_ptr<FrameRequest> &b)
-            -> bool { return a->required_by_ < b->required_by_; });
-}
+    if (next == playheads_.end())
+        return {};
 
-std::optional<FrameRequest>
-FrameRequestQueue::pop_request(const std::map<utility::Uuid, int> &exclude_playheads) {
-    std::optional<FrameRequest> rt = {};
+    auto &requests = next->second;
+    auto front     = requests.by_deadline_.begin();
+    std::optional<FrameRequest> rt(std::move(front->second));
+    requests.by_key_.erase(rt->requested_frame_->key_);
+    requests.by_deadline_.erase(front);
+    if (requests.by_deadline_.empty())
+        playheads_.erase(next);
+    size_--;
 
-    for (auto p = queue_.begin(); p != queue_.end(); p++) {
-        if (!exclude_playheads.count((*p)->requesting_playhead_uuid_)) {
-            rt = *(*p);
-            queue_.erase(p);
-            break;
-        }
-    }
     return rt;
 }
 
 void FrameRequestQueue::prune_stale_frame_requests() {
 
-    auto now = utility::clock::now();
-    // bool found_stale_request = false;
-    for (auto pp = queue_.begin(); pp != queue_.end(); ++pp) {
-        if (queue_.size() > 20) { //&& (*pp).required_by < now) {
-            auto ppp = pp;
-            ppp++;
-            if (ppp != queue_.end() && (*ppp)->required_by_ < now) {
-                pp = queue_.erase(pp);
+    // for each playhead drop the requests needed in the past, apart from the
+    // most recent of them
+    const Deadline now(utility::clock::now(), 0);
+    for (auto p = playheads_.begin(); p != playheads_.end();) {
+        auto &requests = p->second;
+        auto stale_end = requests.by_deadline_.lower_bound(now);
+        if (stale_end != requests.by_deadline_.begin()) {
+            --stale_end;
+            for (auto r = requests.by_deadline_.begin(); r != stale_end;) {
+                requests.by_key_.erase(r->second.requested_frame_->key_);
+                r = requests.by_deadline_.erase(r);
+                size_--;
             }
         }
+
+        if (requests.by_deadline_.empty())
+            p = playheads_.erase(p);
+        else
+            p++;
     }
 }
 
 void FrameRequestQueue::clear_pending_requests(const utility::Uuid &playhead_uuid) {
 
-    queue_.erase(
-        std::remove_if(
-            queue_.begin(),
-            queue_.end(),
-            [&playhead_uuid](const std::shared_ptr<FrameRequest> &x) {
-                return x->requesting_playhead_uuid_ == playhead_uuid; // put your condition here
-            }),
-        queue_.end());
-
-    /*auto pp = queue_.begin();
-    auto a = queue_.end();
-    auto b = queue_.end();
-
-    while (pp != queue_.end()) {
-        if ((*pp)->requesting_playhead_uuid_ == playhead_uuid) {
-            if (a == queue_.end()) {
-                a = pp;
-            }
-            b = pp;
-        } else {
-            if (a != queue_.end()) {
-                queue_.erase(a, b);
-            }
-            pp++;
-        }
-    }*/
-}
\ No newline at end of file
+    auto p = playheads_.find(playhead_uuid);
+    if (p != playheads_.end()) {
+        size_ -= p->second.by_deadline_.size();
+        playheads_.erase(p);
+    }
+}
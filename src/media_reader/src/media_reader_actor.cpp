@@ -7,7 +7,9 @@
 #include "xstudio/atoms.hpp"
 #include "xstudio/global_store/global_store.hpp"
 #include "xstudio/media/caf_media_error.hpp"
+#include "xstudio/media_cache/media_cache_actor.hpp"
 #include "xstudio/media_reader/cacheing_media_reader_actor.hpp"
+#include "xstudio/media_reader/disk_frame_cache.hpp"
 #include "xstudio/media_reader/media_detail_and_thumbnail_reader_actor.hpp"
 #include "xstudio/media_reader/media_reader_actor.hpp"
 #include "xstudio/plugin_manager/plugin_manager.hpp"
@@ -32,6 +34,14 @@ using namespace xstudio::media_cache;
 namespace {
 using map_addr_timepoint = std::map<std::string, utility::time_point>;
 using workers_t          = std::list<std::shared_ptr<std::pair<caf::actor, int>>>;
+
+const auto cache_store_batch_window = std::chrono::milliseconds(2);
+const size_t max_cache_store_batch  = 32;
+
+// idle precache frames are fetched from the playhead this many at a time, the
+// next lot is fetched when fewer than static_precache_low_water are waiting
+const int static_precache_chunk_size  = 256;
+const size_t static_precache_low_water = 64;
 } // namespace
 
 
@@ -78,7 +88,8 @@ ReaderHelper::ReaderHelper(
                     return spawn<CachingMediaReaderActor>(
                         uuid,
                         system().registry().template get<caf::actor>(image_cache_registry),
-                        system().registry().template get<caf::actor>(audio_cache_registry));
+                        system().registry().template get<caf::actor>(audio_cache_registry),
+                        _uri);
                 } catch (...) {
                     // shutting down
                     return make_error(sec::runtime_error, "Shutting down");
@@ -118,7 +129,8 @@ ReaderHelper::ReaderHelper(
                                         system().registry().template get<caf::actor>(
                                             image_cache_registry),
                                         system().registry().template get<caf::actor>(
-                                            audio_cache_registry)));
+                                            audio_cache_registry),
+                                        _uri));
                                 } catch (...) {
                                     // shutting down
                                     return rp.deliver(
@@ -155,6 +167,10 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
             max_source_count_ =
                 preference_value<size_t>(js, "/core/media_reader/max_source_count");
             max_source_age_ = preference_value<size_t>(js, "/core/media_reader/max_source_age");
+            max_inflight_per_playhead_ = std::max(
+                1, preference_value<int>(js, "/core/media_reader/max_inflight_per_playhead"));
+            MediaKey::set_intern_names(
+                preference_value<bool>(js, "/core/media_reader/intern_media_key_names"));
         } catch (...) {
         }
 
@@ -188,6 +204,35 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
     image_cache_ = system().registry().template get<caf::actor>(image_cache_registry);
     audio_cache_ = system().registry().template get<caf::actor>(audio_cache_registry);
 
+    try {
+        scoped_actor sys{system()};
+        shared_image_cache_ = request_receive<media_cache::SharedImageCachePtr>(
+            *sys, image_cache_, media_cache::get_shared_cache_atom_v);
+    } catch (const std::exception &err) {
+        // fall back to messaging the cache actor
+        spdlog::debug("{} {}", __PRETTY_FUNCTION__, err.what());
+    }
+
+    // frames pushed out of the RAM cache go to the disk cache (if one is
+    // configured) and are looked for there before we go back to the reader.
+    // With no disk cache neither costs more than a flag check.
+    disk_cache_gate_ = std::make_shared<DiskFrameCacheGate>();
+    disk_cache_      = spawn<DiskFrameCacheActor>(disk_cache_gate_);
+    link_to(disk_cache_);
+    if (shared_image_cache_) {
+        auto disk_cache = caf::actor_cast<caf::actor_addr>(disk_cache_);
+        shared_image_cache_->bind_eviction_callback(
+            [disk_cache, gate = disk_cache_gate_](
+                const media::MediaKey &key, const ImageBufPtr &buf) {
+                if (not gate->enabled() or not gate->try_queue_write())
+                    return;
+                if (auto a = caf::actor_cast<caf::actor>(disk_cache))
+                    anon_send(a, media_cache::store_atom_v, key, buf);
+                else
+                    gate->write_done();
+            });
+    }
+
     auto media_detail_and_thumbnail_reader_pool = caf::actor_pool::make(
         system().dummy_execution_unit(),
         4, // hardcoding to 4 media detail fetchers
@@ -200,7 +245,7 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
 
         [=](clear_precache_queue_atom, const Uuid &playhead_uuid) -> bool {
             playback_precache_request_queue_.clear_pending_requests(playhead_uuid);
-            background_precache_request_queue_.clear_pending_requests(playhead_uuid);
+            stop_static_precache(playhead_uuid);
 
             // this marks all cache entries for this playhead as 'stale' by
             // moving their timestamps to 1 hour in the past - hence they
@@ -219,7 +264,7 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
             for (const auto &playhead_uuid : playhead_uuids) {
 
                 playback_precache_request_queue_.clear_pending_requests(playhead_uuid);
-                background_precache_request_queue_.clear_pending_requests(playhead_uuid);
+                stop_static_precache(playhead_uuid);
                 // this marks all cache entries for this playhead as 'stale' by
                 // moving their timestamps to 1 hour in the past - hence they
                 // will be dropped if the cache fills up
@@ -242,79 +287,69 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
                 pin, // stamp the frame 10 minutes in the future so it sticks in the cache
             const utility::Uuid &playhead_uuid) -> result<ImageBufPtr> {
             auto rp = make_response_promise<media_reader::ImageBufPtr>();
-            request(image_cache_, infinite, media_cache::retrieve_atom_v, mptr.key_)
-                .then(
-                    [=](media_reader::ImageBufPtr buf) mutable {
-                        if (buf) {
-                            rp.deliver(buf);
+            retrieve_cached_image(
+                mptr.key_,
+                [=](media_reader::ImageBufPtr buf) mutable {
+                    if (buf) {
+                        rp.deliver(buf);
+                    } else {
+                        // check for existing reader.
+                        auto reader = check_cached_reader(reader_key(mptr.uri_, mptr.actor_addr_));
+
+                        if (reader) {
+                            // was using await, not sure why, but I've changed it to then
+                            request(*reader, infinite, get_image_atom_v, mptr, pin, playhead_uuid)
+                                .then(
+                                    [=](media_reader::ImageBufPtr buf) mutable { rp.deliver(buf); },
+                                    [=](const caf::error &err) mutable {
+                                        // make an empty image buffer that holds the error
+                                        // message
+                                        media_reader::ImageBufPtr buf(
+                                            new media_reader::ImageBuffer(to_string(err)));
+                                        rp.deliver(err);
+                                    });
                         } else {
-                            // check for existing reader.
-                            auto reader =
-                                check_cached_reader(reader_key(mptr.uri_, mptr.actor_addr_));
-
-                            if (reader) {
-                                // was using await, not sure why, but I've changed it to then
-                                request(
-                                    *reader,
-                                    infinite,
-                                    get_image_atom_v,
-                                    mptr,
-                                    pin,
-                                    playhead_uuid)
-                                    .then(
-                                        [=](media_reader::ImageBufPtr buf) mutable {
-                                            rp.deliver(buf);
-                                        },
-                                        [=](const caf::error &err) mutable {
-                                            // make an empty image buffer that holds the error
-                                            // message
-                                            media_reader::ImageBufPtr buf(
-                                                new media_reader::ImageBuffer(to_string(err)));
-                                            rp.deliver(err);
-                                        });
-                            } else {
-                                // request new reader instance.
-                                request(
-                                    pool_, infinite, get_reader_atom_v, mptr.uri_, mptr.reader_)
-                                    .then(
-                                        [=](caf::actor &new_reader) mutable {
-                                            new_reader = add_reader(
-                                                new_reader,
-                                                reader_key(mptr.uri_, mptr.actor_addr_));
-
-                                            // was using await, not sure why, but I've changed
-                                            // it to then
-                                            request(
-                                                new_reader,
-                                                infinite,
-                                                get_image_atom_v,
-                                                mptr,
-                                                pin,
-                                                playhead_uuid)
-                                                .then(
-                                                    [=](media_reader::ImageBufPtr buf) mutable {
-                                                        rp.deliver(buf);
-                                                    },
-                                                    [=](const caf::error &err) mutable {
-                                                        // make an empty image buffer that holds
-                                                        // the error message
-                                                        media_reader::ImageBufPtr buf(
-                                                            new media_reader::ImageBuffer(
-                                                                to_string(err)));
-                                                        rp.deliver(err);
-                                                    });
-                                        },
-                                        [=](const caf::error &err) mutable {
-                                            send_error_to_source(mptr.actor_addr_, err);
-
-                                            media_reader::ImageBufPtr buf(
-                                                new media_reader::ImageBuffer(to_string(err)));
-                                            rp.deliver(err);
-                                        });
-                            }
+                            // request new reader instance.
+                            request(pool_, infinite, get_reader_atom_v, mptr.uri_, mptr.reader_)
+                                .then(
+                                    [=](caf::actor &new_reader) mutable {
+                                        new_reader = add_reader(
+                                            new_reader,
+                                            reader_key(mptr.uri_, mptr.actor_addr_));
+
+                                        // was using await, not sure why, but I've changed
+                                        // it to then
+                                        request(
+                                            new_reader,
+                                            infinite,
+                                            get_image_atom_v,
+                                            mptr,
+                                            pin,
+                                            playhead_uuid)
+                                            .then(
+                                                [=](media_reader::ImageBufPtr buf) mutable {
+                                                    rp.deliver(buf);
+                                                },
+                                                [=](const caf::error &err) mutable {
+                                                    // make an empty image buffer that holds
+                                                    // the error message
+                                                    media_reader::ImageBufPtr buf(
+                                                        new media_reader::ImageBuffer(
+                                                            to_string(err)));
+                                                    rp.deliver(err);
+                                                });
+                                    },
+                                    [=](const caf::error &err) mutable {
+                                        send_error_to_source(mptr.actor_addr_, err);
+
+                                        media_reader::ImageBufPtr buf(
+                                            new media_reader::ImageBuffer(to_string(err)));
+                                        rp.deliver(err);
+                                    });
                         }
-                    },
-                    [=](const caf::error &err) mutable { rp.deliver(err); });
+                    }
+                },
+                [=](const caf::error &err) mutable { rp.deliver(err); });
 
             return rp;
         },
@@ -350,53 +385,35 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
             const utility::time_point &tp,
             const int /*logical_frame*/
         ) {
-            request(image_cache_, infinite, media_cache::retrieve_atom_v, mptr.key_)
-                .then(
-                    [=](const media_reader::ImageBufPtr &buf) mutable {
-                        if (buf) {
-                            send(playhead, push_image_atom_v, buf, mptr, tp);
-                        } else {
-                            auto reader =
-                                check_cached_reader(reader_key(mptr.uri_, mptr.actor_addr_));
-                            if (reader) {
-                                anon_send(
-                                    *reader,
-                                    get_image_atom_v,
-                                    mptr,
-                                    playhead,
-                                    playhead_uuid,
-                                    tp);
-                            } else {
-                                // get reader..
-                                request(
-                                    pool_, infinite, get_reader_atom_v, mptr.uri_, mptr.reader_)
-                                    .then(
-                                        [=](caf::actor &new_reader) mutable {
-                                            new_reader = add_reader(
-                                                new_reader,
-                                                reader_key(mptr.uri_, mptr.actor_addr_));
-                                            anon_send(
-                                                new_reader,
-                                                get_image_atom_v,
-                                                mptr,
-                                                playhead,
-                                                playhead_uuid,
-                                                tp);
-                                        },
-                                        [=](const caf::error &err) mutable {
-                                            send_error_to_source(mptr.actor_addr_, err);
-
-                                            media_reader::ImageBufPtr buf(
-                                                new media_reader::ImageBuffer(to_string(err)));
-                                            send(playhead, push_image_atom_v, buf, mptr, tp);
-                                        });
-                            }
-                        }
-                    },
-                    [=](const caf::error &err) mutable {
-                        spdlog::warn(
-                            "Failed cache retrieve buffer {} {}", mptr.key_, to_string(err));
-                    });
+            get_urgent_image(mptr, playhead, tp, [=](caf::actor reader) {
+                anon_send(reader, get_image_atom_v, mptr, playhead, playhead_uuid, tp);
+            });
+        },
+
+        // as above, but the reader may load only what the viewport shows
+        [=](get_image_atom,
+            const media::AVFrameID &mptr,
+            caf::actor playhead,
+            const utility::Uuid playhead_uuid,
+            const utility::time_point &tp,
+            const int /*logical_frame*/,
+            const Imath::V2f &viewport_visible_min,
+            const Imath::V2f &viewport_visible_max,
+            const Imath::V2i &viewport_size_screen_pixels,
+            const Imath::M44f &image_transform) {
+            get_urgent_image(mptr, playhead, tp, [=](caf::actor reader) {
+                anon_send(
+                    reader,
+                    get_image_atom_v,
+                    mptr,
+                    playhead,
+                    playhead_uuid,
+                    tp,
+                    viewport_visible_min,
+                    viewport_visible_max,
+                    viewport_size_screen_pixels,
+                    image_transform);
+            });
         },
 
         [=](get_media_detail_atom _get_media_detail_atom,
@@ -421,6 +438,11 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
                 preference_value<size_t>(json, "/core/media_reader/max_source_count");
             max_source_age_ =
                 preference_value<size_t>(json, "/core/media_reader/max_source_age");
+            try {
+                max_inflight_per_playhead_ = std::max(
+                    1, preference_value<int>(json, "/core/media_reader/max_inflight_per_playhead"));
+            } catch (...) {
+            }
             // mmm_->update_preferences(json);
             prune_readers();
         },
@@ -442,49 +464,68 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
             // start reading/decoding those frames
 
 
-            auto rp = make_response_promise<bool>();
+            // Both caches are asked in one go and we carry on when both have
+            // answered, without blocking this actor in the meantime. The image
+            // cache is normally checked directly, leaving one message to the
+            // audio cache.
+            auto rp         = make_response_promise<bool>();
+            auto not_cached = std::make_shared<media::AVFrameIDsAndTimePoints>();
+            auto replies    = std::make_shared<int>(2);
+
+            auto on_cache_checked =
+                [=](const media::AVFrameIDsAndTimePoints &media_ptrs_not_in_cache) mutable {
+                    not_cached->insert(
+                        not_cached->end(),
+                        media_ptrs_not_in_cache.begin(),
+                        media_ptrs_not_in_cache.end());
+                    if (--(*replies))
+                        return;
+
+                    if (not not_cached->empty()) {
+                        // clear all pending requests
+                        playback_precache_request_queue_.clear_pending_requests(playhead_uuid);
+                        stop_static_precache(playhead_uuid);
+
+                        playback_precache_request_queue_.add_frame_requests(
+                            *not_cached, playhead_uuid);
+
+                        if (media_ptrs.size())
+                            background_cached_ref_timepoint_[playhead_uuid] =
+                                media_ptrs.front().first;
+                        continue_precacheing();
+                    }
+                    rp.deliver(true);
+                };
+            auto on_error = [=](const caf::error &err) mutable {
+                if (rp.pending())
+                    rp.deliver(err);
+            };
+
+            if (shared_image_cache_) {
+                media::AVFrameIDsAndTimePoints media_ptrs_not_in_image_cache;
+                for (const auto &p : media_ptrs) {
+                    if (!shared_image_cache_->preserve(p.second->key_, p.first, playhead_uuid))
+                        media_ptrs_not_in_image_cache.push_back(p);
+                }
+                on_cache_checked(media_ptrs_not_in_image_cache);
+            } else {
+                request(
+                    image_cache_,
+                    std::chrono::seconds(1),
+                    media_cache::preserve_atom_v,
+                    media_ptrs,
+                    playhead_uuid)
+                    .then(on_cache_checked, on_error);
+            }
+
             request(
-                image_cache_,
+                audio_cache_,
                 std::chrono::seconds(1),
                 media_cache::preserve_atom_v,
                 media_ptrs,
                 playhead_uuid)
-                .await(
-                    [=](const media::AVFrameIDsAndTimePoints
-                            media_ptrs_not_in_image_cache) mutable {
-                        request(
-                            audio_cache_,
-                            std::chrono::seconds(1),
-                            media_cache::preserve_atom_v,
-                            media_ptrs,
-                            playhead_uuid)
-                            .await(
-                                [=](const media::AVFrameIDsAndTimePoints
-                                        &media_ptrs_not_in_audio_cache) mutable {
-                                    if (media_ptrs_not_in_image_cache.size() ||
-                                        media_ptrs_not_in_audio_cache.size()) {
-
-                                        // clear all pending requests
-                                        playback_precache_request_queue_.clear_pending_requests(
-                                            playhead_uuid);
-                                        background_precache_request_queue_
-                                            .clear_pending_requests(playhead_uuid);
-
-                                        playback_precache_request_queue_.add_frame_requests(
-                                            media_ptrs_not_in_image_cache, playhead_uuid);
-                                        playback_precache_request_queue_.add_frame_requests(
-                                            media_ptrs_not_in_audio_cache, playhead_uuid);
-
-                                        if (media_ptrs.size())
-                                            background_cached_ref_timepoint_[playhead_uuid] =
-                                                media_ptrs.front().first;
-                                        continue_precacheing();
-                                    }
-                                    rp.deliver(true);
-                                },
-                                [=](const caf::error &err) mutable { rp.deliver(err); });
-                    },
-                    [=](const caf::error &err) mutable { rp.deliver(err); });
+                .then(on_cache_checked, on_error);
+
             return rp;
         },
 
@@ -502,8 +543,7 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
                 request(image_cache_, infinite, media_cache::unpreserve_atom_v, playhead_uuid)
                     .then(
                         [=](bool) mutable {
-                            background_precache_request_queue_.clear_pending_requests(
-                                playhead_uuid);
+                            stop_static_precache(playhead_uuid);
                             playback_precache_request_queue_.clear_pending_requests(
                                 playhead_uuid);
                             background_precache_request_queue_.add_frame_requests(
@@ -515,12 +555,33 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
                         },
                         [=](const caf::error &err) mutable { rp.deliver(err); });
             } else {
-                background_precache_request_queue_.clear_pending_requests(playhead_uuid);
+                stop_static_precache(playhead_uuid);
                 rp.deliver(false);
             }
             return rp;
         },
 
+        [=](static_precache_atom,
+            caf::actor frame_source,
+            const Uuid playhead_uuid) -> result<bool> {
+            // as above, but rather than being sent every frame up front we
+            // pull them from the playhead a chunk at a time while the cache
+            // has room for them.
+            auto rp = make_response_promise<bool>();
+            request(image_cache_, infinite, media_cache::unpreserve_atom_v, playhead_uuid)
+                .then(
+                    [=](bool) mutable {
+                        stop_static_precache(playhead_uuid);
+                        playback_precache_request_queue_.clear_pending_requests(playhead_uuid);
+                        static_precache_cursors_[playhead_uuid] =
+                            StaticPrecacheCursor(frame_source, next_static_precache_id_++);
+                        continue_precacheing();
+                        rp.deliver(true);
+                    },
+                    [=](const caf::error &err) mutable { rp.deliver(err); });
+            return rp;
+        },
+
         [=](retire_readers_atom) {
             prune_readers();
             delayed_anon_send(
@@ -529,6 +590,11 @@ GlobalMediaReaderActor::GlobalMediaReaderActor(
 
         [=](do_precache_work_atom) { do_precache(); },
 
+        [=](flush_cache_stores_atom) {
+            store_flush_pending_ = false;
+            flush_cache_stores();
+        },
+
         [=](utility::uuid_atom) -> Uuid { return uuid_; });
 }
 
@@ -637,25 +703,84 @@ void GlobalMediaReaderActor::prune_readers() {
     }
 }
 
-void GlobalMediaReaderActor::on_exit() { system().registry().erase(media_reader_registry); }
+void GlobalMediaReaderActor::on_exit() {
+    if (shared_image_cache_)
+        shared_image_cache_->bind_eviction_callback(nullptr);
+    system().registry().erase(media_reader_registry);
+}
+
+void GlobalMediaReaderActor::stop_static_precache(const utility::Uuid &playhead_uuid) {
+    background_precache_request_queue_.clear_pending_requests(playhead_uuid);
+    static_precache_cursors_.erase(playhead_uuid);
+}
+
+void GlobalMediaReaderActor::fetch_static_precache_frames() {
+
+    for (auto &[playhead_uuid, cursor] : static_precache_cursors_) {
+        if (cursor.fetching_ or
+            background_precache_request_queue_.size(playhead_uuid) >= static_precache_low_water)
+            continue;
+
+        cursor.fetching_ = true;
+        const auto uuid  = playhead_uuid;
+        const auto id    = cursor.id_;
+
+        request(cursor.source_, infinite, static_precache_atom_v, static_precache_chunk_size)
+            .then(
+                [=](const media::AVFrameIDsAndTimePoints &mptrs) mutable {
+                    // ignore frames for a precache that has since been stopped
+                    // or restarted
+                    auto c = static_precache_cursors_.find(uuid);
+                    if (c == static_precache_cursors_.end() or c->second.id_ != id)
+                        return;
+
+                    if (mptrs.empty()) {
+                        // the playhead has given us its whole loop range
+                        static_precache_cursors_.erase(c);
+                        return;
+                    }
+
+                    // Keep a note of the timepoint of the first frame - anything
+                    // with an older time in the cache can be discarded when the
+                    // cache is full
+                    if (not c->second.fetched_)
+                        background_cached_ref_timepoint_[uuid] = mptrs.front().first;
+                    c->second.fetching_ = false;
+                    c->second.fetched_  = true;
+
+                    background_precache_request_queue_.add_frame_requests(mptrs, uuid);
+                    continue_precacheing();
+                },
+                [=](const caf::error &err) mutable {
+                    auto c = static_precache_cursors_.find(uuid);
+                    if (c != static_precache_cursors_.end() and c->second.id_ == id)
+                        static_precache_cursors_.erase(c);
+                    spdlog::debug("{} {}", __PRETTY_FUNCTION__, to_string(err));
+                });
+    }
+}
 
 void GlobalMediaReaderActor::do_precache() {
 
-    // We won't process a new request if there are already precache requests in
-    // flight for a given playhead. The reason is the async nature of CAF ...
-    // we could send 100s of requests to precache frames (sending messages is
-    // fast) before frames can actually be read, decoded and cached (because
+    // top up the idle precache queues before taking the next request
+    fetch_static_precache_frames();
+
+    // We won't process a new request if there are already enough precache
+    // requests in flight for a given playhead. The reason is the async nature of
+    // CAF ... we could send 100s of requests to precache frames (sending messages
+    // is fast) before frames can actually be read, decoded and cached (because
     // reading frames is slow) - we would then be in a situation where the CAF
-    // mailbox is full of requests to precache frames
+    // mailbox is full of requests to precache frames. A small window of
+    // requests does let the readers decode several frames at once though.
     std::optional<FrameRequest> fr = playback_precache_request_queue_.pop_request(
-        playheads_with_precache_requests_in_flight_);
+        playheads_with_precache_requests_in_flight_, max_inflight_per_playhead_);
 
     // when putting new images in the cache, images older than this timepoint can
     // be discarded
     bool is_background_cache = false;
     if (not fr) {
         fr = background_precache_request_queue_.pop_request(
-            playheads_with_precache_requests_in_flight_);
+            playheads_with_precache_requests_in_flight_, max_inflight_per_playhead_);
 
 
         if (not fr) {
@@ -689,6 +814,60 @@ void GlobalMediaReaderActor::do_precache() {
         mptr->media_type_ == media::MediaType::MT_IMAGE ? image_cache_ : audio_cache_;
     mark_playhead_waiting_for_precache_result(playhead_uuid);
 
+    auto on_preserved = [=](const bool exists) mutable {
+        if (exists) {
+            // already have in the cache, but might still have work to do
+            mark_playhead_received_precache_result(playhead_uuid);
+            // if (is_background_cache) {
+            // keep_cache_hot(mptr.key_, predicted_time, playhead_uuid);
+            // }
+            continue_precacheing();
+        } else {
+            try {
+                auto reader = get_reader(mptr->uri_, mptr->actor_addr_, mptr->reader_);
+                if (not reader) {
+                    mark_playhead_received_precache_result(playhead_uuid);
+                    continue_precacheing();
+                } else {
+                    if (cache_actor == image_cache_) {
+                        read_and_cache_image(
+                            reader,
+                            *fr,
+                            cache_out_of_date_threshold,
+                            is_background_cache);
+                    } else {
+                        read_and_cache_audio(
+                            reader,
+                            *fr,
+                            cache_out_of_date_threshold,
+                            is_background_cache);
+                    }
+                    // fill up the rest of the in flight window
+                    continue_precacheing();
+                }
+            } catch (std::exception &) {
+                // we have been unable to create a reader - the file is
+                // unreadable for some reason. We do not want to report an
+                // error because we are currently pre-cacheing. The error
+                // *will* get reported when we actaully want to show the
+                // image as an immediate frame request wlil be made as the
+                // image isn't in the cache, and at that point error message
+                // propagation will give the user feedback about the frame
+                // being unreadable
+
+                // shouldn't it continue... ?
+                // mark_playhead_received_precache_result(playhead_uuid);
+                // continue_precacheing();
+            }
+        }
+    };
+
+    // images can be checked directly in the shared cache without a round trip
+    if (shared_image_cache_ and cache_actor == image_cache_) {
+        on_preserved(shared_image_cache_->preserve(mptr->key_, predicted_time, playhead_uuid));
+        return;
+    }
+
     request(
         cache_actor,
         std::chrono::milliseconds(500),
@@ -696,57 +875,64 @@ void GlobalMediaReaderActor::do_precache() {
         mptr->key_,
         predicted_time,
         playhead_uuid)
-        .then(
+        .then(on_preserved, [=](const caf::error &err) {
+            mark_playhead_received_precache_result(playhead_uuid);
+            spdlog::warn(
+                "Failed preserve buffer {} {}", to_string(mptr->key_), to_string(err));
+        });
+}
 
-            [=](const bool exists) mutable {
-                if (exists) {
-                    // already have in the cache, but might still have work to do
-                    mark_playhead_received_precache_result(playhead_uuid);
-                    // if (is_background_cache) {
-                    // keep_cache_hot(mptr.key_, predicted_time, playhead_uuid);
-                    // }
-                    continue_precacheing();
+void GlobalMediaReaderActor::retrieve_cached_image(
+    const media::MediaKey &key,
+    std::function<void(const ImageBufPtr &)> on_retrieved,
+    std::function<void(const caf::error &)> on_error) {
+    if (shared_image_cache_) {
+        on_retrieved(shared_image_cache_->retrieve(key));
+    } else {
+        request(image_cache_, infinite, media_cache::retrieve_atom_v, key)
+            .then(
+                [=](const ImageBufPtr &buf) mutable { on_retrieved(buf); },
+                [=](const caf::error &err) mutable { on_error(err); });
+    }
+}
+
+void GlobalMediaReaderActor::get_urgent_image(
+    const media::AVFrameID &mptr,
+    caf::actor playhead,
+    const utility::time_point &tp,
+    std::function<void(caf::actor)> send_request) {
+    retrieve_cached_image(
+        mptr.key_,
+        [=](const media_reader::ImageBufPtr &buf) mutable {
+            if (buf) {
+                send(playhead, push_image_atom_v, buf, mptr, tp);
+            } else {
+                auto reader = check_cached_reader(reader_key(mptr.uri_, mptr.actor_addr_));
+                if (reader) {
+                    send_request(*reader);
                 } else {
-                    try {
-                        auto reader = get_reader(mptr->uri_, mptr->actor_addr_, mptr->reader_);
-                        if (not reader) {
-                            mark_playhead_received_precache_result(playhead_uuid);
-                            continue_precacheing();
-                        } else {
-                            if (cache_actor == image_cache_) {
-                                read_and_cache_image(
-                                    reader,
-                                    *fr,
-                                    cache_out_of_date_threshold,
-                                    is_background_cache);
-                            } else {
-                                read_and_cache_audio(
-                                    reader,
-                                    *fr,
-                                    cache_out_of_date_threshold,
-                                    is_background_cache);
-                            }
-                        }
-                    } catch (std::exception &) {
-                        // we have been unable to create a reader - the file is
-                        // unreadable for some reason. We do not want to report an
-                        // error because we are currently pre-cacheing. The error
-                        // *will* get reported when we actaully want to show the
-                        // image as an immediate frame request wlil be made as the
-                        // image isn't in the cache, and at that point error message
-                        // propagation will give the user feedback about the frame
-                        // being unreadable
-
-                        // shouldn't it continue... ?
-                        // mark_playhead_received_precache_result(playhead_uuid);
-                        // continue_precacheing();
-                    }
+                    // get reader..
+                    request(pool_, infinite, get_reader_atom_v, mptr.uri_, mptr.reader_)
+                        .then(
+                            [=](caf::actor &new_reader) mutable {
+                                new_reader = add_reader(
+                                    new_reader, reader_key(mptr.uri_, mptr.actor_addr_));
+                                send_request(new_reader);
+                            },
+                            [=](const caf::error &err) mutable {
+                                send_error_to_source(mptr.actor_addr_, err);
+
+                                media_reader::ImageBufPtr buf(
+                                    new media_reader::ImageBuffer(to_string(err)));
+                                send(playhead, push_image_atom_v, buf, mptr, tp);
+                            });
                 }
-            },
-            [=](const caf::error &err) {
-                mark_playhead_received_precache_result(playhead_uuid);
-                spdlog::warn("Failed preserve buffer {} {}", mptr->key_, to_string(err));
-            });
+            }
+        },
+        [=](const caf::error &err) mutable {
+            spdlog::warn(
+                "Failed cache retrieve buffer {} {}", to_string(mptr.key_), to_string(err));
+        });
 }
 
 void GlobalMediaReaderActor::keep_cache_hot(
@@ -768,81 +954,216 @@ void GlobalMediaReaderActor::read_and_cache_image(
     const bool is_background_cache) {
 
     const std::shared_ptr<const media::AVFrameID> mptr = fr.requested_frame_;
-    const time_point predicted_time                    = fr.required_by_;
     const utility::Uuid playhead_uuid                  = fr.requesting_playhead_uuid_;
+    const uint64_t id                                  = next_precache_id_++;
+
+    pending_image_stores_[playhead_uuid].emplace_back(
+        id, fr, cache_out_of_date_threshold, is_background_cache);
+
+    auto read_image = [=]() {
+        request(reader, std::chrono::seconds(60), read_precache_image_atom_v, *mptr)
+            .then(
+                [=](media_reader::ImageBufPtr buf) mutable {
+                    image_read_complete(playhead_uuid, id, buf);
+                },
+                [=](const caf::error &err) mutable {
+                    send_error_to_source(mptr->actor_addr_, err);
+                    spdlog::warn(
+                        "read_and_cache_image Failed to load buffer {} {} {}",
+                        to_string(mptr->uri_),
+                        to_string(mptr->key_),
+                        to_string(err));
+                    image_read_complete(playhead_uuid, id, media_reader::ImageBufPtr());
+                });
+    };
+
+    if (not disk_cache_gate_->enabled()) {
+        read_image();
+        return;
+    }
 
-    request(reader, std::chrono::seconds(60), read_precache_image_atom_v, *mptr)
+    // the disk cache returns an empty buffer if it doesn't have the frame
+    request(disk_cache_, std::chrono::seconds(10), media_cache::retrieve_atom_v, mptr->key_)
         .then(
             [=](media_reader::ImageBufPtr buf) mutable {
-                // store the image in our cache. We use a different store message
-                // if background cacheing
-                if (is_background_cache) {
-                    request(
-                        image_cache_,
-                        std::chrono::milliseconds(500),
-                        media_cache::store_atom_v,
-                        mptr->key_,
-                        buf,
-                        predicted_time,
-                        playhead_uuid,
-                        cache_out_of_date_threshold)
-                        .then(
-                            [=](const bool stored) {
-                                mark_playhead_received_precache_result(playhead_uuid);
-
-                                if (!stored) {
-                                    // cache is full ... stop background cacheing
-                                    background_precache_request_queue_.clear_pending_requests(
-                                        playhead_uuid);
-                                } else {
-                                    // still might have work to do
-                                    continue_precacheing();
-                                }
-                            },
-                            [=](const caf::error &err) mutable {
-                                mark_playhead_received_precache_result(playhead_uuid);
-                                spdlog::warn("Cache store error {}", to_string(err));
-                            });
-                } else {
-                    request(
-                        image_cache_,
-                        std::chrono::milliseconds(500),
-                        media_cache::store_atom_v,
-                        mptr->key_,
-                        buf,
-                        predicted_time,
-                        playhead_uuid)
-                        .then(
-                            [=](const bool stored) {
-                                if (!stored) {
-                                    // woops, cache is full. Stop pre-reading.
-                                    playback_precache_request_queue_.clear_pending_requests(
-                                        playhead_uuid);
-                                    background_precache_request_queue_.clear_pending_requests(
-                                        playhead_uuid);
-                                }
-                                mark_playhead_received_precache_result(playhead_uuid);
-
-                                // still might have work to do
-                                continue_precacheing();
-                            },
-                            [=](const caf::error &err) mutable {
-                                mark_playhead_received_precache_result(playhead_uuid);
-                                spdlog::warn("Cache store error {}", to_string(err));
-                            });
-                }
+                if (buf)
+                    image_read_complete(playhead_uuid, id, buf);
+                else
+                    read_image();
             },
-            [=](const caf::error &err) mutable {
+            [=](const caf::error &) mutable { read_image(); });
+}
+
+void GlobalMediaReaderActor::image_read_complete(
+    const utility::Uuid &playhead_uuid, const uint64_t id, const ImageBufPtr &buf) {
+
+    auto p = pending_image_stores_.find(playhead_uuid);
+    if (p == pending_image_stores_.end())
+        return;
+
+    for (auto &i : p->second) {
+        if (i.id_ == id) {
+            i.buf_  = buf;
+            i.done_ = true;
+            break;
+        }
+    }
+
+    // With several reads in flight they can finish in any order. Frames are
+    // stored in the order they were requested so that a frame further ahead
+    // can't push out one that is needed sooner when the cache is full.
+    while (not p->second.empty() and p->second.front().done_) {
+        const auto pending = p->second.front();
+        p->second.pop_front();
+
+        if (pending.buf_) {
+            store_precached_image(
+                pending.request_,
+                pending.buf_,
+                pending.cache_out_of_date_threshold_,
+                pending.is_background_cache_);
+        } else {
+            mark_playhead_received_precache_result(playhead_uuid);
+            // we might still have more work to do so keep going
+            continue_precacheing();
+        }
+    }
+
+    if (p->second.empty())
+        pending_image_stores_.erase(p);
+}
+
+void GlobalMediaReaderActor::store_precached_image(
+    const FrameRequest &fr,
+    const ImageBufPtr &buf,
+    const utility::time_point cache_out_of_date_threshold,
+    const bool is_background_cache) {
+
+    const std::shared_ptr<const media::AVFrameID> mptr = fr.requested_frame_;
+    const time_point predicted_time                    = fr.required_by_;
+    const utility::Uuid playhead_uuid                  = fr.requesting_playhead_uuid_;
+
+    // stores are batched up, see flush_cache_stores
+    image_store_batches_[std::make_pair(playhead_uuid, is_background_cache)].add(
+        mptr->key_, buf, predicted_time, cache_out_of_date_threshold);
+    queue_cache_store();
+}
+
+void GlobalMediaReaderActor::queue_cache_store() {
+
+    // with several readers working for us, frames tend to finish decoding in
+    // bursts. Rather than a message to the cache (and one back) for every
+    // frame, we collect them for a moment and send them together.
+    if (++batched_store_count_ >= max_cache_store_batch) {
+        flush_cache_stores();
+    } else if (not store_flush_pending_) {
+        store_flush_pending_ = true;
+        delayed_anon_send(this, cache_store_batch_window, flush_cache_stores_atom_v);
+    }
+}
+
+void GlobalMediaReaderActor::flush_cache_stores() {
+
+    for (const auto &[batch_key, batch] : image_store_batches_) {
+        const auto playhead_uuid       = batch_key.first;
+        const auto is_background_cache = batch_key.second;
+        const auto count               = batch.keys_.size();
+
+        auto on_error = [=](const caf::error &err) mutable {
+            for (size_t i = 0; i < count; i++)
                 mark_playhead_received_precache_result(playhead_uuid);
-                send_error_to_source(mptr->actor_addr_, err);
-                spdlog::warn(
-                    "read_and_cache_image Failed to load buffer {} {} {}",
-                    to_string(mptr->uri_),
-                    mptr->key_,
-                    to_string(err));
-                // we might still have more work to do so keep going
-                continue_precacheing();
-            });
+            spdlog::warn("Cache store error {}", to_string(err));
+        };
+
+        // We use a different store message if background cacheing
+        if (is_background_cache) {
+            request(
+                image_cache_,
+                std::chrono::milliseconds(500),
+                media_cache::store_atom_v,
+                batch.keys_,
+                batch.bufs_,
+                batch.when_,
+                playhead_uuid,
+                batch.out_of_date_)
+                .then(
+                    [=](const std::vector<bool> &stored) {
+                        for (size_t i = 0; i < count; i++)
+                            mark_playhead_received_precache_result(playhead_uuid);
+
+                        if (std::find(stored.begin(), stored.end(), false) != stored.end()) {
+                            // cache is full ... stop background cacheing
+                            stop_static_precache(playhead_uuid);
+                        } else {
+                            // still might have work to do
+                            continue_precacheing();
+                        }
+                    },
+                    on_error);
+        } else {
+            request(
+                image_cache_,
+                std::chrono::milliseconds(500),
+                media_cache::store_atom_v,
+                batch.keys_,
+                batch.bufs_,
+                batch.when_,
+                playhead_uuid)
+                .then(
+                    [=](const std::vector<bool> &stored) {
+                        if (std::find(stored.begin(), stored.end(), false) != stored.end()) {
+                            // woops, cache is full. Stop pre-reading.
+                            playback_precache_request_queue_.clear_pending_requests(
+                                playhead_uuid);
+                            stop_static_precache(playhead_uuid);
+                        }
+                        for (size_t i = 0; i < count; i++)
+                            mark_playhead_received_precache_result(playhead_uuid);
+
+                        // still might have work to do
+                        continue_precacheing();
+                    },
+                    on_error);
+        }
+    }
+
+    for (const auto &[batch_key, batch] : audio_store_batches_) {
+        const auto playhead_uuid       = batch_key.first;
+        const auto is_background_cache = batch_key.second;
+        const auto count               = batch.keys_.size();
+
+        request(
+            audio_cache_,
+            std::chrono::milliseconds(500),
+            media_cache::store_atom_v,
+            batch.keys_,
+            batch.bufs_,
+            batch.when_,
+            playhead_uuid,
+            batch.out_of_date_)
+            .then(
+                [=](const std::vector<bool> &stored) {
+                    for (size_t i = 0; i < count; i++)
+                        mark_playhead_received_precache_result(playhead_uuid);
+
+                    if (is_background_cache and
+                        std::find(stored.begin(), stored.end(), false) != stored.end()) {
+                        // cache is full ... stop background cacheing
+                        stop_static_precache(playhead_uuid);
+                    } else {
+                        continue_precacheing();
+                    }
+                },
+                [=](const caf::error &err) mutable {
+                    for (size_t i = 0; i < count; i++)
+                        mark_playhead_received_precache_result(playhead_uuid);
+                    spdlog::warn("Audio cache store error {}", to_string(err));
+                });
+    }
+
+    image_store_batches_.clear();
+    audio_store_batches_.clear();
+    batched_store_count_ = 0;
 }
 
 void GlobalMediaReaderActor::read_and_cache_audio(
@@ -858,35 +1179,10 @@ void GlobalMediaReaderActor::read_and_cache_audio(
     request(reader, std::chrono::seconds(60), read_precache_audio_atom_v, *mptr)
         .then(
             [=](media_reader::AudioBufPtr buf) mutable {
-                // store the image in our cache
-                request(
-                    audio_cache_,
-                    std::chrono::milliseconds(500),
-                    media_cache::store_atom_v,
-                    mptr->key_,
-                    buf,
-                    predicted_time,
-                    playhead_uuid,
-                    cache_out_of_date_threshold)
-                    .then(
-                        [=](const bool stored) {
-                            mark_playhead_received_precache_result(playhead_uuid);
-
-                            if (!stored && is_background_cache) {
-                                // cache is full ... stop background cacheing
-                                background_precache_request_queue_.clear_pending_requests(
-                                    playhead_uuid);
-                            } else {
-                                continue_precacheing();
-                                if (is_background_cache) {
-                                    // keep_cache_hot(mptr.key_, predicted_time, playhead_uuid);
-                                }
-                            }
-                        },
-                        [=](const caf::error &err) mutable {
-                            mark_playhead_received_precache_result(playhead_uuid);
-                            spdlog::warn("Audio cache store error {}", to_string(err));
-                        });
+                // store the audio in our cache
+                audio_store_batches_[std::make_pair(playhead_uuid, is_background_cache)].add(
+                    mptr->key_, buf, predicted_time, cache_out_of_date_threshold);
+                queue_cache_store();
             },
             [=](const caf::error &err) mutable {
                 mark_playhead_received_precache_result(playhead_uuid);
@@ -894,7 +1190,7 @@ void GlobalMediaReaderActor::read_and_cache_audio(
                 spdlog::warn(
                     "read_and_cache_audio Failed to load buffer {} {} {}",
                     to_string(mptr->uri_),
-                    mptr->key_,
+                    to_string(mptr->key_),
                     to_string(err));
                 // we might still have more work to do so keep going
                 continue_precacheing();
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <cstring>
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include "xstudio/media_reader/disk_frame_cache.hpp"
+
+using namespace xstudio;
+using namespace xstudio::media_reader;
+
+namespace {
+ImageBufPtr make_image(const size_t size, const int seed, const bool noise) {
+    ImageBufPtr buf(new ImageBuffer());
+    auto *data = reinterpret_cast<uint8_t *>(buf->allocate(size));
+    for (size_t i = 0; i < size; i++)
+        data[i] = noise ? uint8_t((i * 2654435761u + seed) >> 13) : uint8_t(seed + i / 4096);
+    buf->set_image_dimensions(Imath::V2i(seed, seed));
+    return buf;
+}
+
+std::string test_path() {
+    return (std::filesystem::temp_directory_path() / "disk_frame_cache_test").string();
+}
+} // namespace
+
+TEST(DiskFrameCacheTest, StoreRetrieve) {
+    for (const int level : {0, 1, 9}) {
+        DiskFrameCache cache(test_path(), 64 * 1024 * 1024, level);
+        ASSERT_TRUE(cache.enabled());
+
+        // one that compresses well and one that doesn't
+        auto a = make_image(1024 * 1024, 3, false);
+        auto b = make_image(1024 * 1024, 5, true);
+        const media::MediaKey key_a("a"), key_b("b");
+        EXPECT_TRUE(cache.store(key_a, a));
+        EXPECT_TRUE(cache.store(key_b, b));
+        if (level)
+            EXPECT_LT(cache.size(), size_t(2 * 1024 * 1024));
+
+        for (const auto &[key, image] : {std::make_pair(key_a, a), std::make_pair(key_b, b)}) {
+            auto restored = cache.retrieve(key);
+            ASSERT_TRUE(restored);
+            EXPECT_EQ(restored->size(), image->size());
+            EXPECT_EQ(restored->image_size_in_pixels(), image->image_size_in_pixels());
+            EXPECT_EQ(restored->media_key(), key);
+            EXPECT_EQ(std::memcmp(restored->buffer(), image->buffer(), image->size()), 0);
+        }
+        EXPECT_FALSE(cache.retrieve(media::MediaKey("c")));
+    }
+
+    // nothing left behind
+    EXPECT_TRUE(std::filesystem::is_empty(test_path()));
+}
+
+TEST(DiskFrameCacheTest, Eviction) {
+    DiskFrameCache cache(test_path(), 5 * 512 * 1024, 0);
+
+    for (int i = 0; i < 3; i++)
+        EXPECT_TRUE(
+            cache.store(media::MediaKey(std::to_string(i)), make_image(1024 * 1024, i, true)));
+    EXPECT_EQ(cache.count(), size_t(2));
+    EXPECT_FALSE(cache.contains(media::MediaKey("0")));
+
+    // least recently used goes first
+    EXPECT_TRUE(cache.retrieve(media::MediaKey("1")));
+    EXPECT_TRUE(cache.store(media::MediaKey("3"), make_image(1024 * 1024, 3, true)));
+    EXPECT_TRUE(cache.contains(media::MediaKey("1")));
+    EXPECT_FALSE(cache.contains(media::MediaKey("2")));
+
+    cache.set_max_size(0);
+    EXPECT_EQ(cache.count(), size_t(0));
+    EXPECT_FALSE(cache.store(media::MediaKey("4"), make_image(1024 * 1024, 4, true)));
+}
+
+TEST(DiskFrameCacheTest, GateBoundsQueuedWrites) {
+    DiskFrameCacheGate gate;
+    EXPECT_FALSE(gate.enabled());
+
+    for (int i = 0; i < DiskFrameCacheGate::max_queued_writes; i++)
+        EXPECT_TRUE(gate.try_queue_write());
+    // full, so further writes are dropped until one finishes
+    EXPECT_FALSE(gate.try_queue_write());
+    EXPECT_EQ(gate.queued_writes(), DiskFrameCacheGate::max_queued_writes);
+
+    gate.write_done();
+    EXPECT_TRUE(gate.try_queue_write());
+    EXPECT_FALSE(gate.try_queue_write());
+}
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+
+#include "xstudio/media/media.hpp"
+#include "xstudio/media_reader/frame_request_queue.hpp"
+#include "xstudio/utility/helpers.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace xstudio;
+using namespace xstudio::utility;
+using namespace xstudio::media_reader;
+
+namespace {
+media::AVFrameIDsAndTimePoints make_frames(const int count, const time_point &start) {
+    media::AVFrameIDsAndTimePoints result;
+    caf::uri path = posix_path_to_uri("/tmp/test.{:04d}.exr");
+    for (int i = 0; i < count; i++)
+        result.emplace_back(
+            start + std::chrono::milliseconds(i * 40),
+            std::make_shared<const media::AVFrameID>(path, i));
+    return result;
+}
+} // namespace
+
+TEST(FrameRequestQueueTest, InFlightWindow) {
+    FrameRequestQueue queue;
+    Uuid playhead_a(Uuid::generate());
+    Uuid playhead_b(Uuid::generate());
+    auto now = clock::now();
+
+    queue.add_frame_requests(make_frames(8, now), playhead_a);
+    queue.add_frame_requests(make_frames(2, now + std::chrono::seconds(10)), playhead_b);
+
+    std::map<Uuid, int> in_flight;
+    // a window of 4 hands out requests for playhead a until it is full..
+    for (int i = 0; i < 4; i++) {
+        auto fr = queue.pop_request(in_flight, 4);
+        ASSERT_TRUE(fr);
+        EXPECT_EQ(fr->requesting_playhead_uuid_, playhead_a);
+        EXPECT_EQ(fr->requested_frame_->frame_, i);
+        in_flight[playhead_a]++;
+    }
+
+    // .. then moves on to playhead b
+    auto fr = queue.pop_request(in_flight, 4);
+    ASSERT_TRUE(fr);
+    EXPECT_EQ(fr->requesting_playhead_uuid_, playhead_b);
+
+    // a window of one behaves as before, nothing for a playhead with a
+    // request outstanding
+    in_flight[playhead_b]++;
+    EXPECT_FALSE(queue.pop_request(in_flight));
+
+    in_flight[playhead_a] = 3;
+    fr                    = queue.pop_request(in_flight, 4);
+    ASSERT_TRUE(fr);
+    EXPECT_EQ(fr->requested_frame_->frame_, 4);
+}
+
+TEST(FrameRequestQueueTest, MergeRepeatRequests) {
+    FrameRequestQueue queue;
+    Uuid playhead_a(Uuid::generate());
+    Uuid playhead_b(Uuid::generate());
+    auto now    = clock::now();
+    auto frames = make_frames(4, now);
+
+    queue.add_frame_requests(frames, playhead_a);
+    queue.add_frame_requests(frames, playhead_a);
+    EXPECT_EQ(queue.size(), size_t(4));
+
+    // the same frame from another playhead is a separate request
+    queue.add_frame_request(*(frames[0].second), now, playhead_b);
+    EXPECT_EQ(queue.size(), size_t(5));
+    EXPECT_EQ(queue.size(playhead_a), size_t(4));
+    EXPECT_EQ(queue.size(playhead_b), size_t(1));
+
+    // asking for the last frame sooner moves it to the front
+    queue.add_frame_request(*(frames[3].second), now - std::chrono::seconds(1), playhead_a);
+    // but asking later doesn't move it back
+    queue.add_frame_request(*(frames[0].second), now + std::chrono::seconds(1), playhead_a);
+    EXPECT_EQ(queue.size(), size_t(5));
+
+    std::map<Uuid, int> in_flight;
+    in_flight[playhead_b] = 1;
+    std::vector<int> order;
+    while (auto fr = queue.pop_request(in_flight))
+        order.push_back(fr->requested_frame_->frame_);
+    EXPECT_EQ(order, std::vector<int>({3, 0, 1, 2}));
+    EXPECT_EQ(queue.size(), size_t(1));
+
+    queue.clear_pending_requests(playhead_b);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop_request({}));
+}
+
+TEST(FrameRequestQueueTest, ClearAndPrune) {
+    FrameRequestQueue queue;
+    Uuid playhead_a(Uuid::generate());
+    Uuid playhead_b(Uuid::generate());
+    auto now = clock::now();
+
+    // frames 0-4 for a were needed in the past
+    auto frames = make_frames(10, now);
+    for (int i = 0; i < 10; i++)
+        frames[i].first += i < 5 ? -std::chrono::seconds(1) : std::chrono::seconds(1);
+    queue.add_frame_requests(frames, playhead_a);
+    queue.add_frame_requests(make_frames(10, now), playhead_b);
+    EXPECT_EQ(queue.size(), size_t(20));
+
+    // only the latest of the stale requests is kept
+    queue.prune_stale_frame_requests();
+    EXPECT_EQ(queue.size(), size_t(16));
+
+    queue.clear_pending_requests(playhead_b);
+    EXPECT_EQ(queue.size(), size_t(6));
+
+    std::vector<int> order;
+    while (auto fr = queue.pop_request({})) {
+        EXPECT_EQ(fr->requesting_playhead_uuid_, playhead_a);
+        order.push_back(fr->requested_frame_->frame_);
+    }
+    EXPECT_EQ(order, std::vector<int>({4, 5, 6, 7, 8, 9}));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(FrameRequestQueueTest, Interleave) {
+    FrameRequestQueue queue;
+    Uuid playhead_a(Uuid::generate());
+    Uuid playhead_b(Uuid::generate());
+    auto now = clock::now();
+
+    queue.add_frame_requests(make_frames(4, now), playhead_a);
+    queue.add_frame_requests(make_frames(4, now + std::chrono::milliseconds(20)), playhead_b);
+
+    std::vector<Uuid> order;
+    while (auto fr = queue.pop_request({}))
+        order.push_back(fr->requesting_playhead_uuid_);
+    for (size_t i = 0; i < order.size(); i++)
+        EXPECT_EQ(order[i], i % 2 ? playhead_b : playhead_a);
+}
+
+TEST(FrameRequestQueueTest, DISABLED_PlaybackReplay) {
+    // replay the traffic of playheads static precacheing long sources while
+    // playback read ahead updates arrive and frames are popped, comparing
+    // against a plain sorted list of requests.
+    const int playheads         = 4;
+    const int precache_frames   = 2048;
+    const int playback_updates  = 500;
+    const int read_ahead_frames = 16;
+
+    struct Reference {
+        std::vector<FrameRequest> queue_;
+
+        void add(const FrameRequest &r) {
+            for (auto &q : queue_) {
+                if (q.requesting_playhead_uuid_ == r.requesting_playhead_uuid_ and
+                    q.requested_frame_->key_ == r.requested_frame_->key_) {
+                    if (r.required_by_ < q.required_by_) {
+                        q.required_by_ = r.required_by_;
+                        std::stable_sort(
+                            queue_.begin(),
+                            queue_.end(),
+                            [](const FrameRequest &a, const FrameRequest &b) {
+                                return a.required_by_ < b.required_by_;
+                            });
+                    }
+                    return;
+                }
+            }
+            auto p = std::upper_bound(
+                queue_.begin(),
+                queue_.end(),
+                r,
+                [](const FrameRequest &a, const FrameRequest &b) {
+                    return a.required_by_ < b.required_by_;
+                });
+            queue_.insert(p, r);
+        }
+
+        void clear(const Uuid &uuid) {
+            queue_.erase(
+                std::remove_if(
+                    queue_.begin(),
+                    queue_.end(),
+                    [&uuid](const FrameRequest &x) {
+                        return x.requesting_playhead_uuid_ == uuid;
+                    }),
+                queue_.end());
+        }
+
+        std::optional<FrameRequest> pop(const std::map<Uuid, int> &in_flight) {
+            for (auto p = queue_.begin(); p != queue_.end(); p++) {
+                auto f = in_flight.find(p->requesting_playhead_uuid_);
+                if (f == in_flight.end() or f->second < 4) {
+                    FrameRequest r = *p;
+                    queue_.erase(p);
+                    return r;
+                }
+            }
+            return {};
+        }
+    };
+
+    // build the traffic up front so only the queues are timed
+    auto now = clock::now();
+    std::vector<Uuid> uuids;
+    std::vector<media::AVFrameIDsAndTimePoints> precache;
+    for (int i = 0; i < playheads; i++) {
+        uuids.push_back(Uuid::generate());
+        precache.push_back(make_frames(precache_frames, now + std::chrono::milliseconds(i)));
+    }
+    std::vector<media::AVFrameIDsAndTimePoints> read_ahead;
+    for (int i = 0; i < playback_updates; i++) {
+        media::AVFrameIDsAndTimePoints frames;
+        for (int f = 0; f < read_ahead_frames; f++)
+            frames.push_back(precache[i % playheads][(i + f) % precache_frames]);
+        read_ahead.push_back(frames);
+    }
+
+    std::map<Uuid, int> in_flight;
+    in_flight[uuids[1]] = 4;
+
+    auto replay = [&](auto add, auto clear, auto pop) {
+        std::vector<std::pair<Uuid, int>> popped;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < playheads; i++)
+            add(precache[i], uuids[i]);
+        for (int i = 0; i < playback_updates; i++) {
+            const auto &uuid = uuids[i % playheads];
+            if (i % 50 == 0) {
+                clear(uuid);
+                add(precache[i % playheads], uuid);
+            }
+            add(read_ahead[i], uuid);
+            for (int p = 0; p < 4; p++) {
+                if (auto fr = pop(in_flight))
+                    popped.emplace_back(
+                        fr->requesting_playhead_uuid_, fr->requested_frame_->frame_);
+            }
+        }
+        return std::make_pair(
+            popped,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    FrameRequestQueue queue;
+    auto result = replay(
+        [&queue](const media::AVFrameIDsAndTimePoints &frames, const Uuid &uuid) {
+            queue.add_frame_requests(frames, uuid);
+        },
+        [&queue](const Uuid &uuid) { queue.clear_pending_requests(uuid); },
+        [&queue](const std::map<Uuid, int> &f) { return queue.pop_request(f, 4); });
+
+    Reference reference;
+    auto expected = replay(
+        [&reference](const media::AVFrameIDsAndTimePoints &frames, const Uuid &uuid) {
+            for (const auto &f : frames)
+                reference.add(FrameRequest(f.second, f.first, uuid));
+        },
+        [&reference](const Uuid &uuid) { reference.clear(uuid); },
+        [&reference](const std::map<Uuid, int> &f) { return reference.pop(f); });
+
+    spdlog::info(
+        "{} playheads, {} updates: FrameRequestQueue {:.4f}s, sorted list {:.4f}s",
+        playheads,
+        playback_updates,
+        result.second,
+        expected.second);
+
+    EXPECT_EQ(result.first, expected.first);
+    EXPECT_EQ(queue.size(), reference.queue_.size());
+}
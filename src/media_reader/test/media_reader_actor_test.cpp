@@ -5,8 +5,10 @@
 #include <thread>
 
 #include "xstudio/atoms.hpp"
+#include "xstudio/global/global_actor.hpp"
 #include "xstudio/media/media.hpp"
 #include "xstudio/media_cache/media_cache_actor.hpp"
+#include "xstudio/media_reader/cacheing_media_reader_actor.hpp"
 #include "xstudio/media_reader/media_reader_actor.hpp"
 #include "xstudio/utility/helpers.hpp"
 
@@ -22,6 +24,61 @@ using namespace caf;
 
 ACTOR_TEST_SETUP()
 
+TEST(CachingMediaReaderActorTest, PrecacheWindow) {
+    // the playhead keeps several precache reads in flight at once. Runs of
+    // them, forwards or backwards, must come back as the frames asked for.
+    fixture f;
+    auto gsa = f.self->spawn<global::GlobalActor>();
+
+    const auto uri = posix_path_to_uri(TEST_RESOURCE "/media/test.mov");
+    auto reader    = f.self->spawn<CachingMediaReaderActor>(
+        Uuid("87557f93-55f8-4650-8905-4834f1f4b78d"), caf::actor(), caf::actor(), uri);
+
+    int frames = 0;
+    f.self->request(reader, infinite, get_media_detail_atom_v, uri)
+        .receive(
+            [&](const media::MediaDetail &detail) {
+                ASSERT_FALSE(detail.streams_.empty());
+                frames = std::min(detail.streams_.front().duration_.frames(), 24);
+            },
+            [&](const caf::error &err) { FAIL() << to_string(err); });
+    ASSERT_GT(frames, 8);
+
+    auto read = [&](const int frame) {
+        return f.self->request(
+            reader,
+            std::chrono::seconds(10),
+            read_precache_image_atom_v,
+            media::AVFrameID(uri, frame));
+    };
+
+    const int window = 4;
+    auto read_run    = [&](const int first, const int step) {
+        for (int i = 0; i < frames; i += window) {
+            std::vector<int> wanted;
+            std::vector<decltype(read(0))> in_flight;
+            for (int j = i; j < std::min(i + window, frames); j++) {
+                wanted.push_back(first + j * step);
+                in_flight.push_back(read(wanted.back()));
+            }
+            for (size_t j = 0; j < in_flight.size(); j++) {
+                in_flight[j].receive(
+                    [&](const ImageBufPtr &buf) {
+                        ASSERT_TRUE(buf);
+                        EXPECT_EQ(buf->decoder_frame_number(), wanted[j]);
+                    },
+                    [&](const caf::error &err) { FAIL() << to_string(err); });
+            }
+        }
+    };
+
+    read_run(0, 1);
+    read_run(frames - 1, -1);
+
+    f.self->send_exit(reader, caf::exit_reason::user_shutdown);
+    f.self->send_exit(gsa, caf::exit_reason::user_shutdown);
+}
+
 #pragma message "This needs fixing"
 
 /*
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 
 #include "xstudio/media/media.hpp"
+#include "xstudio/media_cache/buffer_pool.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
 #include "xstudio/utility/helpers.hpp"
 #include "xstudio/utility/caf_helpers.hpp"
@@ -21,6 +22,27 @@ ACTOR_TEST_MINIMAL()
 // 	EXPECT_EQ(mb.buffer(), b);
 // }
 
+TEST(ImageBuffer, Reference) {
+    // memory we don't own is left to its owner, not given to the buffer pool
+    auto owner = std::make_shared<std::vector<media_reader::byte>>(
+        ImageBuffer::padded_size(1000));
+    const auto released = media_cache::BufferPool::instance().stats().released_;
+    {
+        ImageBufPtr image(new ImageBuffer());
+        image->reference(owner->data(), owner->size(), owner);
+        EXPECT_EQ(image->buffer(), owner->data());
+        EXPECT_EQ(image->size(), owner->size());
+        EXPECT_EQ(owner.use_count(), 2);
+
+        ImageBufPtr copy = image;
+        image.reset();
+        EXPECT_EQ(owner.use_count(), 2);
+    }
+    EXPECT_EQ(owner.use_count(), 1);
+    EXPECT_EQ(media_cache::BufferPool::instance().stats().released_, released);
+    EXPECT_EQ(ImageBuffer::padded_size(8192 * 4), size_t(8192 * 4));
+    EXPECT_EQ(ImageBuffer::padded_size(8192 * 4 + 1), size_t(8192 * 8));
+}
 
 TEST(MediaReader, Test) {
     // MediaReader mr("test");
@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <caf/policy/select_all.hpp>
 
 #include "xstudio/atoms.hpp"
@@ -31,6 +32,8 @@ EditListActor::EditListActor(
     caf::scoped_actor sys(system());
     for (auto media_source : ordered_media_sources) {
 
+        source_uuids_.emplace_back();
+        source_sections_.push_back(0);
         try {
             auto edl = request_receive<EditList>(
                 *sys, media_source, media::get_edit_list_atom_v, Uuid());
@@ -38,6 +41,8 @@ EditListActor::EditListActor(
                 request_receive<utility::Uuid>(*sys, media_source, utility::uuid_atom_v);
             edit_list_.extend(edl);
             source_actors_per_uuid_[uuid] = media_source;
+            source_uuids_.back()          = uuid;
+            source_sections_.back()       = edl.size();
             join_event_group(this, media_source);
         } catch (std::exception &e) {
             spdlog::error("{} {}", __PRETTY_FUNCTION__, e.what());
@@ -45,12 +50,15 @@ EditListActor::EditListActor(
     }
     behavior_.assign(
         [=](utility::event_atom, utility::change_atom) {
-            // send(event_group_, utility::event_atom_v, utility::change_atom_v);
+            source_changed(caf::actor_cast<caf::actor>(current_sender()));
+        },
+
+        [=](utility::event_atom, utility::change_atom, const bool) {
+            refresh_changed_sources();
         },
 
-        [=](utility::event_atom, utility::change_atom) {},
         [=](utility::event_atom, utility::last_changed_atom, const time_point &) {
-            send(event_group_, utility::event_atom_v, utility::change_atom_v);
+            source_changed(caf::actor_cast<caf::actor>(current_sender()));
         },
         [=](utility::event_atom,
             playlist::reflag_container_atom,
@@ -69,7 +77,7 @@ EditListActor::EditListActor(
             media::current_media_source_atom,
             UuidActor &,
             const media::MediaType) {
-            send(event_group_, utility::event_atom_v, utility::change_atom_v);
+            source_changed(caf::actor_cast<caf::actor>(current_sender()));
         },
 
         [=](const error &err) { spdlog::warn("{} {}", __PRETTY_FUNCTION__, to_string(err)); },
@@ -142,10 +150,52 @@ EditListActor::EditListActor(
             auto rp     = make_response_promise<media::FrameTimeMap>();
             auto result = std::make_shared<media::FrameTimeMap>();
             recursive_deliver_all_media_pointers(
-                tsm, override_rate, media_type, 0, timebase::flicks(0), result, rp);
+                tsm,
+                override_rate,
+                media_type,
+                0,
+                static_cast<int>(edit_list_.size()),
+                timebase::flicks(0),
+                result,
+                rp);
             return rp;
         },
 
+        // the frames of some sections, as of the given edit, placed where they
+        // are in the full list
+        [=](media::get_media_pointers_atom,
+            const media::MediaType media_type,
+            const utility::TimeSourceMode tsm,
+            const utility::FrameRate &override_rate,
+            const int edit,
+            const int first_section,
+            const int sections) -> result<media::FrameTimeMap> {
+            if (edit != edits_)
+                return make_error(xstudio_error::error, "Edit list has changed");
+            if (first_section < 0 or sections < 0 or
+                first_section + sections > static_cast<int>(edit_list_.size()))
+                return make_error(xstudio_error::error, "Out of range");
+
+            auto rp     = make_response_promise<media::FrameTimeMap>();
+            auto result = std::make_shared<media::FrameTimeMap>();
+            recursive_deliver_all_media_pointers(
+                tsm,
+                override_rate,
+                media_type,
+                first_section,
+                first_section + sections,
+                edit_list_.section_flicks(0, first_section, tsm, override_rate),
+                result,
+                rp);
+            return rp;
+        },
+
+        [=](utility::change_atom) -> int { return edits_; },
+
+        [=](playhead::source_atom, const std::vector<caf::actor> &sources) {
+            set_sources(sources);
+        },
+
         [=](media::source_offset_frames_atom) -> int { return 0; },
 
         [=](media::source_offset_frames_atom, const int o) -> bool {
@@ -264,13 +314,14 @@ void EditListActor::recursive_deliver_all_media_pointers(
     const utility::FrameRate &override_rate,
     const media::MediaType media_type,
     const int clip_index,
+    const int end_clip_index,
     const timebase::flicks clip_start_time_point,
     std::shared_ptr<media::FrameTimeMap> result,
     caf::typed_response_promise<media::FrameTimeMap> rp) {
 
     // this function is crucial. It works by recursively self calling until the
-    // 'clip_index' is greater than the number of clips (incrementind clip_index)
-    // in this edit list.
+    // 'clip_index' reaches end_clip_index (incrementind clip_index), which is
+    // the number of clips in this edit list unless we want only some of them.
     // We use it to get a full list of media pointers for this edit list from
     // start to finish. A 'AVFrameID' is a struct that contains all the
     // information we need to read/retrieve a frame of video/audio data. Along
@@ -278,7 +329,7 @@ void EditListActor::recursive_deliver_all_media_pointers(
     // media pointer, that is where it lies on the timeline (or when they should
     // be displayed if we start playback from time=0)
 
-    if (clip_index >= (int)edit_list_.size()) {
+    if (clip_index >= end_clip_index) {
 
         // we're done, we've exhausted the number of clips. Now we need something
         // funky ... we meed to add a timepoint at the end so we know when the
@@ -288,7 +339,7 @@ void EditListActor::recursive_deliver_all_media_pointers(
         // media pointer at this time. Note that we increment time_point for
         // every frame that's been added to result, so it time_point is already
         // where we need it
-        (*result)[clip_start_time_point].reset();
+        result->push_back(clip_start_time_point, nullptr);
         rp.deliver(*result);
         return;
     }
@@ -302,8 +353,8 @@ void EditListActor::recursive_deliver_all_media_pointers(
     const utility::Timecode tc = clip.timecode_;
 
     // number of logical frames in the clip
-    const int num_clip_frames = clip.frame_rate_and_duration_.frames(
-        tsm == TimeSourceMode::FIXED ? override_rate : FrameRate());
+    const int num_clip_frames =
+        static_cast<int>(edit_list_.section_frames(clip_index, 1, tsm, override_rate));
 
     // get the media actor (or other source actor type) for the clip
     const utility::Uuid &uuid = clip.media_uuid_;
@@ -324,8 +375,8 @@ void EditListActor::recursive_deliver_all_media_pointers(
             media::LogicalFrameRanges({{0, num_clip_frames - 1}}),
             override_rate)
             .await(
-                [=](const media::AVFrameIDs &mps) mutable {
-                    if ((int)mps.size() != num_clip_frames) {
+                [=](const media::AVFrameIDSpans &spans) mutable {
+                    if ((int)media::span_frames(spans) != num_clip_frames) {
                         rp.deliver(make_error(
                             xstudio_error::error,
                             "EditListActor::recursive_deliver_all_media_pointers media "
@@ -334,19 +385,26 @@ void EditListActor::recursive_deliver_all_media_pointers(
                         return;
                     }
 
-                    for (int f = 0; f < num_clip_frames; f++) {
-                        const int playhead_logical_frame = result->size();
-                        (*result)[time_point]            = mps[f];
-                        const_cast<media::AVFrameID *>((*result)[time_point].get())
-                            ->playhead_logical_frame_ = playhead_logical_frame;
-                        const_cast<media::AVFrameID *>(mps[f].get())->timecode_ = tc + f;
-                        time_point += tsm == TimeSourceMode::FIXED
-                                          ? override_rate
-                                          : clip.frame_rate_and_duration_.rate();
+                    const timebase::flicks period = (tsm == TimeSourceMode::FIXED
+                                                         ? override_rate
+                                                         : clip.frame_rate_and_duration_.rate())
+                                                        .to_flicks();
+                    int f = 0;
+                    for (const auto &span : spans) {
+                        result->push_back(time_point, period, span, tc + f);
+                        time_point += period * static_cast<timebase::flicks::rep>(span.size());
+                        f += static_cast<int>(span.size());
                     }
 
                     recursive_deliver_all_media_pointers(
-                        tsm, override_rate, media_type, clip_index + 1, time_point, result, rp);
+                        tsm,
+                        override_rate,
+                        media_type,
+                        clip_index + 1,
+                        end_clip_index,
+                        time_point,
+                        result,
+                        rp);
                 },
                 [=](error &err) mutable {
                     // something is wrong with the media source ... let's print it's
@@ -357,25 +415,214 @@ void EditListActor::recursive_deliver_all_media_pointers(
                     m_ptr->error_    = to_string(err);
 
                     for (int f = 0; f < num_clip_frames; f++) {
-                        (*result)[time_point] = blank_frame;
+                        result->push_back(time_point, blank_frame);
                         time_point += tsm == TimeSourceMode::FIXED
                                           ? override_rate
                                           : clip.frame_rate_and_duration_.rate();
                     }
 
                     recursive_deliver_all_media_pointers(
-                        tsm, override_rate, media_type, clip_index + 1, time_point, result, rp);
+                        tsm,
+                        override_rate,
+                        media_type,
+                        clip_index + 1,
+                        end_clip_index,
+                        time_point,
+                        result,
+                        rp);
                 });
     } else {
 
         for (int f = 0; f < num_clip_frames; f++) {
-            (*result)[time_point] = media::make_blank_frame(media_type);
+            result->push_back(time_point, media::make_blank_frame(media_type));
             time_point += tsm == TimeSourceMode::FIXED ? override_rate
                                                        : clip.frame_rate_and_duration_.rate();
         }
 
         // shouldn't we deliver on the promise...
         recursive_deliver_all_media_pointers(
-            tsm, override_rate, media_type, clip_index + 1, time_point, result, rp);
+            tsm,
+            override_rate,
+            media_type,
+            clip_index + 1,
+            end_clip_index,
+            time_point,
+            result,
+            rp);
+    }
+}
+
+void EditListActor::set_sources(const std::vector<caf::actor> &sources) {
+
+    // only the sources between the ones that are unchanged at either end
+    // need reading
+    size_t prefix = 0;
+    while (prefix < source_actors_.size() and prefix < sources.size() and
+           source_actors_[prefix] == sources[prefix])
+        prefix++;
+
+    size_t suffix = 0;
+    while (suffix < source_actors_.size() - prefix and suffix < sources.size() - prefix and
+           source_actors_[source_actors_.size() - 1 - suffix] ==
+               sources[sources.size() - 1 - suffix])
+        suffix++;
+
+    if (prefix == source_actors_.size() and prefix == sources.size())
+        return;
+
+    replace_sources(
+        prefix,
+        source_actors_.size() - prefix - suffix,
+        std::vector<caf::actor>(sources.begin() + prefix, sources.end() - suffix));
+}
+
+void EditListActor::source_changed(const caf::actor &source) {
+
+    if (std::find(source_actors_.begin(), source_actors_.end(), source) ==
+        source_actors_.end())
+        return;
+
+    // sources tend to send several changes at once, so wait for them to
+    // settle before re-reading
+    if (changed_sources_.empty())
+        delayed_send(
+            this,
+            std::chrono::milliseconds(250),
+            utility::event_atom_v,
+            utility::change_atom_v,
+            true);
+
+    if (std::find(changed_sources_.begin(), changed_sources_.end(), source) ==
+        changed_sources_.end())
+        changed_sources_.push_back(source);
+}
+
+void EditListActor::refresh_changed_sources() {
+
+    // re-read the run of sources from the first changed one to the last
+    size_t first = source_actors_.size();
+    size_t last  = 0;
+    for (size_t i = 0; i < source_actors_.size(); i++) {
+        if (std::find(changed_sources_.begin(), changed_sources_.end(), source_actors_[i]) !=
+            changed_sources_.end()) {
+            first = std::min(first, i);
+            last  = i + 1;
+        }
+    }
+    changed_sources_.clear();
+
+    if (first < last)
+        replace_sources(
+            first,
+            last - first,
+            std::vector<caf::actor>(
+                source_actors_.begin() + first, source_actors_.begin() + last));
+}
+
+void EditListActor::replace_sources(
+    const size_t first, const size_t count, const std::vector<caf::actor> &sources) {
+
+    if (sources.empty()) {
+        apply_sources(first, count, sources, {});
+        return;
+    }
+
+    // the await means nothing else sees the edit list until the edit is
+    // complete
+    auto edit_lists =
+        std::make_shared<std::vector<std::pair<EditList, Uuid>>>(sources.size());
+    auto pending = std::make_shared<size_t>(sources.size());
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        auto done = [=]() mutable {
+            if (not --(*pending))
+                apply_sources(first, count, sources, *edit_lists);
+        };
+        auto failed = [=](const error &err) mutable {
+            spdlog::error("{} {}", __PRETTY_FUNCTION__, to_string(err));
+            done();
+        };
+
+        request(sources[i], infinite, media::get_edit_list_atom_v, Uuid())
+            .await(
+                [=](const EditList &edl) mutable {
+                    request(sources[i], infinite, utility::uuid_atom_v)
+                        .await(
+                            [=](const Uuid &uuid) mutable {
+                                (*edit_lists)[i] = std::make_pair(edl, uuid);
+                                done();
+                            },
+                            failed);
+                },
+                failed);
+    }
+}
+
+void EditListActor::apply_sources(
+    const size_t first,
+    const size_t count,
+    const std::vector<caf::actor> &sources,
+    const std::vector<std::pair<EditList, Uuid>> &edit_lists) {
+
+    auto section_count = [&](const size_t from, const size_t to) {
+        size_t result = 0;
+        for (auto i = from; i < to; i++)
+            result += source_sections_[i];
+        return result;
+    };
+
+    const auto first_section = section_count(0, first);
+    const auto old_sections  = section_count(first, first + count);
+
+    const auto &sl = edit_list_.section_list();
+    const auto removed =
+        EditList(ClipList(sl.begin() + first_section, sl.begin() + first_section + old_sections));
+
+    ClipList clips(sl.begin(), sl.begin() + first_section);
+    std::vector<Uuid> uuids;
+    std::vector<size_t> sections;
+    for (const auto &i : edit_lists) {
+        clips.insert(clips.end(), i.first.section_list().begin(), i.first.section_list().end());
+        uuids.push_back(i.second);
+        sections.push_back(i.first.size());
     }
+    const auto added = clips.size() - first_section;
+    clips.insert(clips.end(), sl.begin() + first_section + old_sections, sl.end());
+
+    // listen to the sources we've gained and stop listening to the ones gone
+    const auto old_sources = source_actors_;
+    auto splice            = [&](auto &v, const auto &with) {
+        v.erase(v.begin() + first, v.begin() + first + count);
+        v.insert(v.begin() + first, with.begin(), with.end());
+    };
+    splice(source_actors_, sources);
+    splice(source_uuids_, uuids);
+    splice(source_sections_, sections);
+
+    for (const auto &i : sources)
+        if (std::find(old_sources.begin(), old_sources.end(), i) == old_sources.end())
+            join_event_group(this, i);
+    for (auto i = first; i < first + count; i++)
+        if (std::find(source_actors_.begin(), source_actors_.end(), old_sources[i]) ==
+            source_actors_.end())
+            leave_event_group(this, old_sources[i]);
+
+    source_actors_per_uuid_.clear();
+    for (size_t i = 0; i < source_actors_.size(); i++)
+        if (source_sections_[i])
+            source_actors_per_uuid_[source_uuids_[i]] = source_actors_[i];
+
+    edit_list_ = EditList(clips);
+    edits_++;
+
+    // playheads replace the frames of the removed sections with those of the
+    // added ones, rather than re-reading everything
+    send(
+        event_group_,
+        utility::event_atom_v,
+        utility::change_atom_v,
+        edits_,
+        static_cast<int>(first_section),
+        removed,
+        static_cast<int>(added));
 }
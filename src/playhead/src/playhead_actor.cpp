@@ -233,6 +233,26 @@ void PlayheadActor::init() {
 
         [=](viewport_events_group_atom) -> caf::actor { return viewport_events_group_; },
 
+        [=](viewport_view_atom,
+            const Imath::V2f &visible_min,
+            const Imath::V2f &visible_max,
+            const Imath::V2i &size_screen_pixels,
+            const Imath::M44f &image_transform) {
+            have_viewport_view_          = true;
+            viewport_visible_min_        = visible_min;
+            viewport_visible_max_        = visible_max;
+            viewport_size_screen_pixels_ = size_screen_pixels;
+            viewport_image_transform_    = image_transform;
+            for (auto &ph : playheads_) {
+                send_viewport_view(ph);
+            }
+            // a frame loaded for the old view may be missing what is now in
+            // view, so load the whole of the current frame again
+            if (!playing()) {
+                update_child_playhead_positions(true);
+            }
+        },
+
         /* move all child playheads to current position */
         [=](jump_atom) { update_child_playhead_positions(true); },
 
@@ -370,6 +390,8 @@ void PlayheadActor::init() {
 
         [=](media_atom atom) { delegate(key_playhead_, atom); },
 
+        [=](media::get_media_pointers_atom atom) { delegate(key_playhead_, atom); },
+
         [=](media_source_atom atom) { delegate(key_playhead_, atom); },
 
         [=](media_cache::cached_frames_atom) {
@@ -915,8 +937,10 @@ void PlayheadActor::init() {
                     if (std::find(source_actors_.begin(), source_actors_.end(), sender) !=
                         source_actors_.end()) {
                         // one of the sources has changed - we will do a rebuild in case its
-                        // duration or timing has changed
-                        rebuild();
+                        // duration or timing has changed. A string of sources re-reads
+                        // the changed one itself.
+                        if (not string_edit_list_ or compare_mode() != CM_STRING)
+                            rebuild();
                     }
                 }
 
@@ -1035,7 +1059,8 @@ void PlayheadActor::clear_child_playheads() {
 
     playheads_.clear();
     source_wrappers_.clear();
-    key_playhead_ = caf::actor();
+    string_edit_list_ = caf::actor();
+    key_playhead_     = caf::actor();
 }
 
 caf::actor PlayheadActor::make_child_playhead(caf::actor source) {
@@ -1056,11 +1081,23 @@ caf::actor PlayheadActor::make_child_playhead(caf::actor source) {
 
     link_to(sub_playhead);
     playheads_.push_back(sub_playhead);
+    if (have_viewport_view_)
+        send_viewport_view(sub_playhead);
 
     join_event_group(this, sub_playhead);
     return sub_playhead;
 }
 
+void PlayheadActor::send_viewport_view(caf::actor sub_playhead) {
+    anon_send(
+        sub_playhead,
+        viewport_view_atom_v,
+        viewport_visible_min_,
+        viewport_visible_max_,
+        viewport_size_screen_pixels_,
+        viewport_image_transform_);
+}
+
 caf::actor PlayheadActor::make_audio_child_playhead(caf::actor source) {
 
     if (audio_playhead_) {
@@ -1124,19 +1161,30 @@ void PlayheadActor::new_source_list(const std::vector<caf::actor> &sl) {
                         fan_out_request<policy::select_all>(
                             event_groups, infinite, broadcast::join_broadcast_atom_v)
                             .then(
-                                [=](std::vector<bool>) { rebuild(); },
+                                [=](std::vector<bool>) { sources_changed(); },
                                 [=](caf::error &err) {
                                     spdlog::warn("{} {}", __PRETTY_FUNCTION__, to_string(err));
-                                    rebuild();
+                                    sources_changed();
                                 });
                     } else {
-                        rebuild();
+                        sources_changed();
                     }
                 },
                 [=](caf::error &err) {
                     spdlog::warn("{} {}", __PRETTY_FUNCTION__, to_string(err));
-                    rebuild();
+                    sources_changed();
                 });
+    } else {
+        sources_changed();
+    }
+}
+
+void PlayheadActor::sources_changed() {
+
+    // a string of sources takes the new list itself, and its child playheads
+    // re-read only the part of the timeline that has changed
+    if (string_edit_list_ and compare_mode() == CM_STRING and source_actors_.size()) {
+        send(string_edit_list_, source_atom_v, source_actors_);
     } else {
         rebuild();
     }
@@ -1158,6 +1206,7 @@ void PlayheadActor::rebuild() {
         make_child_playhead(foo);
         switch_key_playhead(0);
         source_wrappers_.push_back(foo);
+        string_edit_list_ = foo;
 
     } else {
 
@@ -103,6 +103,9 @@ RetimeActor::RetimeActor(caf::actor_config &cfg, const std::string &name, caf::a
 
         [=](playhead::overflow_mode_atom) -> int { return static_cast<int>(overflow_mode_); },
 
+        // we don't number our edits, unlike EditListActor
+        [=](utility::change_atom) -> int { return -1; },
+
         [=](media::get_edit_list_atom, const Uuid & /*override_uuid*/) -> utility::EditList {
             // spdlog::warn("get_edit_list_atom {}", __PRETTY_FUNCTION__);
             // we don't use the override uuid, instead the uuid in the edit list correspond to
@@ -332,7 +335,7 @@ void RetimeActor::recursive_deliver_all_media_pointers(
         // media pointer at this time. Note that we increment time_point for
         // every frame that's been added to result, so it time_point is already
         // where we need it
-        (*result)[clip_start_time_point].reset();
+        result->push_back(clip_start_time_point, nullptr);
         rp.deliver(*result);
         return;
     }
@@ -364,7 +367,14 @@ void RetimeActor::recursive_deliver_all_media_pointers(
         media::LogicalFrameRanges({{0, num_clip_frames - 1}}),
         override_rate)
         .await(
-            [=](const media::AVFrameIDs &mps) mutable {
+            [=](const media::AVFrameIDSpans &spans) mutable {
+                // where each of the source's frames is in spans
+                std::vector<std::pair<const media::AVFrameIDSpan *, size_t>> mps;
+                mps.reserve(num_clip_frames);
+                for (const auto &span : spans)
+                    for (size_t i = 0; i < span.size(); i++)
+                        mps.emplace_back(&span, i);
+
                 if ((int)mps.size() != num_clip_frames) {
                     rp.deliver(make_error(
                         xstudio_error::error,
@@ -376,36 +386,32 @@ void RetimeActor::recursive_deliver_all_media_pointers(
                 for (int f = 0; f < retimed_duration; f++) {
 
                     RetimeFrameResult r;
-                    int retime_frame                 = apply_retime(f, r);
-                    const int playhead_logical_frame = result->size();
+                    int retime_frame = apply_retime(f, r);
 
                     if (r == FAIL) {
                         rp.deliver(make_error(xstudio_error::error, "No frames left"));
                         return;
                     } else if (retime_frame >= 0 && retime_frame < (int)mps.size()) {
+                        const auto &[span, index] = mps[retime_frame];
                         if (r == IN_RANGE) {
-                            // re-use the pointer we were given
-                            (*result)[time_point] = mps[retime_frame];
+                            // the frame as the source gave it
+                            result->push_back(time_point, *span, index, tc + f - frames_offset_);
                         } else {
                             // dupliacte frame, need to duplicate the data
-                            media::AVFrameID mptr(*mps[retime_frame]);
+                            media::AVFrameID mptr(*span->frame(index));
                             if (r == HELD_FRAME) {
                                 mptr.params_["HELD_FRAME"] = true;
                             }
-                            (*result)[time_point] =
-                                std::make_shared<const media::AVFrameID>(mptr);
+                            result->push_back(
+                                time_point,
+                                std::make_shared<const media::AVFrameID>(mptr),
+                                tc + f - frames_offset_);
                         }
-                        const_cast<media::AVFrameID *>((*result)[time_point].get())->timecode_ =
-                            tc + f - frames_offset_;
 
                     } else { // OUT_OF_RANGE
-                        (*result)[time_point] = media::make_blank_frame(media_type);
+                        result->push_back(time_point, media::make_blank_frame(media_type));
                     }
 
-                    // set the logical frame
-                    const_cast<media::AVFrameID *>((*result)[time_point].get())
-                        ->playhead_logical_frame_ = playhead_logical_frame;
-
                     time_point += tsm == TimeSourceMode::FIXED
                                       ? override_rate
                                       : clip.frame_rate_and_duration_.rate();
@@ -424,7 +430,7 @@ void RetimeActor::recursive_deliver_all_media_pointers(
                 m_ptr->error_    = to_string(err);
 
                 for (int f = 0; f < num_clip_frames; f++) {
-                    (*result)[time_point] = blank_frame;
+                    result->push_back(time_point, blank_frame);
                     time_point += tsm == TimeSourceMode::FIXED
                                       ? override_rate
                                       : clip.frame_rate_and_duration_.rate();
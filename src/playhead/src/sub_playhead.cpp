@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <chrono>
 
 #include <caf/policy/select_all.hpp>
@@ -223,23 +224,21 @@ void SubPlayhead::init() {
 
             // to get to the last frame, due to the last 'dummy' frame that is appended
             // to account for the duration of the last frame, step back twice from end
-            auto last_frame = full_timeline_frames_.end();
-            last_frame--;
-            last_frame--;
+            auto last_frame = full_timeline_frames_.end() - 2;
 
             auto frame = full_timeline_frames_.begin();
-            while (logical_frame > 0 && frame != last_frame) {
-                frame++;
-                logical_frame--;
+            if (logical_frame > 0) {
+                const auto step = std::min<std::ptrdiff_t>(logical_frame, last_frame - frame);
+                frame += step;
+                logical_frame -= step;
             }
 
-            auto tp = frame->first;
+            auto tp = frame.time();
             if (logical_frame) {
                 // if logical_frame goes beyond our last frame then use the
                 // duration of the final last frame to extend the result
-                auto dummy_last = full_timeline_frames_.end();
-                dummy_last--;
-                auto last_frame_duration = dummy_last->first - last_frame->first;
+                auto dummy_last          = full_timeline_frames_.end() - 1;
+                auto last_frame_duration = dummy_last.time() - last_frame.time();
                 tp += logical_frame * last_frame_duration;
             }
 
@@ -254,7 +253,7 @@ void SubPlayhead::init() {
             // loop over frames until we hit the media item
             auto frame = full_timeline_frames_.begin();
             while (frame != full_timeline_frames_.end()) {
-                if (frame->second && frame->second->media_uuid_ == media_uuid) {
+                if (frame.shared() && frame.shared()->media_uuid_ == media_uuid) {
                     break;
                 }
                 frame++;
@@ -265,20 +264,20 @@ void SubPlayhead::init() {
 
             // get the time of the first frame for the media we are interested
             // in, in case we don't match with logical_media_frame
-            timebase::flicks result = frame->first;
+            timebase::flicks result = frame.time();
 
             // now loop over frames for the media item until we match to the logical_media_frame
             while (frame != full_timeline_frames_.end()) {
-                if (frame->second && frame->second->media_uuid_ != media_uuid) {
+                if (frame.shared() && frame.shared()->media_uuid_ != media_uuid) {
                     return make_error(xstudio_error::error, "Out of range");
-                } else if (frame->second && frame->second->frame_ >= logical_media_frame) {
+                } else if (frame.shared() && frame.media_frame() >= logical_media_frame) {
                     // note the >= .... if logical_media_frame is *less* than
                     // the frame's media frame, we return the timestamp for
                     // 'frame'. The reason is that if we've been asked to get
                     // the time stamp for frame zero, but we have frame nubers
                     // that start at 1001, say, we just fall back to returning
                     // the first frame
-                    return frame->first;
+                    return frame.time();
                 }
                 frame++;
             }
@@ -310,10 +309,11 @@ void SubPlayhead::init() {
 
         [=](first_frame_media_pointer_atom) -> result<media::AVFrameID> {
             if (full_timeline_frames_.size()) {
-                if (!full_timeline_frames_.begin()->second) {
+                auto frame = full_timeline_frames_.begin().frame();
+                if (!frame) {
                     return make_error(xstudio_error::error, "Empty frame");
                 }
-                return *(full_timeline_frames_.begin()->second);
+                return *frame;
             }
             return make_error(xstudio_error::error, "No Frames");
         },
@@ -322,21 +322,24 @@ void SubPlayhead::init() {
             if (full_timeline_frames_.size() > 1) {
                 // remember the last entry in full_timeline_frames_ is
                 // a dummy frame marking the end of the last frame
-                auto p = full_timeline_frames_.rbegin();
-                p++;
-                if (!p->second) {
+                auto frame = (full_timeline_frames_.end() - 2).frame();
+                if (!frame) {
                     return make_error(xstudio_error::error, "Empty frame");
                 }
-                return *(p->second);
+                return *frame;
             }
             return make_error(xstudio_error::error, "No Frames");
         },
 
+        [=](media::get_media_pointers_atom) -> media::FrameTimeMap {
+            return full_timeline_frames_;
+        },
+
         [=](media_source_atom) -> caf::actor {
             auto frame = full_timeline_frames_.lower_bound(position_flicks_);
             caf::actor result;
-            if (frame != full_timeline_frames_.end() && frame->second) {
-                result = caf::actor_cast<caf::actor>(frame->second->actor_addr_);
+            if (frame != full_timeline_frames_.end() && frame.shared()) {
+                result = caf::actor_cast<caf::actor>(frame.shared()->actor_addr_);
             }
             return result;
         },
@@ -376,8 +379,8 @@ void SubPlayhead::init() {
         [=](media_source_atom, bool) -> utility::Uuid {
             auto frame = full_timeline_frames_.lower_bound(position_flicks_);
             utility::Uuid result;
-            if (frame != full_timeline_frames_.end() && frame->second) {
-                result = frame->second->media_uuid_;
+            if (frame != full_timeline_frames_.end() && frame.shared()) {
+                result = frame.shared()->media_uuid_;
             }
             return result;
         },
@@ -385,9 +388,11 @@ void SubPlayhead::init() {
         [=](media_cache::keys_atom) -> media::MediaKeyVector {
             media::MediaKeyVector result;
             result.reserve(full_timeline_frames_.size());
-            for (const auto &pp : full_timeline_frames_) {
-                if (pp.second) {
-                    result.push_back(pp.second->key_);
+            for (auto frame = full_timeline_frames_.begin();
+                 frame != full_timeline_frames_.end();
+                 frame++) {
+                if (frame.shared()) {
+                    result.push_back(frame.key());
                 }
             }
             return result;
@@ -481,6 +486,15 @@ void SubPlayhead::init() {
             return rp;
         },
 
+        [=](viewport_view_atom,
+            const Imath::V2f &visible_min,
+            const Imath::V2f &visible_max,
+            const Imath::V2i &size_screen_pixels,
+            const Imath::M44f &image_transform) {
+            viewport_view_ = ViewportView{
+                visible_min, visible_max, size_screen_pixels, image_transform};
+        },
+
         [=](utility::event_atom, media::source_offset_frames_atom atom, const int offset) {
             // pass up to the main playhead that the offset has changed
             if (parent_)
@@ -507,6 +521,15 @@ void SubPlayhead::init() {
             }
         },
 
+        [=](utility::event_atom,
+            utility::change_atom,
+            const int edit,
+            const int first_section,
+            const utility::EditList &removed,
+            const int added_sections) {
+            splice_edit(edit, first_section, removed, added_sections);
+        },
+
         [=](utility::event_atom, utility::last_changed_atom, const time_point &) {
             if (not content_changed_) {
                 content_changed_ = true;
@@ -556,6 +579,13 @@ void SubPlayhead::init() {
             }
             return rp;
         },
+        [=](media_reader::static_precache_atom,
+            const int max_num_frames) -> media::AVFrameIDsAndTimePoints {
+            // the reader wants more frames for the idle precache
+            media::AVFrameIDsAndTimePoints requests;
+            get_static_precache_frames(requests, max_num_frames);
+            return requests;
+        },
         [=](check_logical_frame_changing_atom, const int logical_frame) {
             if (logical_frame == logical_frame_ && logical_frame != precache_start_frame_) {
                 // logical frame is not changing! Kick off a full precache
@@ -615,19 +645,38 @@ void SubPlayhead::set_position(
             if (media_type_ == media::MediaType::MT_IMAGE) {
                 media::AVFrameID mptr(*(frame.get()));
                 mptr.playhead_logical_frame_ = logical_frame_;
-                anon_send(
-                    pre_reader_,
-                    media_reader::get_image_atom_v,
-                    mptr,
-                    actor_cast<caf::actor>(this),
-                    base_.uuid(),
-                    now,
-                    logical_frame_);
+                if (viewport_view_) {
+                    // the reader may load only the part of the frame in view,
+                    // which is quicker for big images
+                    anon_send(
+                        pre_reader_,
+                        media_reader::get_image_atom_v,
+                        mptr,
+                        actor_cast<caf::actor>(this),
+                        base_.uuid(),
+                        now,
+                        logical_frame_,
+                        viewport_view_->visible_min_,
+                        viewport_view_->visible_max_,
+                        viewport_view_->size_screen_pixels_,
+                        viewport_view_->image_transform_);
+                } else {
+                    anon_send(
+                        pre_reader_,
+                        media_reader::get_image_atom_v,
+                        mptr,
+                        actor_cast<caf::actor>(this),
+                        base_.uuid(),
+                        now,
+                        logical_frame_);
+                }
             }
         }
 
         // update the parent playhead with our position
-        if (frame && (previous_frame_ != frame || force_updates)) {
+        // frames are made on demand, so compare what they are rather than
+        // where they are
+        if (frame && (!previous_frame_ || !(*previous_frame_ == *frame) || force_updates)) {
             anon_send(
                 parent_,
                 position_atom_v,
@@ -840,19 +889,29 @@ std::vector<timebase::flicks> SubPlayhead::get_lookahead_frame_pointers(
     }
 
     timebase::flicks current_frame_tp =
-        std::min(out_frame_->first, std::max(in_frame_->first, position_flicks_));
+        std::min(out_frame_.time(), std::max(in_frame_.time(), position_flicks_));
 
-    auto frame = full_timeline_frames_.upper_bound(current_frame_tp);
+    auto frame = full_timeline_frames_.upper_bound(current_frame_tp, current_frame_);
     if (frame != full_timeline_frames_.begin())
         frame--;
 
     const auto start_point = frame;
+    auto tt                = utility::clock::now();
+    walk_frames(result, &tps, frame, start_point, playing_forwards_, tt, max_num_frames);
+    return tps;
+}
 
-    auto tt = utility::clock::now();
-    int r   = max_num_frames;
+bool SubPlayhead::walk_frames(
+    media::AVFrameIDsAndTimePoints &result,
+    std::vector<timebase::flicks> *tps,
+    media::FrameTimeMap::const_iterator &frame,
+    const media::FrameTimeMap::const_iterator &start_point,
+    const bool forwards,
+    utility::time_point &tt,
+    int max_num_frames) {
 
-    while (r--) {
-        if (playing_forwards_) {
+    while (max_num_frames--) {
+        if (forwards) {
             if (frame != out_frame_)
                 frame++;
             else
@@ -866,26 +925,59 @@ std::vector<timebase::flicks> SubPlayhead::get_lookahead_frame_pointers(
 
         auto frame_plus = frame;
         frame_plus++;
-        timebase::flicks frame_duration = frame_plus->first - frame->first;
+        timebase::flicks frame_duration = frame_plus.time() - frame.time();
         tt += std::chrono::duration_cast<std::chrono::microseconds>(
             frame_duration / playback_velocity_);
 
-        if (frame->second && !frame->second->source_uuid_.is_null()) {
+        if (frame.shared() && !frame.shared()->source_uuid_.is_null()) {
             // we don't send pre-read requests for 'blank' frames where
             // source_uuid is null
-            result.emplace_back(tt, frame->second);
-            tps.push_back(frame->first);
+            result.emplace_back(tt, frame.frame());
+            if (tps)
+                tps->push_back(frame.time());
         }
 
         // this tests if we've looped around the full range before hitting
-        // pre_cache_read_ahead_frames_, i.e. pre_cache_read_ahead_frames_ >
-        // loop range
+        // max_num_frames, i.e. max_num_frames > loop range
         if (frame == start_point)
-            break;
+            return false;
     }
-    return tps;
+    return true;
 }
 
+void SubPlayhead::get_static_precache_frames(
+    media::AVFrameIDsAndTimePoints &result, const int max_num_frames) {
+
+    auto &cursor = static_precache_cursor_;
+    if (not cursor.active_ or full_timeline_frames_.size() < 2)
+        return;
+
+    // the loop range may have changed since the precache started, if so
+    // carry on from the start of the new range and go round it once
+    const auto in_range = [this](const timebase::flicks t) {
+        return t >= in_frame_.time() and t <= out_frame_.time();
+    };
+    if (not in_range(cursor.position_)) {
+        cursor.position_ = cursor.forwards_ ? out_frame_.time() : in_frame_.time();
+        cursor.start_    = cursor.position_;
+    } else if (not in_range(cursor.start_)) {
+        cursor.start_ = cursor.position_;
+    }
+
+    auto frame       = full_timeline_frames_.find(cursor.position_);
+    auto start_point = full_timeline_frames_.find(cursor.start_);
+    if (frame == full_timeline_frames_.end() or start_point == full_timeline_frames_.end()) {
+        cursor.active_ = false;
+        return;
+    }
+
+    // an empty result tells the reader we're done, so keep going over any
+    // gaps in the timeline
+    while (cursor.active_ and result.empty())
+        cursor.active_ = walk_frames(
+            result, nullptr, frame, start_point, cursor.forwards_, cursor.tt_, max_num_frames);
+    cursor.position_ = frame.time();
+}
 
 void SubPlayhead::request_future_frames() {
 
@@ -957,22 +1049,33 @@ void SubPlayhead::make_static_precache_request(
     // by just sending an empty request to the pre-reader
     if (start_precache) {
 
-#pragma message                                                                                \
-    "This needs fixing - for now, hardcoding fetch max 2048 frames for idle precache"
-
-        media::AVFrameIDsAndTimePoints requests;
-        get_lookahead_frame_pointers(
-            requests, 2048
-            // std::numeric_limits<int>::max() // this will fetch *ALL* frames in the source
-        );
+        // the reader pulls frames from here as it has room for them, starting
+        // with the frame after the current one and going round the loop range
+        // once.
+        static_precache_cursor_.active_ = full_timeline_frames_.size() >= 2;
+        if (static_precache_cursor_.active_) {
+            auto frame = full_timeline_frames_.upper_bound(
+                std::min(out_frame_.time(), std::max(in_frame_.time(), position_flicks_)));
+            if (frame != full_timeline_frames_.begin())
+                frame--;
+            static_precache_cursor_.position_ = frame.time();
+            static_precache_cursor_.start_    = frame.time();
+            static_precache_cursor_.forwards_ = playing_forwards_;
+            static_precache_cursor_.tt_       = utility::clock::now();
+        }
 
         request(
-            pre_reader_, infinite, media_reader::static_precache_atom_v, requests, base_.uuid())
+            pre_reader_,
+            infinite,
+            media_reader::static_precache_atom_v,
+            caf::actor_cast<caf::actor>(this),
+            base_.uuid())
             .await(
                 [=](bool requests_processed) mutable { rp.deliver(requests_processed); },
                 [=](const error &err) mutable { rp.deliver(err); });
 
     } else {
+        static_precache_cursor_.active_ = false;
         request(
             pre_reader_,
             infinite,
@@ -1011,9 +1114,8 @@ void SubPlayhead::receive_image_from_cache(
 
                 image_buffer.when_to_display_ = utility::clock::now();
                 if (mptr.playhead_logical_frame_ < full_timeline_frames_.size()) {
-                    auto p = full_timeline_frames_.begin();
-                    std::advance(p, mptr.playhead_logical_frame_);
-                    image_buffer.set_timline_timestamp(p->first);
+                    auto p = full_timeline_frames_.begin() + mptr.playhead_logical_frame_;
+                    image_buffer.set_timline_timestamp(p.time());
                 } else {
                     image_buffer.set_timline_timestamp(position_flicks_);
                 }
@@ -1049,6 +1151,29 @@ void SubPlayhead::get_full_timeline_frame_list(caf::typed_response_promise<caf::
         rp.deliver(source_);
         return;
     }
+
+    if (not editable_source_) {
+        fetch_full_timeline_frames(rp, -1);
+        return;
+    }
+
+    // find out which edit the frames will include so that later ones can be
+    // spliced in. Sources that don't number their edits answer -1.
+    request(source_, infinite, utility::change_atom_v)
+        .await(
+            [=](const int edit) mutable {
+                editable_source_ = edit >= 0;
+                fetch_full_timeline_frames(rp, edit);
+            },
+            [=](const error &) mutable {
+                editable_source_ = false;
+                fetch_full_timeline_frames(rp, -1);
+            });
+}
+
+void SubPlayhead::fetch_full_timeline_frames(
+    caf::typed_response_promise<caf::actor> rp, const int edit) {
+
     // Note that the 'await' is important here ... there are a number of
     // message handlers that require full_timeline_frames_ to be up-to-date
     // so we don't want those to be available until this has completed
@@ -1062,28 +1187,92 @@ void SubPlayhead::get_full_timeline_frame_list(caf::typed_response_promise<caf::
         .await(
             [=](const media::FrameTimeMap &mpts) mutable {
                 full_timeline_frames_ = mpts;
-                timeline_logical_frame_pts_.clear();
-                int idx = 0;
-                for (const auto &f : full_timeline_frames_) {
-                    timeline_logical_frame_pts_[f.first] = idx++;
+                full_timeline_frames_changed();
+
+                rp.deliver(source_);
+                up_to_date_ = true;
+
+                // if the source was edited while we read it we can't tell
+                // which edits the frames include, and the next edit is
+                // read in full instead
+                edit_ = -1;
+                if (edit >= 0) {
+                    request(source_, infinite, utility::change_atom_v)
+                        .await(
+                            [=](const int now) {
+                                if (now == edit)
+                                    edit_ = edit;
+                            },
+                            [=](const error &) {});
                 }
+            },
+            [=](const error &err) mutable { rp.deliver(err); });
+}
 
+void SubPlayhead::splice_edit(
+    const int edit,
+    const int first_section,
+    const utility::EditList &removed,
+    const int added_sections) {
 
-                set_in_and_out_frames();
+    editable_source_ = true;
 
-                // our data has changed (full_timeline_frames_ describes most)
-                // things that are important about the timeline, so send change
-                // notification
-                send(
-                    event_group_,
-                    utility::event_atom_v,
-                    utility::change_atom_v,
-                    actor_cast<actor>(this));
+    // a full re-read is due anyway, or the frames already include the edit
+    if (not up_to_date_ or content_changed_ or edit <= edit_)
+        return;
 
-                rp.deliver(source_);
-                up_to_date_ = true;
+    // we've missed an edit, or don't know which we have
+    if (edit != edit_ + 1) {
+        anon_send(this, utility::event_atom_v, utility::change_atom_v);
+        return;
+    }
+
+    request(
+        source_,
+        infinite,
+        media::get_media_pointers_atom_v,
+        media_type_,
+        time_source_mode_,
+        override_frame_rate_,
+        edit,
+        first_section,
+        added_sections)
+        .await(
+            [=](const media::FrameTimeMap &frames) mutable {
+                // frames start where the removed sections did
+                const auto count = removed.section_frames(
+                    0, removed.size(), time_source_mode_, override_frame_rate_);
+                auto first = full_timeline_frames_.end();
+                if (not frames.empty())
+                    first = full_timeline_frames_.lower_bound(frames.begin().time());
+
+                if (first == full_timeline_frames_.end() or
+                    first.time() != frames.begin().time() or
+                    first.index() + count >= full_timeline_frames_.size()) {
+                    edit_ = -1;
+                    anon_send(this, utility::event_atom_v, utility::change_atom_v);
+                    return;
+                }
+
+                full_timeline_frames_.splice(first.index(), count, frames);
+                edit_ = edit;
+                full_timeline_frames_changed();
             },
-            [=](const error &err) mutable { rp.deliver(err); });
+            [=](const error &) mutable {
+                edit_ = -1;
+                anon_send(this, utility::event_atom_v, utility::change_atom_v);
+            });
+}
+
+void SubPlayhead::full_timeline_frames_changed() {
+
+    current_frame_ = full_timeline_frames_.begin();
+    set_in_and_out_frames();
+
+    // our data has changed (full_timeline_frames_ describes most)
+    // things that are important about the timeline, so send change
+    // notification
+    send(event_group_, utility::event_atom_v, utility::change_atom_v, actor_cast<actor>(this));
 }
 
 std::shared_ptr<const media::AVFrameID> SubPlayhead::get_frame(
@@ -1112,29 +1301,26 @@ std::shared_ptr<const media::AVFrameID> SubPlayhead::get_frame(
         return std::shared_ptr<media::AVFrameID>();
     }
 
-    timebase::flicks t = std::min(last_frame_->first, std::max(first_frame_->first, time));
+    timebase::flicks t = std::min(last_frame_.time(), std::max(first_frame_.time(), time));
 
     // get the frame to be show *after* time point t and decrement to get our
-    // frame.
-    auto tt    = utility::clock::now();
-    auto frame = full_timeline_frames_.upper_bound(t);
+    // frame. During playback t has usually moved on by a frame or less from
+    // the last call, so start looking from there.
+    auto frame = full_timeline_frames_.upper_bound(t, current_frame_);
     if (frame != full_timeline_frames_.begin())
         frame--;
+    current_frame_ = frame;
 
     // see above, there is a dummy frame at the end of full_timeline_frames_ so
     // this is always valid:
     auto next_frame = frame;
     next_frame++;
-    frame_period = next_frame->first - frame->first;
-    timeline_pts = frame->first;
+    frame_period = next_frame.time() - frame.time();
+    timeline_pts = frame.time();
 
-    auto lf = timeline_logical_frame_pts_.find(frame->first);
-    if (lf != timeline_logical_frame_pts_.end()) {
-        logical_frame = lf->second;
-    } else {
-        logical_frame = std::distance(full_timeline_frames_.begin(), frame);
-    }
-    return frame->second;
+    // the index of a frame is its logical frame
+    logical_frame = static_cast<int>(frame.index());
+    return frame.frame();
 }
 
 void SubPlayhead::get_position_after_step_by_frames(
@@ -1149,37 +1335,23 @@ void SubPlayhead::get_position_after_step_by_frames(
     }
 
     timebase::flicks t =
-        std::min(out_frame_->first, std::max(in_frame_->first, start_position));
+        std::min(out_frame_.time(), std::max(in_frame_.time(), start_position));
 
     auto frame = full_timeline_frames_.upper_bound(t);
     if (frame != full_timeline_frames_.begin())
         frame--;
 
-    const bool forwards = step_frames >= 0;
-
-    while (step_frames) {
-
-        if (forwards) {
-            if (!loop && frame == out_frame_) {
-                break;
-            } else if (frame == out_frame_) {
-                frame = in_frame_;
-            } else {
-                frame++;
-            }
-            step_frames--;
-        } else {
-            if (!loop && frame == in_frame_) {
-                break;
-            } else if (frame == in_frame_) {
-                frame = out_frame_;
-            } else {
-                frame--;
-            }
-            step_frames++;
-        }
+    // frame is inside the loop range, so the step is index arithmetic
+    const std::ptrdiff_t range = out_frame_ - in_frame_ + 1;
+    auto offset                = (frame - in_frame_) + step_frames;
+    if (loop) {
+        offset %= range;
+        if (offset < 0)
+            offset += range;
+    } else {
+        offset = std::clamp<std::ptrdiff_t>(offset, 0, range - 1);
     }
-    rp.deliver(frame->first);
+    rp.deliver((in_frame_ + offset).time());
 }
 
 void SubPlayhead::set_in_and_out_frames() {
@@ -1194,12 +1366,10 @@ void SubPlayhead::set_in_and_out_frames() {
 
     // to get to the last frame, due to the last 'dummy' frame that is appended
     // to account for the duration of the last frame, step back twice from end
-    last_frame_ = full_timeline_frames_.end();
-    last_frame_--;
-    last_frame_--;
+    last_frame_  = full_timeline_frames_.end() - 2;
     first_frame_ = full_timeline_frames_.begin();
 
-    if (loop_out_point_ > last_frame_->first) {
+    if (loop_out_point_ > last_frame_.time()) {
         out_frame_ = last_frame_;
     } else {
         out_frame_ = full_timeline_frames_.upper_bound(loop_out_point_);
@@ -1207,7 +1377,7 @@ void SubPlayhead::set_in_and_out_frames() {
             out_frame_--;
     }
 
-    if (loop_in_point_ > out_frame_->first) {
+    if (loop_in_point_ > out_frame_.time()) {
         in_frame_ = out_frame_;
     } else {
         in_frame_ = full_timeline_frames_.upper_bound(loop_in_point_);
@@ -1242,13 +1412,14 @@ void SubPlayhead::get_bookmark_ranges(
 
     int f = 0;
 
-    for (const auto &i : full_timeline_frames_) {
-        if (i.second and bookmap.count(i.second->media_uuid_)) {
+    for (auto i = full_timeline_frames_.begin(); i != full_timeline_frames_.end(); i++) {
+        const auto shared = i.shared();
+        if (shared and bookmap.count(shared->media_uuid_)) {
             // matched = false;
             // convert media frame into flick.
-            auto mf = i.second->frame_ - i.second->first_frame_;
+            auto mf = i.media_frame() - shared->first_frame_;
 
-            for (const auto &j : bookmap[i.second->media_uuid_]) {
+            for (const auto &j : bookmap[shared->media_uuid_]) {
                 const auto &[u, c, s, e] = j;
 
                 if (s <= mf and e >= mf) {
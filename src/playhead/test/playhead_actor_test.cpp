@@ -367,3 +367,136 @@ TEST(PlayheadActorTest, Test) {
     f.self->send_exit(playlist, caf::exit_reason::user_shutdown);
     f.self->send_exit(gsa, caf::exit_reason::user_shutdown);
 }
+
+TEST(PlayheadActorTest, SpliceSelectionChange) {
+
+    // a playhead that splices a change of selection into its frames ends up
+    // with the same frames as one that reads the new selection in full
+
+    FrameRate fr24(timebase::k_flicks_24fps);
+    FrameRate fr30(timebase::k_flicks_one_thirtieth_second);
+    FrameRate fr60(timebase::k_flicks_one_sixtieth_second);
+
+    fixture f;
+    auto gsa = f.self->spawn<GlobalActor>();
+
+    auto playlist = f.self->spawn<PlaylistActor>("Test");
+
+    std::vector<caf::actor> media;
+    std::vector<Uuid> media_uuids;
+    for (const auto &rate : {fr24, fr60, fr30}) {
+        const auto source_uuid = Uuid::generate();
+        const auto name        = fmt::format("Media{}", media.size() + 1);
+        media.push_back(f.self->spawn<MediaActor>(
+            name,
+            Uuid(),
+            UuidActorVector({UuidActor(
+                source_uuid,
+                f.self->spawn<MediaSourceActor>(
+                    name + "Source",
+                    posix_path_to_uri(TEST_RESOURCE "/media/test.{:04d}.ppm"),
+                    FrameList(1, 10),
+                    rate,
+                    source_uuid))})));
+        media_uuids.push_back(request_receive_wait<Uuid>(
+            *(f.self), media.back(), std::chrono::milliseconds(1000), uuid_atom_v));
+        f.self->send(playlist, add_media_atom_v, media.back(), Uuid());
+    }
+
+    std::this_thread::sleep_for(100ms);
+
+    caf::actor spliced = request_receive_wait<UuidActor>(
+                             *(f.self),
+                             playlist,
+                             std::chrono::milliseconds(1000),
+                             playlist::create_playhead_atom_v)
+                             .actor();
+
+    caf::actor selection =
+        request_receive_wait<UuidActor>(
+            *(f.self), spliced, std::chrono::milliseconds(1000), playhead::source_atom_v)
+            .actor();
+
+    caf::actor full = f.self->spawn<PlayheadActor>("Full");
+
+    try {
+
+        request_receive_wait<bool>(
+            *(f.self),
+            selection,
+            std::chrono::milliseconds(1000),
+            playlist::select_media_atom_v,
+            UuidList({media_uuids[0], media_uuids[1], media_uuids[2]}));
+
+        EXPECT_EQ(
+            request_receive_wait<int>(
+                *(f.self),
+                spliced,
+                std::chrono::milliseconds(1000),
+                playhead::duration_frames_atom_v),
+            30);
+
+        // drop the middle media, which the playhead splices out of its frames
+        request_receive_wait<bool>(
+            *(f.self),
+            selection,
+            std::chrono::milliseconds(1000),
+            playlist::select_media_atom_v,
+            UuidList({media_uuids[0], media_uuids[2]}));
+
+        std::this_thread::sleep_for(500ms);
+
+        EXPECT_EQ(
+            request_receive_wait<int>(
+                *(f.self),
+                spliced,
+                std::chrono::milliseconds(1000),
+                playhead::duration_frames_atom_v),
+            20);
+
+        // a new playhead reads the same selection in full
+        request_receive_wait<bool>(
+            *(f.self),
+            full,
+            std::chrono::milliseconds(1000),
+            playhead::playhead_rate_atom_v,
+            request_receive_wait<FrameRate>(
+                *(f.self),
+                spliced,
+                std::chrono::milliseconds(1000),
+                playhead::playhead_rate_atom_v));
+
+        request_receive_wait<bool>(
+            *(f.self),
+            full,
+            std::chrono::milliseconds(1000),
+            playhead::source_atom_v,
+            std::vector<caf::actor>({media[0], media[2]}));
+
+        const auto frames = request_receive_wait<FrameTimeMap>(
+            *(f.self), spliced, std::chrono::milliseconds(1000), get_media_pointers_atom_v);
+        const auto expected = request_receive_wait<FrameTimeMap>(
+            *(f.self), full, std::chrono::milliseconds(1000), get_media_pointers_atom_v);
+
+        ASSERT_EQ(frames.size(), expected.size());
+        for (auto i = expected.begin(), j = frames.begin(); i != expected.end(); ++i, ++j) {
+            EXPECT_EQ(j.time(), i.time());
+            ASSERT_EQ(static_cast<bool>(j.frame()), static_cast<bool>(i.frame()));
+            if (i.frame()) {
+                EXPECT_EQ(j.key(), i.key());
+                EXPECT_EQ(j.frame()->media_uuid_, i.frame()->media_uuid_);
+                EXPECT_EQ(j.frame()->frame_, i.frame()->frame_);
+                EXPECT_EQ(j.frame()->playhead_logical_frame_, i.frame()->playhead_logical_frame_);
+            }
+        }
+
+    } catch (std::exception &e) {
+
+        EXPECT_TRUE(false) << " " << e.what() << "\n";
+    }
+
+    f.self->send_exit(full, caf::exit_reason::user_shutdown);
+    f.self->send_exit(spliced, caf::exit_reason::user_shutdown);
+    f.self->send_exit(playlist, caf::exit_reason::user_shutdown);
+    f.self->send_exit(gsa, caf::exit_reason::user_shutdown);
+}
@@ -237,6 +237,15 @@ void FFMpegMediaReader::update_preferences(const utility::JsonStore &prefs) {
             preference_value<int>(prefs, "/plugin/media_reader/FFMPEG/readers_per_source");
         soundcard_sample_rate_ =
             preference_value<int>(prefs, "/core/audio/pulse_audio_prefs/sample_rate");
+        reverse_buffer_frames_ =
+            preference_value<int>(prefs, "/plugin/media_reader/FFMPEG/reverse_buffer_frames");
+        FFMpegIndexStore::instance().set_path(expand_envvars(
+            preference_value<std::string>(prefs, "/plugin/media_reader/FFMPEG/index_cache_path")));
+        DecodeThreadBudget::instance().set_preferences(
+            preference_value<int>(prefs, "/plugin/media_reader/FFMPEG/decode_thread_budget"),
+            preference_value<JsonStore>(prefs, "/plugin/media_reader/FFMPEG/codec_threading"));
+        if (decoder)
+            decoder->set_reverse_buffer_frames(reverse_buffer_frames_);
     } catch (const std::exception &e) {
         spdlog::warn("{} {}", __PRETTY_FUNCTION__, e.what());
     }
@@ -250,8 +259,24 @@ ImageBufPtr FFMpegMediaReader::image(const media::AVFrameID &mptr) {
     }
 
     if (!decoder || decoder->path() != path) {
-        decoder.reset(
-            new FFMpegDecoder(path, soundcard_sample_rate_, VIDEO_STREAM, mptr.stream_id_));
+
+        // frames of an image sequence are fed to the codec we opened for the
+        // last image of the same format, rather than opening and probing each
+        // file and setting up a new codec
+        const auto format  = fs::path(path).extension().string() + mptr.stream_id_;
+        auto image_decoder = image_decoders_.find(format);
+        if (image_decoder != image_decoders_.end() &&
+            image_decoder->second->decode_image_file(path)) {
+            decoder = image_decoder->second;
+        } else {
+            decoder.reset(
+                new FFMpegDecoder(path, soundcard_sample_rate_, VIDEO_STREAM, mptr.stream_id_));
+            decoder->set_reverse_buffer_frames(reverse_buffer_frames_);
+            if (decoder->is_still_image())
+                image_decoders_[format] = decoder;
+            else if (image_decoder != image_decoders_.end())
+                image_decoders_.erase(image_decoder);
+        }
     }
 
     ImageBufPtr rt;
@@ -320,6 +345,11 @@ AudioBufPtr FFMpegMediaReader::audio(const media::AVFrameID &mptr) {
 xstudio::media::MediaDetail FFMpegMediaReader::detail(const caf::uri &uri) const {
 
     FFMpegDecoder t_decoder(uri_to_posix_path(uri), soundcard_sample_rate_);
+
+    // index the file ahead of playback, but not on the media detail pool as
+    // reading through a long movie would hold up the detail of other media
+    FFMpegDecoder::build_index_later(t_decoder.path());
+
     // N.B. MediaDetail needs frame duration, so invert frame rate
     std::vector<media::StreamDetail> streams;
 
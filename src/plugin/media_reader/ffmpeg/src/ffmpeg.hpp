@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <map>
 #include <string>
 
 #include "xstudio/media_reader/media_reader.hpp"
@@ -37,7 +38,12 @@ namespace media_reader {
         std::shared_ptr<ffmpeg::FFMpegDecoder> audio_decoder;
         std::shared_ptr<ffmpeg::FFMpegDecoder> thumbnail_decoder;
 
+        // a still image decoder per image format (file extension), reused
+        // from one frame of a sequence to the next
+        std::map<std::string, std::shared_ptr<ffmpeg::FFMpegDecoder>> image_decoders_;
+
         int readers_per_source_;
+        int reverse_buffer_frames_ = {32};
         int soundcard_sample_rate_ = {4000};
 
         ImageBufPtr last_decoded_image_;
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "ffmpeg_convert.hpp"
+
+using namespace xstudio::media_reader::ffmpeg;
+
+namespace {
+// less than this and the threads cost more than they save
+const int min_band_rows = 32;
+
+// With chroma shared between rows, the chroma for the rows either side of a
+// band edge is filtered from both sides of it. So a band is converted along
+// with this many rows either side, which are thrown away. It's more than
+// the reach of the chroma filter, and a multiple of the dither pattern, so
+// each band comes out as it would from one pass.
+const int chroma_overlap_rows = 16;
+} // namespace
+
+ConversionThreads &ConversionThreads::instance() {
+    // deliberately leaked, decoders can be deleted during static destruction
+    static auto *threads = new ConversionThreads(
+        std::clamp(int(std::thread::hardware_concurrency()) / 2, 1, 8));
+    return *threads;
+}
+
+ConversionThreads::ConversionThreads(const int num_threads) {
+    for (int i = 0; i < num_threads; i++)
+        threads_.emplace_back(&ConversionThreads::work, this);
+}
+
+ConversionThreads::~ConversionThreads() {
+    {
+        std::lock_guard<std::mutex> l(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : threads_)
+        t.join();
+}
+
+void ConversionThreads::work() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            cv_.wait(l, [this]() { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+void ConversionThreads::run(const int count, const std::function<void(int)> &func) {
+
+    if (count < 2 || threads_.empty()) {
+        for (int i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    // Whoever is free takes the next index. A job that only gets to run
+    // after the others have done everything finds nothing left, so it never
+    // touches func once we've returned.
+    struct Batch {
+        std::atomic<int> next_ = {0};
+        int done_              = {0};
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+    auto batch = std::make_shared<Batch>();
+
+    auto take = [batch, count, &func]() {
+        int i;
+        while ((i = batch->next_++) < count) {
+            func(i);
+            std::lock_guard<std::mutex> l(batch->mutex_);
+            if (++batch->done_ == count)
+                batch->cv_.notify_all();
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> l(mutex_);
+        for (int i = 1; i < std::min(count, size() + 1); i++)
+            jobs_.emplace_back(take);
+    }
+    cv_.notify_all();
+
+    take();
+
+    std::unique_lock<std::mutex> l(batch->mutex_);
+    batch->cv_.wait(l, [&]() { return batch->done_ == count; });
+}
+
+AVPixelFormat xstudio::media_reader::ffmpeg::conversion_pix_fmt(const AVPixelFormat src) {
+
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src);
+    if (!desc || desc->comp[0].depth <= 8)
+        return AV_PIX_FMT_RGBA;
+
+    // 16 bits per channel, so 10 and 12 bit sources aren't cut down to 8
+    return desc->flags & AV_PIX_FMT_FLAG_ALPHA ? AV_PIX_FMT_RGBA64LE : AV_PIX_FMT_RGB48LE;
+}
+
+void xstudio::media_reader::ffmpeg::convert_frame(
+    const AVFrame *frame,
+    const AVPixelFormat src_fmt,
+    const AVPixelFormat dst_fmt,
+    uint8_t *dst,
+    const int dst_linesize,
+    std::vector<SwsContext *> &contexts) {
+
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src_fmt);
+    if (!desc || frame->height <= 0)
+        return;
+
+    // Each band starts on a row with a chroma row of its own. A palette (in
+    // data[1]) can't be offset, so paletted frames are done in one go.
+    const int overlap = desc->log2_chroma_h ? chroma_overlap_rows : 0;
+    const int align   = std::max(1 << desc->log2_chroma_h, overlap);
+    int bands       = 1;
+    if (!(desc->flags & AV_PIX_FMT_FLAG_PAL))
+        bands = std::max(
+            std::min(ConversionThreads::instance().size() + 1, frame->height / min_band_rows),
+            1);
+
+    const int band_rows = ((frame->height + bands - 1) / bands + align - 1) / align * align;
+    bands               = (frame->height + band_rows - 1) / band_rows;
+    if (int(contexts.size()) < bands)
+        contexts.resize(bands, nullptr);
+
+    ConversionThreads::instance().run(bands, [&](const int band) {
+        const int y    = band * band_rows;
+        const int rows = std::min(band_rows, frame->height - y);
+        const int top  = std::max(0, y - overlap);
+        const int end  = std::min(frame->height, y + rows + overlap);
+
+        // the bands can differ in height, so each has its own context
+        contexts[band] = sws_getCachedContext(
+            contexts[band],
+            frame->width,
+            end - top,
+            src_fmt,
+            frame->width,
+            end - top,
+            dst_fmt,
+            0,
+            nullptr,
+            nullptr,
+            nullptr);
+        if (!contexts[band])
+            return;
+
+        std::array<const uint8_t *, 4> src = {nullptr, nullptr, nullptr, nullptr};
+        for (int i = 0; i < 4 && frame->data[i]; i++) {
+            const int shift = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+            src[i]          = frame->data[i] + (top >> shift) * frame->linesize[i];
+        }
+        uint8_t *dst_band = dst + size_t(y) * dst_linesize;
+
+        if (!overlap) {
+            sws_scale(
+                contexts[band], src.data(), frame->linesize, 0, rows, &dst_band, &dst_linesize);
+            return;
+        }
+
+        // the overlap rows belong to the neighbouring bands, so convert into
+        // scratch memory and copy out our own rows
+        thread_local std::vector<uint8_t> scratch;
+        scratch.resize(size_t(end - top) * dst_linesize);
+        uint8_t *out = scratch.data();
+        sws_scale(contexts[band], src.data(), frame->linesize, 0, end - top, &out, &dst_linesize);
+        std::memcpy(
+            dst_band, scratch.data() + size_t(y - top) * dst_linesize, size_t(rows) * dst_linesize);
+    });
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace xstudio {
+namespace media_reader {
+    namespace ffmpeg {
+
+        /* Threads shared by every decoder in the process for converting
+        frames that the shader can't unpack. A conversion is split into bands
+        of rows that are spread over these threads and the calling thread. */
+        class ConversionThreads {
+          public:
+            static ConversionThreads &instance();
+
+            explicit ConversionThreads(const int num_threads);
+            ~ConversionThreads();
+
+            ConversionThreads(const ConversionThreads &)            = delete;
+            ConversionThreads &operator=(const ConversionThreads &) = delete;
+
+            // calls func(i) for i in [0, count) and returns when all are done
+            void run(const int count, const std::function<void(int)> &func);
+
+            [[nodiscard]] int size() const { return int(threads_.size()); }
+
+          private:
+            void work();
+
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            std::deque<std::function<void()>> jobs_;
+            std::vector<std::thread> threads_;
+            bool stop_ = {false};
+        };
+
+        // the format we convert to for the shader, wide enough to keep the
+        // precision of the source
+        AVPixelFormat conversion_pix_fmt(const AVPixelFormat src);
+
+        // sws_scale a frame to dst_fmt at the same size, a band of rows per
+        // conversion thread, with the same result as a single sws_scale.
+        // contexts holds a cached SwsContext per band and is owned by the
+        // caller, who must sws_freeContext them.
+        void convert_frame(
+            const AVFrame *frame,
+            const AVPixelFormat src_fmt,
+            const AVPixelFormat dst_fmt,
+            uint8_t *dst,
+            const int dst_linesize,
+            std::vector<SwsContext *> &contexts);
+
+    } // namespace ffmpeg
+} // namespace media_reader
+} // namespace xstudio
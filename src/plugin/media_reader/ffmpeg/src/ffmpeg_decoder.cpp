@@ -1,5 +1,12 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 
 #include "ffmpeg_decoder.hpp"
@@ -16,6 +23,65 @@ namespace {
 std::string make_stream_id(const int stream_index) {
     return fmt::format("stream {}", stream_index);
 }
+
+// files waiting to be indexed, handled in order on a thread of their own
+class IndexWorker {
+  public:
+    IndexWorker() : thread_(&IndexWorker::run, this) {}
+
+    ~IndexWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            queue_.clear();
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    void add(const std::string &path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.size() >= max_queued_ ||
+                std::find(queue_.begin(), queue_.end(), path) != queue_.end())
+                return;
+            queue_.push_back(path);
+        }
+        cv_.notify_one();
+    }
+
+  private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (stop_)
+                return;
+            const auto path = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            try {
+                FFMpegDecoder decoder(path, 44100, VIDEO_STREAM);
+                decoder.build_index([this] { return stop_.load(); });
+            } catch (const std::exception &e) {
+                spdlog::warn("{} {} {}", __PRETTY_FUNCTION__, path, e.what());
+            }
+            lock.lock();
+        }
+    }
+
+    // files still queued past this are indexed on their first detail read
+    // after the queue has drained
+    static constexpr size_t max_queued_ = 1024;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> queue_;
+    // also checked while a file is read through, so exit isn't held up
+    // waiting for a long movie to be indexed
+    std::atomic<bool> stop_ = {false};
+    std::thread thread_;
+};
 } // namespace
 
 int FFMpegDecoder::ffmpeg_threads = 8;
@@ -86,6 +152,12 @@ void FFMpegDecoder::open_handles() {
         video_frame_rate_ = primary_video_stream_->frame_rate();
     }
 
+    // a persistent index lets the demuxer seek straight to keyframes in
+    // containers that don't index their own frames
+    if (index_key_.empty() && primary_video_stream_ && !primary_video_stream_->is_single_frame())
+        index_key_ = FFMpegIndexStore::key(movie_file_path_);
+    add_stored_index();
+
     calc_duration_frames();
 
     // now remove streams that we aren't interested in
@@ -356,7 +428,13 @@ void FFMpegDecoder::decode_video_frame(
             return;
         }
 
-        if (last_requested_frame_ != (frame_num - 1)) {
+        keep_frames_from_ = frame_num;
+        if (decoding_backwards_ && primary_video_stream_) {
+            // decode forwards through the frames leading up to this one and
+            // hold them, they are next to be asked for
+            keep_frames_from_ = reverse_window_start(frame_num);
+            do_seek(keep_frames_from_);
+        } else if (last_requested_frame_ != (frame_num - 1)) {
             do_seek(frame_num);
         }
 
@@ -536,9 +614,9 @@ void FFMpegDecoder::pull_audio_buffer_from_stream(StreamPtr &audio_stream) {
 void FFMpegDecoder::pull_video_buffer_from_stream(StreamPtr &video_stream) {
 
     // Do we want the frame that was just decoded from video_stream ?
-    // are we decoding forwards (after a seek) and haven't got to the frame we need?
-    if (video_stream && video_stream->current_frame() < requested_video_frame_ &&
-        !decoding_backwards_)
+    // not if we're decoding forwards (after a seek) and haven't got to the
+    // frame we need, or the window of frames we're holding for reverse playback
+    if (video_stream && video_stream->current_frame() < keep_frames_from_)
         return;
 
     ImageBufPtr buf;
@@ -619,13 +697,6 @@ void FFMpegDecoder::attach_audio_to_video_and_deliver(ImageBufPtr buf) {
 
 void FFMpegDecoder::do_seek(const int seek_frame, bool force) {
 
-    // tring a couple of tricks here ... the assumption is any codec that can't
-    // seek to an exact frame can only decode forwards efficiently. If we are
-    // decoding backwards, it's best to go a good few frames back and then
-    // decode forwards until we get the frame we need. All the intermediate
-    // frames will be put in our mini cache, so next time we need a frame
-    // that is before the one we were just asked for it's already decoded.
-
     if (primary_video_stream_)
         primary_video_stream_->set_current_frame_unknown();
 
@@ -655,15 +726,15 @@ void FFMpegDecoder::do_seek(const int seek_frame, bool force) {
         video_frames_with_incomplete_audio_.clear();
         video_frame_mini_cache_.clear();
 
-    } else if (
-        primary_video_stream_ &&
-        (force || seek_frame <= last_requested_frame_ ||
-         seek_frame > (last_requested_frame_ + MIN_SEEK_FORWARD_FRAMES))) {
+    } else if (primary_video_stream_ && (force || seek_needed(seek_frame))) {
 
-        // here, if we are going backwards frame by frames, we are going
-        // to jump back by 16 frames
-        int64_t timestamp = primary_video_stream_->frame_to_pts(
-            decoding_backwards_ ? std::max(seek_frame - 16, 0) : seek_frame);
+        // the index is built in the background, it may have turned up since
+        // the file was opened. It's only looked for again once one has been
+        // added, and then only in memory, as that's where new ones go.
+        if (!have_index_ && index_generation_ != FFMpegIndexStore::instance().generation())
+            add_stored_index(false);
+
+        int64_t timestamp = primary_video_stream_->seek_timestamp(seek_frame);
 
         primary_video_stream_->flush_buffers();
         if (primary_audio_stream_)
@@ -689,6 +760,127 @@ void FFMpegDecoder::do_seek(const int seek_frame, bool force) {
     }
 }
 
+bool FFMpegDecoder::seek_needed(const int frame_num) const {
+
+    if (frame_num <= last_requested_frame_)
+        return true;
+    if (frame_num <= last_requested_frame_ + MIN_SEEK_FORWARD_FRAMES)
+        return false;
+
+    // further ahead, decoding on from where we are still beats seeking unless
+    // there's a keyframe between here and the frame we want. That's only
+    // certain if every keyframe is listed.
+    if (!primary_video_stream_->keyframes_complete())
+        return true;
+    const auto &keyframes = primary_video_stream_->keyframes();
+    if (keyframes.empty())
+        return true;
+    auto keyframe =
+        std::upper_bound(keyframes.begin(), keyframes.end(), last_requested_frame_);
+    return keyframe != keyframes.end() && *keyframe <= frame_num;
+}
+
+void FFMpegDecoder::build_index(const std::function<bool()> &cancelled) {
+
+    if (!primary_video_stream_ || index_key_.empty() ||
+        FFMpegIndexStore::instance().find(index_key_))
+        return;
+
+    auto index =
+        FFMpegIndex::build(av_format_ctx_, primary_video_stream_->stream_index(), cancelled);
+
+    // building the index may have moved the read position
+    last_requested_frame_ = -100;
+
+    if (!index)
+        return;
+    FFMpegIndexStore::instance().add(index_key_, index);
+    primary_video_stream_->add_index(*index);
+    have_index_ = true;
+}
+
+void FFMpegDecoder::build_index_later(const std::string &path) {
+
+    // one worker for the whole process, indexing a file at a time so that
+    // reading through movies doesn't compete with playback for disk bandwidth
+    static IndexWorker worker;
+    worker.add(path);
+}
+
+void FFMpegDecoder::add_stored_index(const bool from_disk) {
+
+    if (!primary_video_stream_ || index_key_.empty())
+        return;
+
+    // read first, so an index added while we look is looked for next time
+    auto &store       = FFMpegIndexStore::instance();
+    index_generation_ = store.generation();
+    if (auto index = store.find(index_key_, from_disk)) {
+        primary_video_stream_->add_index(*index);
+        have_index_ = true;
+    }
+}
+
+bool FFMpegDecoder::is_still_image() const {
+
+    // image2 reads each file whole into one packet, as do the single image
+    // '_pipe' demuxers, so the file's bytes are exactly what the codec wants
+    if (!primary_video_stream_ || primary_audio_stream_ ||
+        !primary_video_stream_->is_single_frame() || !av_format_ctx_->iformat)
+        return false;
+    const std::string format(av_format_ctx_->iformat->name);
+    return format == "image2" ||
+           (format.size() > 5 && format.compare(format.size() - 5, 5, "_pipe") == 0);
+}
+
+bool FFMpegDecoder::decode_image_file(const std::string &path) {
+
+    if (!is_still_image())
+        return false;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    const auto size = static_cast<int>(file.tellg());
+    if (size <= 0 || av_new_packet(avc_packet_, size))
+        return false;
+
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(avc_packet_->data), size)) {
+        av_packet_unref(avc_packet_);
+        return false;
+    }
+    avc_packet_->stream_index = primary_video_stream_->stream_index();
+    avc_packet_->flags |= AV_PKT_FLAG_KEY;
+
+    if (!primary_video_stream_->decode_image_packet(avc_packet_))
+        return false;
+
+    // we now hold the frame for this file, which decode_video_frame hands out
+    movie_file_path_      = path;
+    last_requested_frame_ = -100;
+    video_frame_mini_cache_.clear();
+    return true;
+}
+
+int64_t FFMpegDecoder::reverse_window_start(const int64_t frame_num) {
+
+    // Any codec that can't seek to an exact frame can only decode forwards
+    // efficiently, so for reverse playback we seek to the keyframe before a
+    // window of frames leading up to the one we want, decode forwards through
+    // it and hold the frames in our mini cache to hand out in descending order.
+    // If a keyframe falls in the window we start it there instead, then nothing
+    // we decode is thrown away and each GOP is decoded once, as long as
+    // reverse_buffer_frames_ covers it. Without a keyframe index we go back a
+    // full window and let av_seek_frame find the keyframe.
+    const int64_t start   = std::max(frame_num - reverse_buffer_frames_ + 1, int64_t(0));
+    const auto &keyframes = primary_video_stream_->keyframes();
+    auto keyframe         = std::lower_bound(keyframes.begin(), keyframes.end(), start);
+    if (keyframe != keyframes.end() && *keyframe <= frame_num)
+        return *keyframe;
+    return start;
+}
+
 void FFMpegDecoder::empty_mini_caches(const int decoded_frame) {
 
     const bool decoding_backwards = (last_requested_frame_ - decoded_frame) == 1 ||
@@ -29,10 +29,35 @@ namespace media_reader {
             decode_thumbnail_frame(const int64_t frame_num, const size_t size_hint);
 
             const std::string &path() const { return movie_file_path_; }
+            const std::string &stream_id() const { return stream_id_; }
             int64_t duration_frames() const { return duration_frames_; }
             utility::FrameRate frame_rate(unsigned int stream_idx = UINT_MAX) const;
             utility::Timecode first_frame_timecode();
 
+            // true for a single image file read by one of ffmpeg's image
+            // demuxers, i.e. one frame of a JPEG/PNG/DPX etc. sequence
+            bool is_still_image() const;
+
+            // decode another still image file of the same format with the codec
+            // that's already open, skipping the open and probe of the file. The
+            // frame is then returned by decode_video_frame. False if the file
+            // couldn't be decoded this way, and it needs a decoder of its own.
+            bool decode_image_file(const std::string &path);
+
+            // make sure there's a persistent keyframe index for the file. Reads
+            // through the whole file if the container doesn't index its frames,
+            // giving up if cancelled returns true.
+            void build_index(const std::function<bool()> &cancelled = {});
+
+            // build_index() for the file on a background thread, without
+            // holding up the caller
+            static void build_index_later(const std::string &path);
+
+            // the most frames decoded ahead and held for reverse playback
+            void set_reverse_buffer_frames(const int frames) {
+                reverse_buffer_frames_ = std::max(frames, 1);
+            }
+
             static int ffmpeg_threads;
 
             const std::map<unsigned int, StreamPtr> &streams() const { return streams_; };
@@ -56,6 +81,9 @@ namespace media_reader {
             void attach_audio_to_video();
             void attach_audio_to_video_and_deliver(ImageBufPtr buf);
             void do_seek(const int seek_frame, const bool force = false);
+            bool seek_needed(const int frame_num) const;
+            void add_stored_index(const bool from_disk = true);
+            int64_t reverse_window_start(const int64_t frame_num);
             void empty_mini_caches(const int decoded_frame);
             bool is_single_frame() const;
 
@@ -66,6 +94,11 @@ namespace media_reader {
             StreamPtr primary_audio_stream_;
             StreamPtr primary_video_stream_;
             StreamPtr timecode_stream_;
+            bool have_index_ = {false};
+            // what the file's index is stored under, empty if it has none
+            std::string index_key_;
+            // the index store's generation when we last looked for an index
+            uint64_t index_generation_ = {0};
             utility::FrameRate video_frame_rate_;
 
             std::map<double, AudioBufPtr> audio_frames_unnattached_to_video_;
@@ -75,6 +108,9 @@ namespace media_reader {
 
             std::map<unsigned int, StreamPtr> streams_;
             bool decoding_backwards_;
+            int reverse_buffer_frames_ = {32};
+            // decoded video frames before this one aren't wanted
+            int64_t keep_frames_from_ = {0};
             const int soundcard_sample_rate_;
             int64_t duration_frames_;
             FFMpegStreamType wanted_stream_type_;
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <cstdio>
+#include <cstring>
+
+#include <fmt/format.h>
+
+#include "ffmpeg_index.hpp"
+#include "ffmpeg_stream.hpp"
+#include "xstudio/utility/hash.hpp"
+
+using namespace xstudio::media_reader::ffmpeg;
+using namespace xstudio;
+
+namespace {
+const uint32_t index_file_magic   = 0x49534b58; // 'XSKI'
+const uint32_t index_file_version = 2;
+// indexes kept in memory, they're small but there's no need to keep every one
+const size_t max_indexes_in_memory = 256;
+
+using file_ptr = std::unique_ptr<FILE, decltype(&fclose)>;
+
+file_ptr open_file(const fs::path &path, const char *mode) {
+    return file_ptr(fopen(path.c_str(), mode), &fclose);
+}
+} // namespace
+
+std::shared_ptr<FFMpegIndex> FFMpegIndex::build(
+    AVFormatContext *format_context,
+    const int stream_index,
+    const std::function<bool()> &cancelled) {
+
+    auto index           = std::make_shared<FFMpegIndex>();
+    index->stream_index_ = stream_index;
+    AVStream *stream     = format_context->streams[stream_index];
+
+    // demuxers with a generic index only add to it as packets are read, so
+    // what's there after opening the file is a partial list
+    const bool generic_index = format_context->iformat->flags & AVFMT_GENERIC_INDEX;
+    const int count          = index_entries_count(stream);
+    if (count > 1 && !generic_index) {
+        for (int i = 0; i < count; i++) {
+            const AVIndexEntry *entry = index_entry(stream, i);
+            if (entry && (entry->flags & AVINDEX_KEYFRAME) &&
+                entry->timestamp != AV_NOPTS_VALUE)
+                index->keyframes_.push_back(
+                    {stream_pts_to_frame(stream, entry->timestamp),
+                     entry->timestamp,
+                     entry->pos,
+                     entry->size});
+        }
+        // the mov demuxer fills its index from the sample tables, which list
+        // every sample. Other containers' indexes may skip keyframes.
+        index->complete_ = std::strncmp(format_context->iformat->name, "mov,", 4) == 0;
+        return index;
+    }
+
+    // no index in the container, read every packet from the start. Only the
+    // packet headers are looked at, nothing is decoded.
+    av_seek_frame(format_context, stream_index, 0, AVSEEK_FLAG_BYTE);
+    AVPacket *packet = av_packet_alloc();
+    while (av_read_frame(format_context, packet) == 0) {
+        if (cancelled && cancelled()) {
+            av_packet_free(&packet);
+            return {};
+        }
+        if (packet->stream_index == stream_index && (packet->flags & AV_PKT_FLAG_KEY)) {
+            const int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE)
+                index->keyframes_.push_back(
+                    {stream_pts_to_frame(stream, pts), pts, packet->pos, packet->size});
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    index->complete_ = true;
+
+    return index;
+}
+
+bool FFMpegIndex::save(const fs::path &path) const {
+
+    // written to one side and moved into place, so readers never see half a file
+    const auto tmp_path = fs::path(path.string() + ".tmp");
+    {
+        auto fp = open_file(tmp_path, "wb");
+        if (!fp)
+            return false;
+
+        const int32_t stream_index = stream_index_;
+        const uint8_t complete     = complete_ ? 1 : 0;
+        const uint64_t count       = keyframes_.size();
+
+        bool ok = fwrite(&index_file_magic, sizeof(index_file_magic), 1, fp.get()) == 1 &&
+                  fwrite(&index_file_version, sizeof(index_file_version), 1, fp.get()) == 1 &&
+                  fwrite(&stream_index, sizeof(stream_index), 1, fp.get()) == 1 &&
+                  fwrite(&complete, sizeof(complete), 1, fp.get()) == 1 &&
+                  fwrite(&count, sizeof(count), 1, fp.get()) == 1;
+        for (const auto &entry : keyframes_) {
+            ok = ok && fwrite(&entry.frame_, sizeof(entry.frame_), 1, fp.get()) == 1 &&
+                 fwrite(&entry.pts_, sizeof(entry.pts_), 1, fp.get()) == 1 &&
+                 fwrite(&entry.pos_, sizeof(entry.pos_), 1, fp.get()) == 1 &&
+                 fwrite(&entry.size_, sizeof(entry.size_), 1, fp.get()) == 1;
+        }
+        if (!ok) {
+            fp.reset();
+            std::error_code ec;
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+std::shared_ptr<FFMpegIndex> FFMpegIndex::load(const fs::path &path) {
+
+    auto fp = open_file(path, "rb");
+    if (!fp)
+        return {};
+
+    uint32_t magic       = 0;
+    uint32_t version     = 0;
+    int32_t stream_index = -1;
+    uint8_t complete     = 0;
+    uint64_t count       = 0;
+    if (fread(&magic, sizeof(magic), 1, fp.get()) != 1 || magic != index_file_magic ||
+        fread(&version, sizeof(version), 1, fp.get()) != 1 || version != index_file_version ||
+        fread(&stream_index, sizeof(stream_index), 1, fp.get()) != 1 ||
+        fread(&complete, sizeof(complete), 1, fp.get()) != 1 ||
+        fread(&count, sizeof(count), 1, fp.get()) != 1)
+        return {};
+
+    auto index           = std::make_shared<FFMpegIndex>();
+    index->stream_index_ = stream_index;
+    index->complete_     = complete != 0;
+    index->keyframes_.resize(count);
+    for (auto &entry : index->keyframes_) {
+        if (fread(&entry.frame_, sizeof(entry.frame_), 1, fp.get()) != 1 ||
+            fread(&entry.pts_, sizeof(entry.pts_), 1, fp.get()) != 1 ||
+            fread(&entry.pos_, sizeof(entry.pos_), 1, fp.get()) != 1 ||
+            fread(&entry.size_, sizeof(entry.size_), 1, fp.get()) != 1)
+            return {};
+    }
+    return index;
+}
+
+FFMpegIndexStore &FFMpegIndexStore::instance() {
+    static FFMpegIndexStore store;
+    return store;
+}
+
+void FFMpegIndexStore::set_path(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    if (!path_.empty()) {
+        std::error_code ec;
+        fs::create_directories(path_, ec);
+    }
+}
+
+std::string FFMpegIndexStore::key(const std::string &movie_path) {
+    std::error_code ec;
+    const auto size = fs::file_size(movie_path, ec);
+    if (ec)
+        return "";
+    const auto mtime = fs::last_write_time(movie_path, ec);
+    if (ec)
+        return "";
+
+    const auto id   = fmt::format(
+        "{}|{}|{}", movie_path, size, int64_t(mtime.time_since_epoch().count()));
+    const auto hash = utility::hash128(id.data(), id.size());
+    return fmt::format("{:016x}{:016x}", hash.first, hash.second);
+}
+
+FFMpegIndexPtr FFMpegIndexStore::find(const std::string &key, const bool from_disk) {
+
+    if (key.empty())
+        return {};
+
+    fs::path path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto p = lookup_.find(key);
+        if (p != lookup_.end()) {
+            indexes_.splice(indexes_.begin(), indexes_, p->second);
+            return p->second->second;
+        }
+        if (!from_disk || path_.empty())
+            return {};
+        path = path_ / (key + ".idx");
+    }
+
+    FFMpegIndexPtr index = FFMpegIndex::load(path);
+    if (index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remember(key, index);
+    }
+    return index;
+}
+
+void FFMpegIndexStore::add(const std::string &key, FFMpegIndexPtr index) {
+
+    if (key.empty() || !index)
+        return;
+
+    fs::path path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remember(key, index);
+        if (!path_.empty())
+            path = path_ / (key + ".idx");
+    }
+    generation_++;
+
+    if (!path.empty() && !index->save(path))
+        spdlog::warn("{} Failed to write index {}", __PRETTY_FUNCTION__, path.string());
+}
+
+void FFMpegIndexStore::remember(const std::string &key, FFMpegIndexPtr index) {
+
+    auto p = lookup_.find(key);
+    if (p != lookup_.end()) {
+        p->second->second = std::move(index);
+        indexes_.splice(indexes_.begin(), indexes_, p->second);
+        return;
+    }
+
+    indexes_.emplace_front(key, std::move(index));
+    lookup_[key] = indexes_.begin();
+    if (indexes_.size() > max_indexes_in_memory) {
+        lookup_.erase(indexes_.back().first);
+        indexes_.pop_back();
+    }
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace xstudio {
+namespace media_reader {
+    namespace ffmpeg {
+
+        namespace fs = std::filesystem;
+
+        /* Where the keyframes of a movie file's video stream are. A decoder
+        can hand these to the demuxer so it seeks straight to the keyframe
+        before a frame, even for containers without an index of their own. */
+        struct FFMpegIndex {
+
+            struct Entry {
+                int64_t frame_;
+                int64_t pts_;
+                int64_t pos_;
+                int32_t size_;
+            };
+
+            // read from the demuxer's own index if it indexes the whole file
+            // up front, otherwise by reading through every packet in the file.
+            // Leaves the read position anywhere, so the caller must seek
+            // afterwards. Reading through the file stops, returning null, as
+            // soon as cancelled returns true.
+            static std::shared_ptr<FFMpegIndex> build(
+                AVFormatContext *format_context,
+                const int stream_index,
+                const std::function<bool()> &cancelled = {});
+
+            bool save(const fs::path &path) const;
+            static std::shared_ptr<FFMpegIndex> load(const fs::path &path);
+
+            int stream_index_ = {-1};
+            // every keyframe in the file is listed, so a frame with no keyframe
+            // listed before it can be decoded on to without seeking
+            bool complete_ = {false};
+            std::vector<Entry> keyframes_;
+        };
+        typedef std::shared_ptr<const FFMpegIndex> FFMpegIndexPtr;
+
+        /* Process wide store of indexes, in memory and on disk. Index files are
+        keyed on the movie's path, size and modification time, so a file is only
+        indexed once until it changes. Files are read and written outside the
+        lock, so a slow disk only holds up the caller. */
+        class FFMpegIndexStore {
+          public:
+            static FFMpegIndexStore &instance();
+
+            // empty keeps indexes in memory only
+            void set_path(const std::string &path);
+
+            // what indexes for the movie are stored under, empty if the file
+            // can't be read. Looks at the file, so callers keep hold of it.
+            static std::string key(const std::string &movie_path);
+
+            // from memory, or disk unless from_disk is false. Null if the file
+            // hasn't been indexed.
+            FFMpegIndexPtr find(const std::string &key, const bool from_disk = true);
+
+            void add(const std::string &key, FFMpegIndexPtr index);
+
+            // goes up with every add(), so a caller that didn't find an index
+            // need only look again once it has changed
+            uint64_t generation() const { return generation_; }
+
+          private:
+            FFMpegIndexStore() = default;
+
+            // most recently used first, the oldest dropped past the limit
+            void remember(const std::string &key, FFMpegIndexPtr index);
+
+            std::mutex mutex_;
+            fs::path path_;
+            std::list<std::pair<std::string, FFMpegIndexPtr>> indexes_;
+            std::unordered_map<std::string, decltype(indexes_)::iterator> lookup_;
+            std::atomic<uint64_t> generation_ = {0};
+        };
+
+    } // namespace ffmpeg
+} // namespace media_reader
+} // namespace xstudio
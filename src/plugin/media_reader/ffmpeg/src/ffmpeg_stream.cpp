@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <sstream>
@@ -12,6 +13,34 @@
 using namespace xstudio::media_reader::ffmpeg;
 using namespace xstudio::media_reader;
 using namespace xstudio;
+
+int64_t xstudio::media_reader::ffmpeg::stream_pts_to_frame(
+    const AVStream *stream, const int64_t pts) {
+    const int64_t start_time = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    if (stream->avg_frame_rate.num != 0 && stream->avg_frame_rate.den != 0) {
+        return int(floor(
+            double((pts - start_time) * stream->time_base.num * stream->avg_frame_rate.num) /
+            double(stream->time_base.den * stream->avg_frame_rate.den)));
+    }
+    return ((pts - start_time) * stream->time_base.num) / (stream->time_base.den);
+}
+
+int xstudio::media_reader::ffmpeg::index_entries_count(AVStream *stream) {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+    return avformat_index_get_entries_count(stream);
+#else
+    return stream->nb_index_entries;
+#endif
+}
+
+const AVIndexEntry *xstudio::media_reader::ffmpeg::index_entry(AVStream *stream, const int i) {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+    return avformat_index_get_entry(stream, i);
+#else
+    return &stream->index_entries[i];
+#endif
+}
+
 // check for error code on an avcodec function and throw an exception
 void xstudio::media_reader::ffmpeg::AVC_CHECK_THROW(int errorNum, const char *avc_command) {
     if (!errorNum)
@@ -257,8 +286,41 @@ static int setup_video_buffer(AVCodecContext *ctx, AVFrame *frame, int /*flags*/
     return 0;
 }
 
+// If a decoder that allocates its own frames has put all the planes in one
+// buffer, with room after them for the padding ImageBuffer needs, the image
+// can be that buffer. Returns the image's size in that case, otherwise 0.
+size_t size_in_decoder_buffer(const AVFrame *frame, const std::array<size_t, 4> &planesizes) {
+
+    if (!frame->buf[0] || !frame->data[0])
+        return 0;
+
+    const uint8_t *begin = frame->buf[0]->data;
+    const uint8_t *end   = begin + frame->buf[0]->size;
+    size_t size          = 0;
+    for (int i = 0; i < 4 && frame->data[i]; i++) {
+        if (frame->data[i] < frame->data[0] || frame->data[i] + planesizes[i] > end)
+            return 0;
+        size = std::max(size, size_t(frame->data[i] - frame->data[0]) + planesizes[i]);
+    }
+
+    size = ImageBuffer::padded_size(size);
+    return frame->data[0] >= begin && frame->data[0] + size <= end ? size : 0;
+}
+
 } // namespace
 
+FFMpegStream::FrameCopyStats FFMpegStream::copy_stats;
+std::atomic<bool> FFMpegStream::allocate_frames{true};
+
+xstudio::utility::JsonStore FFMpegStream::FrameCopyStats::json() const {
+    utility::JsonStore result;
+    result["frames"]            = frames_.load();
+    result["referenced_frames"] = referenced_frames_.load();
+    result["copied_frames"]     = copied_frames_.load();
+    result["bytes_copied"]      = bytes_copied_.load();
+    return result;
+}
+
 ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
 
     ImageBufPtr image_buffer;
@@ -280,33 +342,24 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
                 ffmpeg_pixel_format);
         }
 
-        image_buffer.reset(new ImageBuffer());
-        auto buffer = (uint8_t *)image_buffer->allocate(4 * frame->width * frame->height);
         // not one of the ffmpeg pixel formats that our shader can deal with, so convert to
-        // something we can
-        sws_context_ = sws_getCachedContext(
-            sws_context_,
-            frame->width,
-            frame->height,
-            (AVPixelFormat)ffmpeg_pixel_format,
-            frame->width,
-            frame->height,
-            AV_PIX_FMT_RGBA,
-            0,
-            nullptr,
-            nullptr,
-            nullptr);
+        // something we can, spreading the work over the conversion threads
+        const AVPixelFormat target_format =
+            conversion_pix_fmt((AVPixelFormat)ffmpeg_pixel_format);
+        const std::array<int, 1> out_linesize(
+            {av_image_get_linesize(target_format, frame->width, 0)});
 
-        const std::array<int, 1> out_linesize({4 * frame->width});
+        image_buffer.reset(new ImageBuffer());
+        auto buffer =
+            (uint8_t *)image_buffer->allocate(size_t(out_linesize[0]) * frame->height);
 
-        sws_scale(
-            sws_context_,
-            frame->data,
-            frame->linesize,
-            0,
-            frame->height,
-            &buffer,
-            out_linesize.data());
+        convert_frame(
+            frame,
+            (AVPixelFormat)ffmpeg_pixel_format,
+            target_format,
+            buffer,
+            out_linesize[0],
+            conversion_contexts_);
 
         jsn["y_linesize"]           = out_linesize[0];
         jsn["u_linesize"]           = 0;
@@ -317,7 +370,7 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
         jsn["v_plane_bytes_offset"] = 0;
         jsn["a_plane_bytes_offset"] = 0;
 
-        ffmpeg_pixel_format = AV_PIX_FMT_RGBA;
+        ffmpeg_pixel_format = target_format;
 
     } else {
 
@@ -336,6 +389,9 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
             spdlog::error("Error detecting decoded frame plane sizes");
         }
 
+        const size_t size_in_place =
+            using_own_frame_allocation ? 0 : size_in_decoder_buffer(frame, planesizes);
+
         // Decoder supports custom allocators (AV_CODEC_CAP_DR1)
         if (using_own_frame_allocation && frame->buf[0] && frame->buf[0]->data) {
 
@@ -350,6 +406,26 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
                 }
             }
 
+        } else if (size_in_place) {
+
+            // Decoder manages video memory, but it's laid out as we need it.
+            // Taking a reference to the frame stops the decoder reusing the
+            // memory for as long as the image buffer is alive.
+            std::shared_ptr<void> frame_ref(av_frame_clone(frame), [](void *p) {
+                auto f = static_cast<AVFrame *>(p);
+                av_frame_free(&f);
+            });
+
+            image_buffer.reset(new ImageBuffer());
+            image_buffer->reference((byte *)frame->data[0], size_in_place, frame_ref);
+            copy_stats.referenced_frames_++;
+
+            for (int i = 0; i < 4; ++i) {
+                if (frame->data[i]) {
+                    offsets[i] = (size_t)frame->data[i] - (size_t)frame->data[0];
+                }
+            }
+
             // Decoder manages video memory, so we don't have guaranteed ownership
             // of it and we need to copy it to xstudio image buffer.
         } else {
@@ -368,6 +444,8 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
                     std::memcpy(buffer + offsets[i], frame->data[i], planesizes[i]);
                 }
             }
+            copy_stats.copied_frames_++;
+            copy_stats.bytes_copied_ += total_size;
         }
 
         jsn["y_linesize"]           = frame->linesize[0];
@@ -412,6 +490,9 @@ ImageBufPtr FFMpegStream::get_ffmpeg_frame_as_xstudio_image() {
 
     image_buffer->set_decoder_frame_number(current_frame());
 
+    if (++copy_stats.frames_ % 1000 == 0)
+        spdlog::debug("FFMPEG decoded frame copies {}", copy_stats.json().dump());
+
     return image_buffer;
 }
 
@@ -570,14 +651,12 @@ FFMpegStream::FFMpegStream(
 
         stream_type_ = VIDEO_STREAM;
 
-        if (codec_->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
-            codec_context_->thread_count = thread_count;
-            codec_context_->thread_type  = FF_THREAD_SLICE;
-        }
-        if (codec_->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
-            codec_context_->thread_count = thread_count;
-            codec_context_->thread_type |= FF_THREAD_FRAME;
-        }
+        // the codec's threads come out of a budget shared by every decoder
+        threads_ = DecodeThreadBudget::instance().acquire(
+            codec_->name, codec_->capabilities, thread_count);
+        codec_context_->thread_count = threads_->threads_;
+        if (threads_->thread_type_)
+            codec_context_->thread_type = threads_->thread_type_;
 
         /** initialize the stream parameters with demuxer information */
         AVC_CHECK_THROW(
@@ -589,7 +668,7 @@ FFMpegStream::FFMpegStream(
         frame->height = avc_stream_->codecpar->height;
         frame->format = codec_context_->pix_fmt;
 
-        if (codec_->capabilities & AV_CODEC_CAP_DR1) {
+        if (allocate_frames && (codec_->capabilities & AV_CODEC_CAP_DR1)) {
 
             // See Note 1 below
             // codec_ allows us to allocated AVFrame buffers
@@ -634,6 +713,8 @@ FFMpegStream::~FFMpegStream() {
     }
     if (sws_context_)
         sws_freeContext(sws_context_);
+    for (auto context : conversion_contexts_)
+        sws_freeContext(context);
 }
 
 int64_t FFMpegStream::current_frame() {
@@ -645,20 +726,65 @@ int64_t FFMpegStream::current_frame() {
     if (current_frame_ != CURRENT_FRAME_UNKNOWN)
         return current_frame_;
 
-    current_frame_ = 0;
-    if (fpsNum_) {
-        current_frame_ = int(floor(
-            double(
-                (frame->best_effort_timestamp - stream_start_time()) *
-                avc_stream_->time_base.num * fpsNum_) /
-            double(avc_stream_->time_base.den * fpsDen_)));
-    } else {
-        current_frame_ = ((frame->best_effort_timestamp - stream_start_time()) *
-                          avc_stream_->time_base.num) /
-                         (avc_stream_->time_base.den);
+    current_frame_ = pts_to_frame(frame->best_effort_timestamp);
+    return current_frame_;
+}
+
+int64_t FFMpegStream::pts_to_frame(const int64_t pts) const {
+    return stream_pts_to_frame(avc_stream_, pts);
+}
+
+const std::vector<int64_t> &FFMpegStream::keyframes() {
+
+    if (keyframes_)
+        return *keyframes_;
+
+    std::vector<std::pair<int64_t, int64_t>> frames_and_pts;
+    const int count = index_entries_count(avc_stream_);
+    for (int i = 0; i < count; i++) {
+        const AVIndexEntry *entry = index_entry(avc_stream_, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME) && entry->timestamp != AV_NOPTS_VALUE)
+            frames_and_pts.emplace_back(pts_to_frame(entry->timestamp), entry->timestamp);
     }
+    std::sort(frames_and_pts.begin(), frames_and_pts.end());
+
+    keyframes_ = std::vector<int64_t>();
+    keyframe_pts_.clear();
+    for (const auto &p : frames_and_pts) {
+        if (keyframes_->empty() || keyframes_->back() != p.first) {
+            keyframes_->push_back(p.first);
+            keyframe_pts_.push_back(p.second);
+        }
+    }
+    return *keyframes_;
+}
 
-    return current_frame_;
+int64_t FFMpegStream::seek_timestamp(const int frame) {
+
+    // seeking to the keyframe's own timestamp, rather than one worked out
+    // from the frame number, can't land on the keyframe before it
+    const auto &frames = keyframes();
+    auto keyframe      = std::upper_bound(frames.begin(), frames.end(), int64_t(frame));
+    if (keyframe == frames.begin())
+        return frame_to_pts(frame);
+    return keyframe_pts_[std::distance(frames.begin(), keyframe) - 1];
+}
+
+void FFMpegStream::add_index(const FFMpegIndex &index) {
+
+    if (index.stream_index_ != stream_index_)
+        return;
+    keyframes_complete_ = index.complete_;
+
+    // the demuxer's own index wins if it has one, unless it's a generic index
+    // that only holds the packets read so far
+    if (index_entries_count(avc_stream_) > 1 &&
+        !(format_context_->iformat->flags & AVFMT_GENERIC_INDEX))
+        return;
+
+    for (const auto &entry : index.keyframes_)
+        av_add_index_entry(avc_stream_, entry.pos_, entry.pts_, entry.size_, 0, AVINDEX_KEYFRAME);
+    keyframes_.reset();
 }
 
 int64_t FFMpegStream::frame_to_pts(int frame) const {
@@ -818,7 +944,60 @@ int FFMpegStream::send_packet(AVPacket *avc_packet_) {
     return rt;
 }
 
-void FFMpegStream::flush_buffers() { avcodec_flush_buffers(codec_context_); }
+void FFMpegStream::flush_buffers() {
+
+    // nothing is held in the codec once it's flushed, so this is where it
+    // takes up a changed share of the thread budget
+    if (threads_ && DecodeThreadBudget::instance().changed(threads_))
+        regrant_threads();
+    avcodec_flush_buffers(codec_context_);
+}
+
+void FFMpegStream::regrant_threads() {
+
+    auto grant = DecodeThreadBudget::instance().regrant(threads_);
+    if (!grant)
+        return;
+
+    // a codec's threads are fixed once it's open, so open another
+    AVCodecContext *context = avcodec_alloc_context3(codec_);
+    context->thread_count   = grant->threads_;
+    if (grant->thread_type_)
+        context->thread_type = grant->thread_type_;
+    if (avcodec_parameters_to_context(context, avc_stream_->codecpar) < 0 ||
+        avcodec_open2(context, codec_, nullptr) < 0) {
+        // keep the codec we have, the new grant goes back to the budget
+        avcodec_free_context(&context);
+        return;
+    }
+    if (using_own_frame_allocation)
+        context->get_buffer2 = setup_video_buffer;
+    context->opaque = this;
+
+    avcodec_free_context(&codec_context_);
+    codec_context_ = context;
+    threads_       = grant;
+}
+
+bool FFMpegStream::decode_image_packet(AVPacket *avc_packet_) {
+
+    // the codec was drained by the last image, so reset it rather than
+    // opening a new one
+    flush_buffers();
+    avc_packet_->pts = avc_packet_->dts = 0;
+    if (send_packet(avc_packet_))
+        return false;
+    send_flush_packet();
+
+    av_frame_unref(frame);
+    if (avcodec_receive_frame(codec_context_, frame)) {
+        nothing_decoded_yet_ = true;
+        return false;
+    }
+    nothing_decoded_yet_ = false;
+    current_frame_       = CURRENT_FRAME_UNKNOWN;
+    return true;
+}
 
 int FFMpegStream::duration_frames() const {
 
@@ -1,6 +1,13 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <atomic>
+#include <optional>
+#include <vector>
+
+#include "ffmpeg_convert.hpp"
+#include "ffmpeg_index.hpp"
+#include "ffmpeg_threads.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
 #include "xstudio/thumbnail/thumbnail.hpp"
 #include "xstudio/utility/logging.hpp"
@@ -50,6 +57,12 @@ namespace media_reader {
 
         void AVC_CHECK_THROW(int errorNum, const char *avc_command);
 
+        int64_t stream_pts_to_frame(const AVStream *stream, const int64_t pts);
+
+        // the demuxer's index, across libavformat versions
+        int index_entries_count(AVStream *stream);
+        const AVIndexEntry *index_entry(AVStream *stream, const int i);
+
         typedef enum {
             VIDEO_STREAM     = 1,
             AUDIO_STREAM     = 2,
@@ -57,6 +70,17 @@ namespace media_reader {
             ALL_STREAM_TYPES = 7
         } FFMpegStreamType;
 
+        // how much decoded pixel data we copy, as opposed to handing out the
+        // buffer that it was decoded into
+        struct FrameCopyStats {
+            std::atomic<uint64_t> frames_{0};
+            std::atomic<uint64_t> referenced_frames_{0};
+            std::atomic<uint64_t> copied_frames_{0};
+            std::atomic<uint64_t> bytes_copied_{0};
+
+            [[nodiscard]] utility::JsonStore json() const;
+        };
+
         /* Class to manage data concerning a single audio/video/data stream
         in an AVFormat ffpmeg object */
         class FFMpegStream {
@@ -73,6 +97,21 @@ namespace media_reader {
 
             int64_t current_frame();
             int64_t frame_to_pts(int frame) const;
+            int64_t pts_to_frame(const int64_t pts) const;
+
+            // frame numbers of the keyframes in the demuxer's index, in order.
+            // Empty if the container doesn't index the stream.
+            const std::vector<int64_t> &keyframes();
+
+            // true once keyframes() is known to list every keyframe in the
+            // file, rather than just those the demuxer has come across
+            bool keyframes_complete() const { return keyframes_complete_; }
+
+            // the timestamp of the keyframe at or before frame, if we know it
+            int64_t seek_timestamp(const int frame);
+
+            // give the demuxer a persistent index if it hasn't got a full one
+            void add_index(const FFMpegIndex &index);
             utility::FrameRate frame_rate() const;
 
             ImageBufPtr get_ffmpeg_frame_as_xstudio_image();
@@ -90,6 +129,10 @@ namespace media_reader {
 
             void flush_buffers();
 
+            // decode a packet holding a whole still image file, in place of
+            // the last frame decoded. False if the codec can't decode it.
+            bool decode_image_packet(AVPacket *avc_packet_);
+
             size_t resample_audio(
                 AVFrame *frame, AudioBufPtr &audio_buffer, int offset_into_output_buffer);
 
@@ -127,10 +170,18 @@ namespace media_reader {
 
             void set_current_frame_unknown() { current_frame_ = CURRENT_FRAME_UNKNOWN; }
 
+            static FrameCopyStats copy_stats;
+
+            // decode into our own image buffers where the codec lets us. When
+            // off, images reference (or copy) the decoder's frames instead.
+            // Read as streams open their codecs.
+            static std::atomic<bool> allocate_frames;
+
           private:
             [[nodiscard]] int64_t stream_start_time() const {
                 return avc_stream_->start_time != AV_NOPTS_VALUE ? avc_stream_->start_time : 0;
             }
+            void regrant_threads();
 
             // void setup_frame(ImageStorePtr & video_frame);
             int stream_index_;
@@ -149,9 +200,16 @@ namespace media_reader {
             bool using_own_frame_allocation       = {false};
             bool nothing_decoded_yet_             = {true};
             int current_frame_                    = {CURRENT_FRAME_UNKNOWN};
+            std::optional<std::vector<int64_t>> keyframes_;
+            std::vector<int64_t> keyframe_pts_;
+            bool keyframes_complete_ = {false};
+
+            DecodeThreadBudget::GrantPtr threads_;
 
             // for video rescaling
             SwsContext *sws_context_ = {nullptr};
+            // a context per band of rows, for pixel format conversion
+            std::vector<SwsContext *> conversion_contexts_;
 
             // for audio resampling
             AVSampleFormat target_sample_format_ = {AV_SAMPLE_FMT_NONE};
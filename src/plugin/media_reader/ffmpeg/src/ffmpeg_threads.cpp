@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include "ffmpeg_threads.hpp"
+#include "xstudio/utility/logging.hpp"
+
+using namespace xstudio::media_reader::ffmpeg;
+
+namespace {
+
+int thread_type_from_name(const std::string &name) {
+    if (name == "slice")
+        return FF_THREAD_SLICE;
+    if (name == "frame")
+        return FF_THREAD_FRAME;
+    return FF_THREAD_FRAME | FF_THREAD_SLICE;
+}
+
+int hardware_threads() { return std::max(int(std::thread::hardware_concurrency()), 1); }
+
+} // namespace
+
+DecodeThreadBudget &DecodeThreadBudget::instance() {
+    // deliberately leaked, grants can be released during static destruction
+    static auto *budget = [] {
+        auto b     = new DecodeThreadBudget();
+        b->budget_ = hardware_threads();
+        return b;
+    }();
+    return *budget;
+}
+
+void DecodeThreadBudget::set_preferences(const int budget, const nlohmann::json &policies) {
+
+    std::lock_guard<std::mutex> l(mutex_);
+    budget_ = budget > 0 ? budget : hardware_threads();
+
+    policies_.clear();
+    if (!policies.is_object())
+        return;
+
+    for (const auto &[codec, p] : policies.items()) {
+        try {
+            Policy policy;
+            policy.threads_     = p.value("threads", 0);
+            policy.thread_type_ = thread_type_from_name(p.value("type", "auto"));
+            policies_[codec]    = policy;
+        } catch (const std::exception &e) {
+            spdlog::warn("{} {} {}", __PRETTY_FUNCTION__, codec, e.what());
+        }
+    }
+}
+
+DecodeThreadBudget::GrantPtr DecodeThreadBudget::acquire(
+    const std::string &codec_name, const int capabilities, const int default_threads) {
+
+    std::lock_guard<std::mutex> l(mutex_);
+
+    Policy policy{default_threads, FF_THREAD_FRAME | FF_THREAD_SLICE};
+    auto p = policies_.find(codec_name);
+    if (p == policies_.end())
+        p = policies_.find("default");
+    if (p != policies_.end()) {
+        policy.thread_type_ = p->second.thread_type_;
+        if (p->second.threads_ > 0)
+            policy.threads_ = p->second.threads_;
+    }
+
+    // only what the codec can do
+    int thread_type = 0;
+    if (capabilities & AV_CODEC_CAP_SLICE_THREADS)
+        thread_type |= policy.thread_type_ & FF_THREAD_SLICE;
+    if (capabilities & AV_CODEC_CAP_FRAME_THREADS)
+        thread_type |= policy.thread_type_ & FF_THREAD_FRAME;
+
+    const int wanted = thread_type ? policy.threads_ : 1;
+    return make_grant(
+        share(wanted, budget_ - in_use_, claimants_ + (wanted > 1 ? 1 : 0)),
+        wanted,
+        thread_type);
+}
+
+DecodeThreadBudget::GrantPtr DecodeThreadBudget::regrant(const GrantPtr &grant) {
+
+    std::lock_guard<std::mutex> l(mutex_);
+    grant->generation_ = generation_.load();
+    if (grant->wanted_threads_ <= 1)
+        return {};
+
+    // the grant's own threads are free to hand out again
+    const int held    = grant->threads_ > 1 ? grant->threads_ : 0;
+    const int threads = share(grant->wanted_threads_, budget_ - in_use_ + held, claimants_);
+    if (threads == grant->threads_)
+        return {};
+    return make_grant(threads, grant->wanted_threads_, grant->wanted_type_);
+}
+
+int DecodeThreadBudget::share(const int wanted, const int available, const int claimants) const {
+
+    // an even share between the codecs that want threads
+    const int threads = std::min({wanted, available, budget_ / std::max(claimants, 1)});
+    return threads > 1 ? threads : 1;
+}
+
+DecodeThreadBudget::GrantPtr
+DecodeThreadBudget::make_grant(const int threads, const int wanted, const int wanted_type) {
+
+    // a codec with one thread decodes on the caller's thread, so it costs
+    // nothing from the budget
+    auto grant             = new Grant();
+    grant->wanted_threads_ = wanted;
+    grant->wanted_type_    = wanted_type;
+    if (threads > 1) {
+        grant->threads_     = threads;
+        grant->thread_type_ = wanted_type;
+        in_use_ += threads;
+    }
+    const bool claimant = wanted > 1;
+    if (claimant)
+        claimants_++;
+    grant->generation_ = ++generation_;
+
+    const int held = threads > 1 ? threads : 0;
+    return GrantPtr(grant, [this, held, claimant](const Grant *g) {
+        release(held, claimant);
+        delete g;
+    });
+}
+
+void DecodeThreadBudget::release(const int threads, const bool claimant) {
+    std::lock_guard<std::mutex> l(mutex_);
+    in_use_ -= threads;
+    if (claimant)
+        claimants_--;
+    generation_++;
+}
+
+int DecodeThreadBudget::budget() const {
+    std::lock_guard<std::mutex> l(mutex_);
+    return budget_;
+}
+
+int DecodeThreadBudget::in_use() const {
+    std::lock_guard<std::mutex> l(mutex_);
+    return in_use_;
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace xstudio {
+namespace media_reader {
+    namespace ffmpeg {
+
+        /* Every reader has several decoders per source, each with its own
+        codec threads, so with a few movies on screen the machine is quickly
+        oversubscribed. Codec contexts take their threads from this budget,
+        which is shared by every decoder in the process, and give them back
+        when they're deleted.
+
+        No codec gets more than an even share of the budget between the
+        codecs that want threads. Shares change as decoders come and go, so
+        a codec can ask for its grant to be redone (see regrant()), which
+        it does when it's flushed on a seek.
+
+        How many threads a codec asks for, and whether it uses slice or frame
+        threading, is set per codec in the preferences. */
+        class DecodeThreadBudget {
+          public:
+            struct Grant {
+                int threads_     = {1};
+                int thread_type_ = {0}; // FF_THREAD_FRAME and/or FF_THREAD_SLICE
+
+                // what the codec could use, for regrant()
+                int wanted_threads_ = {1};
+                int wanted_type_    = {0};
+                // the budget's generation when this grant was last looked at
+                mutable std::atomic<uint64_t> generation_ = {0};
+            };
+            typedef std::shared_ptr<const Grant> GrantPtr;
+
+            static DecodeThreadBudget &instance();
+
+            // budget of 0 means one thread per core. policies maps codec names
+            // (and "default") to {"threads": n, "type": "frame"|"slice"|"auto"}
+            void set_preferences(const int budget, const nlohmann::json &policies);
+
+            // threads for a codec context, returned to the budget when the
+            // grant is deleted. capabilities are the AVCodec's.
+            GrantPtr acquire(
+                const std::string &codec_name, const int capabilities, const int default_threads);
+
+            // true if grants have come or gone since the grant was made, so
+            // it may no longer be its share
+            [[nodiscard]] bool changed(const GrantPtr &grant) const {
+                return grant->generation_ != generation_;
+            }
+
+            // a new grant for the codec if its share has changed, to open the
+            // codec again with. Null if the grant it has is still right.
+            GrantPtr regrant(const GrantPtr &grant);
+
+            [[nodiscard]] int budget() const;
+            [[nodiscard]] int in_use() const;
+
+          private:
+            struct Policy {
+                int threads_     = {0};
+                int thread_type_ = {0};
+            };
+
+            int share(const int wanted, const int available, const int claimants) const;
+            GrantPtr make_grant(const int threads, const int wanted, const int wanted_type);
+            void release(const int threads, const bool wanted);
+
+            mutable std::mutex mutex_;
+            int budget_ = {0};
+            int in_use_ = {0};
+            // grants for codecs that can use more than one thread
+            int claimants_ = {0};
+            std::atomic<uint64_t> generation_ = {0};
+            std::map<std::string, Policy> policies_;
+        };
+
+    } // namespace ffmpeg
+} // namespace media_reader
+} // namespace xstudio
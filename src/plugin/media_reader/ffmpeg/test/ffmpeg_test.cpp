@@ -1,7 +1,9 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <fstream>
 #include <gtest/gtest.h>
 
 #include "ffmpeg_decoder.hpp"
+#include "ffmpeg_index.hpp"
 #include "ffmpeg.hpp"
 #include "xstudio/media/media.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
@@ -48,4 +50,375 @@ TEST(FFMPEGLeaker, TEST) {
     }
 
     delete decoder;
-}
\ No newline at end of file
+}
+TEST(FFMpegDecoderTest, ReverseDecode) {
+    // a window smaller than the GOP means some frames are decoded more than
+    // once, but every frame still comes back in descending order
+    FFMpegDecoder forwards(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+    FFMpegDecoder backwards(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+    backwards.set_reverse_buffer_frames(5);
+
+    const int frames = std::min(int(forwards.duration_frames()), 48);
+    ASSERT_GT(frames, 2);
+
+    std::vector<double> timestamps;
+    ImageBufPtr buf;
+    for (int i = 0; i < frames; i++) {
+        forwards.decode_video_frame(i, buf);
+        ASSERT_TRUE(buf);
+        EXPECT_EQ(buf->decoder_frame_number(), i);
+        timestamps.push_back(buf->display_timestamp_seconds());
+    }
+
+    for (int i = frames - 1; i >= 0; i--) {
+        buf.reset();
+        backwards.decode_video_frame(i, buf);
+        ASSERT_TRUE(buf);
+        EXPECT_EQ(buf->decoder_frame_number(), i);
+        EXPECT_EQ(buf->display_timestamp_seconds(), timestamps[i]);
+    }
+}
+
+TEST(FFMpegIndexTest, SaveLoadAndSeek) {
+    const std::string path = TEST_RESOURCE "/media/test.mov";
+    const auto dir         = fs::temp_directory_path() / "xstudio_ffmpeg_index_test";
+    fs::remove_all(dir);
+    FFMpegIndexStore::instance().set_path(dir.string());
+
+    FFMpegDecoder decoder(path, 44100, VIDEO_STREAM);
+    decoder.build_index();
+
+    auto index = FFMpegIndexStore::instance().find(FFMpegIndexStore::key(path));
+    ASSERT_TRUE(index);
+    ASSERT_FALSE(index->keyframes_.empty());
+    EXPECT_EQ(index->keyframes_.front().frame_, 0);
+    // the mov demuxer's index comes from the sample tables, so lists every keyframe
+    EXPECT_TRUE(index->complete_);
+
+    auto saved = dir / "saved.idx";
+    ASSERT_TRUE(index->save(saved));
+    auto loaded = FFMpegIndex::load(saved);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->stream_index_, index->stream_index_);
+    EXPECT_EQ(loaded->complete_, index->complete_);
+    ASSERT_EQ(loaded->keyframes_.size(), index->keyframes_.size());
+    for (size_t i = 0; i < index->keyframes_.size(); i++) {
+        EXPECT_EQ(loaded->keyframes_[i].frame_, index->keyframes_[i].frame_);
+        EXPECT_EQ(loaded->keyframes_[i].pts_, index->keyframes_[i].pts_);
+        EXPECT_EQ(loaded->keyframes_[i].pos_, index->keyframes_[i].pos_);
+    }
+
+    // jumping around the file lands on the requested frames
+    const int frames = std::min(int(decoder.duration_frames()), 48);
+    ASSERT_GT(frames, 2);
+    ImageBufPtr buf;
+    for (const int i : {frames - 1, 0, frames / 2, frames / 2 + 1, 1, frames - 2}) {
+        buf.reset();
+        decoder.decode_video_frame(i, buf);
+        ASSERT_TRUE(buf);
+        EXPECT_EQ(buf->decoder_frame_number(), i);
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST(FFMpegIndexTest, StoreKeepsRecentlyUsed) {
+    // memory only, the least recently used index goes once the store is full
+    auto &store = FFMpegIndexStore::instance();
+    store.set_path("");
+
+    auto index      = std::make_shared<FFMpegIndex>();
+    const auto make = [](const int i) { return fmt::format("lru_test_{}", i); };
+
+    const auto generation = store.generation();
+    store.add(make(0), index);
+    store.add(make(1), index);
+    EXPECT_EQ(store.generation(), generation + 2);
+
+    EXPECT_TRUE(store.find(make(0), false));
+    for (auto i = 2; i < 256; i++)
+        store.add(make(i), index);
+    store.add(make(256), index);
+
+    EXPECT_TRUE(store.find(make(0), false));
+    EXPECT_FALSE(store.find(make(1), false));
+    EXPECT_TRUE(store.find(make(256), false));
+}
+
+TEST(FFMpegDecoderTest, ImageSequence) {
+    // one decoder reused across an image sequence gives the same images as a
+    // decoder opened for each file
+    FFMpegDecoder reused(TEST_RESOURCE "/media/test.0001.ppm", 44100, VIDEO_STREAM);
+    ASSERT_TRUE(reused.is_still_image());
+
+    for (int i = 1; i <= 10; i++) {
+        const auto path = fmt::format(TEST_RESOURCE "/media/test.{:04d}.ppm", i);
+        if (i > 1)
+            ASSERT_TRUE(reused.decode_image_file(path));
+        EXPECT_EQ(reused.path(), path);
+
+        ImageBufPtr expected, actual;
+        FFMpegDecoder(path, 44100, VIDEO_STREAM).decode_video_frame(0, expected);
+        reused.decode_video_frame(i, actual);
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(actual);
+
+        const auto size = expected->image_size_in_pixels();
+        ASSERT_EQ(actual->image_size_in_pixels(), size);
+        EXPECT_EQ(actual->decoder_frame_number(), 0);
+
+        const int expected_stride = expected->shader_params()["y_linesize"].get<int>();
+        const int actual_stride   = actual->shader_params()["y_linesize"].get<int>();
+        for (int y = 0; y < size.y; y++) {
+            EXPECT_EQ(
+                std::memcmp(
+                    expected->buffer() + y * expected_stride,
+                    actual->buffer() + y * actual_stride,
+                    size.x * 3),
+                0);
+        }
+    }
+
+    // a movie can't be decoded this way
+    EXPECT_FALSE(reused.decode_image_file(TEST_RESOURCE "/media/test.mov"));
+}
+
+TEST(FFMpegDecoderTest, CopyStats) {
+    // frames are only counted as copied when the pixels were copied out of
+    // the decoder's buffer
+    const uint64_t frames     = FFMpegStream::copy_stats.frames_;
+    const uint64_t referenced = FFMpegStream::copy_stats.referenced_frames_;
+    const uint64_t copied     = FFMpegStream::copy_stats.copied_frames_;
+    const uint64_t bytes      = FFMpegStream::copy_stats.bytes_copied_;
+
+    FFMpegDecoder decoder(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+    ImageBufPtr buf;
+    for (int i = 0; i < 10; i++) {
+        decoder.decode_video_frame(i, buf);
+        ASSERT_TRUE(buf);
+        EXPECT_GE(buf->size(), ImageBuffer::padded_size(buf->size()));
+        // a buffer with an owner is the decoder's frame
+        if (buf->owner()) {
+            EXPECT_EQ(
+                static_cast<const AVFrame *>(buf->owner().get())->data[0],
+                (const uint8_t *)buf->buffer());
+        }
+    }
+
+    EXPECT_EQ(FFMpegStream::copy_stats.frames_ - frames, 10u);
+    const uint64_t copied_frames = FFMpegStream::copy_stats.copied_frames_ - copied;
+    EXPECT_LE(FFMpegStream::copy_stats.referenced_frames_ - referenced + copied_frames, 10u);
+    EXPECT_EQ(copied_frames == 0, FFMpegStream::copy_stats.bytes_copied_ == bytes);
+
+    // with the codec allocating its frames, an RGB image that fills whole
+    // texture lines is handed out in the decoder's buffer, not copied
+    const auto dir  = fs::temp_directory_path() / "xstudio_ffmpeg_copy_stats_test";
+    const auto path = (dir / "lines.ppm").string();
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream ppm(path, std::ios::binary);
+        ppm << "P6\n256 128\n255\n";
+        for (int i = 0; i < 256 * 128; i++)
+            ppm.put(char(i)).put(char(i >> 8)).put(char(i >> 16));
+    }
+
+    FFMpegStream::allocate_frames = false;
+    const uint64_t referenced_before = FFMpegStream::copy_stats.referenced_frames_;
+    const uint64_t copied_before     = FFMpegStream::copy_stats.copied_frames_;
+    buf.reset();
+    FFMpegDecoder(path, 44100, VIDEO_STREAM).decode_video_frame(0, buf);
+    FFMpegStream::allocate_frames = true;
+
+    ASSERT_TRUE(buf);
+    EXPECT_EQ(FFMpegStream::copy_stats.referenced_frames_ - referenced_before, 1u);
+    EXPECT_EQ(FFMpegStream::copy_stats.copied_frames_, copied_before);
+    ASSERT_TRUE(buf->owner());
+    const auto frame = static_cast<const AVFrame *>(buf->owner().get());
+    const auto data  = (const uint8_t *)buf->buffer();
+    EXPECT_EQ(frame->data[0], data);
+    ASSERT_TRUE(frame->buf[0]);
+    EXPECT_LE(data + buf->size(), frame->buf[0]->data + frame->buf[0]->size);
+
+    // the image keeps the decoder's frame alive after the decoder has gone
+    EXPECT_EQ(data[3 * 300], uint8_t(300 & 0xff));
+
+    buf.reset();
+    fs::remove_all(dir);
+}
+
+TEST(FFMpegConvertTest, Bands) {
+    EXPECT_EQ(conversion_pix_fmt(AV_PIX_FMT_YUV444P), AV_PIX_FMT_RGBA);
+    EXPECT_EQ(conversion_pix_fmt(AV_PIX_FMT_YUV444P16LE), AV_PIX_FMT_RGB48LE);
+    EXPECT_EQ(conversion_pix_fmt(AV_PIX_FMT_YUVA444P16LE), AV_PIX_FMT_RGBA64LE);
+
+    // converting in bands gives the same result as one sws_scale of the whole
+    // frame, and at 4K it should be well inside a frame at 24fps. With 4:2:0
+    // the chroma is shared by rows either side of a band edge, so a seam
+    // would show up there.
+    for (const auto format :
+         {AV_PIX_FMT_YUV444P,
+          AV_PIX_FMT_YUV444P16LE,
+          AV_PIX_FMT_YUV420P10LE,
+          AV_PIX_FMT_YUV420P12LE,
+          AV_PIX_FMT_P010LE,
+          AV_PIX_FMT_NV12}) {
+
+        AVFrame *frame = av_frame_alloc();
+        frame->width   = 3840;
+        frame->height  = 2160;
+        frame->format  = format;
+        ASSERT_EQ(av_frame_get_buffer(frame, 0), 0);
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+        for (int p = 0; p < av_pix_fmt_count_planes(format); p++) {
+            const int rows =
+                (p == 1 || p == 2) ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                   : frame->height;
+            for (int y = 0; y < rows; y++) {
+                for (int x = 0; x < frame->linesize[p]; x++)
+                    frame->data[p][y * frame->linesize[p] + x] = uint8_t(x * 7 + y * 3 + p);
+            }
+        }
+
+        const auto target  = conversion_pix_fmt(format);
+        const int linesize = av_image_get_linesize(target, frame->width, 0);
+        std::vector<uint8_t> expected(size_t(linesize) * frame->height);
+        std::vector<uint8_t> actual(expected.size());
+
+        auto t0           = utility::clock::now();
+        SwsContext *whole = sws_getContext(
+            frame->width,
+            frame->height,
+            format,
+            frame->width,
+            frame->height,
+            target,
+            0,
+            nullptr,
+            nullptr,
+            nullptr);
+        uint8_t *dst = expected.data();
+        sws_scale(whole, frame->data, frame->linesize, 0, frame->height, &dst, &linesize);
+        sws_freeContext(whole);
+        auto t1 = utility::clock::now();
+
+        std::vector<SwsContext *> contexts;
+        convert_frame(frame, format, target, actual.data(), linesize, contexts);
+        auto t2 = utility::clock::now();
+        for (auto context : contexts)
+            sws_freeContext(context);
+
+        EXPECT_EQ(expected, actual) << av_get_pix_fmt_name(format);
+        spdlog::info(
+            "{} 4K conversion: one context {}ms, {} bands {}ms",
+            av_get_pix_fmt_name(format),
+            std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count(),
+            contexts.size(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+
+        av_frame_free(&frame);
+    }
+}
+
+TEST(DecodeThreadBudgetTest, Budget) {
+    auto &budget = DecodeThreadBudget::instance();
+    budget.set_preferences(10, R"({
+        "default": {"threads": 4},
+        "prores": {"threads": 6, "type": "slice"},
+        "h264": {"type": "frame"}
+    })"_json);
+    ASSERT_EQ(budget.in_use(), 0);
+
+    const int both = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS;
+    auto prores    = budget.acquire("prores", both, 8);
+    EXPECT_EQ(prores->threads_, 6);
+    EXPECT_EQ(prores->thread_type_, FF_THREAD_SLICE);
+
+    auto h264 = budget.acquire("h264", both, 8);
+    EXPECT_EQ(h264->threads_, 4);
+    EXPECT_EQ(h264->thread_type_, FF_THREAD_FRAME);
+    EXPECT_EQ(budget.in_use(), 10);
+
+    // spent, so the next codec runs on the caller's thread
+    auto dnxhd = budget.acquire("dnxhd", both, 8);
+    EXPECT_EQ(dnxhd->threads_, 1);
+
+    // and a codec without the threading asked for gets one thread
+    prores.reset();
+    EXPECT_EQ(budget.in_use(), 4);
+    EXPECT_EQ(budget.acquire("h264", AV_CODEC_CAP_SLICE_THREADS, 8)->threads_, 1);
+
+    // decoders give their threads back
+    {
+        FFMpegDecoder a(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+        FFMpegDecoder b(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+        EXPECT_LE(budget.in_use(), 10);
+    }
+    EXPECT_EQ(budget.in_use(), 4);
+
+    h264.reset();
+    dnxhd.reset();
+    EXPECT_EQ(budget.in_use(), 0);
+    budget.set_preferences(0, nlohmann::json());
+}
+
+TEST(DecodeThreadBudgetTest, FairShare) {
+    auto &budget = DecodeThreadBudget::instance();
+    budget.set_preferences(12, R"({"default": {"threads": 12}})"_json);
+    ASSERT_EQ(budget.in_use(), 0);
+
+    const int both = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS;
+    auto a         = budget.acquire("h264", both, 12);
+    EXPECT_EQ(a->threads_, 12);
+    EXPECT_FALSE(budget.changed(a));
+
+    // a second codec can't have more than half, and gets what's left
+    auto b = budget.acquire("h264", both, 12);
+    EXPECT_EQ(b->threads_, 1);
+    EXPECT_TRUE(budget.changed(a));
+
+    // redoing the grants splits the budget between them
+    auto regrant = [&](DecodeThreadBudget::GrantPtr &grant) {
+        if (auto g = budget.regrant(grant))
+            grant = g;
+    };
+    regrant(a);
+    EXPECT_EQ(a->threads_, 6);
+    regrant(b);
+    EXPECT_EQ(b->threads_, 6);
+    EXPECT_EQ(budget.in_use(), 12);
+    EXPECT_FALSE(budget.regrant(a));
+
+    // a third gets an even share as soon as the others give up theirs
+    auto c = budget.acquire("h264", both, 12);
+    EXPECT_EQ(c->threads_, 1);
+    regrant(a);
+    regrant(b);
+    regrant(c);
+    EXPECT_EQ(a->threads_, 4);
+    EXPECT_EQ(b->threads_, 4);
+    EXPECT_EQ(c->threads_, 4);
+    EXPECT_EQ(budget.in_use(), 12);
+
+    // and threads that are released are granted again
+    a.reset();
+    b.reset();
+    EXPECT_TRUE(budget.changed(c));
+    regrant(c);
+    EXPECT_EQ(c->threads_, 12);
+
+    // a decoder takes up its new share when it's flushed on a seek
+    {
+        FFMpegDecoder decoder(TEST_RESOURCE "/media/test.mov", 44100, VIDEO_STREAM);
+        ImageBufPtr buf;
+        decoder.decode_video_frame(0, buf);
+        c.reset();
+        decoder.decode_video_frame(8, buf);
+        buf.reset();
+        decoder.decode_video_frame(0, buf);
+        ASSERT_TRUE(buf);
+        EXPECT_EQ(buf->decoder_frame_number(), 0);
+    }
+    EXPECT_EQ(budget.in_use(), 0);
+    budget.set_preferences(0, nlohmann::json());
+}
@@ -1,5 +1,9 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <array>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <set>
 
 
 #include <Iex.h>
@@ -7,6 +11,7 @@
 #include <IlmThreadMutex.h>
 #include <Imath/ImathBox.h>
 #include <ImfChannelList.h>
+#include <ImfCompression.h>
 #include <ImfHeader.h> // staticInitialize
 #include <ImfInputFile.h>
 #include <ImfMultiPartInputFile.h>
@@ -14,6 +19,7 @@
 #include <ImfPreviewImage.h>
 #include <ImfRationalAttribute.h>
 #include <ImfRgbaFile.h>
+#include <ImfTileDescription.h>
 #include <ImfTimeCodeAttribute.h>
 #include <ImfIntAttribute.h>
 #include <ImfVecAttribute.h>
@@ -44,45 +50,63 @@ static Uuid s_plugin_uuid("9fd34c7e-8b35-44c7-8976-387bae1e35e0");
 
 /* Given an image display and data window and a maximum
 overscan amount, compute the cropped data window that limits
-the overscan in the data window.
-
-Returns true if a crop is required to meet max overscan requirement
-bool crop_data_window(
-        Imath::Box2i &data_window,
-        const Imath::Box2i &display_window,
-        const float overscan_percent
-)
-{
-
-        const int width = display_window.size().x+1;
-        const int height = display_window.size().y+1;
-
-        const Imath::Box2i in_data_window = data_window;
+the overscan in the data window. The overscan is a percentage
+of the display window's width and height on each side. */
+Imath::Box2i crop_data_window(
+    const Imath::Box2i &data_window,
+    const Imath::Box2i &display_window,
+    const float overscan_percent) {
+
+    const int overscan_x =
+        (int)round(float(display_window.size().x + 1) * overscan_percent / 100.0f);
+    const int overscan_y =
+        (int)round(float(display_window.size().y + 1) * overscan_percent / 100.0f);
+
+    Imath::Box2i cropped = data_window;
+    cropped.min.x        = std::max(data_window.min.x, display_window.min.x - overscan_x);
+    cropped.max.x        = std::min(data_window.max.x, display_window.max.x + overscan_x);
+    cropped.min.y        = std::max(data_window.min.y, display_window.min.y - overscan_y);
+    cropped.max.y        = std::min(data_window.max.y, display_window.max.y + overscan_y);
+
+    // all of the data is outside the crop, but we still need an image
+    if (cropped.isEmpty())
+        cropped = Imath::Box2i(data_window.min, data_window.min);
+
+    return cropped;
+}
 
-        data_window.min.x = std::max(
-                data_window.min.x,
-                (int)round(-float(width)*overscan_percent/100.0f)
-                );
+// the stream whose channels are picked from the whole file
+const std::string main_stream_name = "Main";
 
-        data_window.max.x = std::min(
-                data_window.max.x,
-                (int)round(float(width)*(overscan_percent/100.0f + 1.0f))
-                );
+// if any channels aren't in a layer, like plain R, G, B
+bool has_base_channels(const Imf::ChannelList &channels) {
+    for (Imf::ChannelList::ConstIterator i = channels.begin(); i != channels.end(); ++i) {
+        if (std::string(i.name()).find('.') == std::string::npos)
+            return true;
+    }
+    return false;
+}
 
-        data_window.min.y = std::max(
-                data_window.min.y,
-                (int)round(-float(height)*overscan_percent/100.0f)
-                );
+/* Each layer of a multi-layer EXR is offered as an image stream, so the
+viewer can switch between them and each has its own cache keys. The first
+stream, "Main", is the channels that aren't in a layer, or if there are none
+it picks from all the file's channels. */
+std::vector<std::string> exr_layer_streams(const Imf::ChannelList &channels) {
 
-        data_window.max.y = std::min(
-                data_window.max.y,
-                (int)round(float(height)*(overscan_percent/100.0f + 1.0f))
-                );
+    std::vector<std::string> streams({main_stream_name});
 
-        return in_data_window != data_window;
+    std::set<std::string> layers;
+    channels.layers(layers);
 
+    // with only one layer there's nothing to switch between
+    if (layers.size() + (has_base_channels(channels) ? 1 : 0) > 1) {
+        for (const auto &layer : layers) {
+            if (layer != main_stream_name)
+                streams.push_back(layer);
+        }
+    }
+    return streams;
 }
-*/
 
 /* Examine the channel data in an EXR input file and map channels in the
 file to RGB(A) channels for display.
@@ -90,27 +114,49 @@ file to RGB(A) channels for display.
 We have to do this somewhat heuristically as EXR channel names can be literally
 anything. We want to look for regular channel names like 'r','g','b' or '*.x' '*.y' '*.z'
 
+Only channels directly in layer are considered, see exr_layer_streams for
+the main stream. If load_as_half, float32 channels are loaded as half along with any half
+channels. OpenEXR converts them as it reads.
 */
-Imf::PixelType
-exr_channels_decision(Imf::InputFile &in, std::vector<std::string> &exr_channels_to_load) {
+Imf::PixelType exr_channels_decision(
+    Imf::InputFile &in,
+    const std::string &layer,
+    const bool load_as_half,
+    std::vector<std::string> &exr_channels_to_load) {
 
     const Imf::ChannelList channels = in.header().channels();
     Imf::PixelType pixelType;
     exr_channels_to_load.clear();
 
-    // At the moment we can handle either all channels are float 16 or all channels
-    // are float 32 - we can't have a mix of channel types
+    // a layer the file doesn't have, we show the main stream instead
+    Imf::ChannelList::ConstIterator first, last;
+    channels.channelsInLayer(layer, first, last);
+    const bool main_stream = layer.empty() || layer == main_stream_name || first == last;
+    const bool whole_file  = main_stream && !has_base_channels(channels);
+
+    // with an empty prefix, only channels without a layer match
+    const std::string prefix = main_stream ? std::string() : layer + ".";
+    auto in_layer            = [&](const std::string &name) {
+        return whole_file || (name.compare(0, prefix.size(), prefix) == 0 &&
+                              name.find('.', prefix.size()) == std::string::npos);
+    };
+
+    // Unless we convert float32 to half, we can handle either all channels
+    // are float 16 or all channels are float 32 - we can't have a mix of
+    // channel types
 
     // fetch the channel names for 16bit float channels
     for (Imf::ChannelList::ConstIterator i = channels.begin(); i != channels.end(); ++i) {
-        if (i.channel().type == Imf::PixelType::HALF) {
+        if (in_layer(i.name()) &&
+            (i.channel().type == Imf::PixelType::HALF ||
+             (load_as_half && i.channel().type == Imf::PixelType::FLOAT))) {
             exr_channels_to_load.emplace_back(i.name());
         }
     }
     if (exr_channels_to_load.empty()) {
         // there were no 16bit float channels - look for float32 instead
         for (Imf::ChannelList::ConstIterator i = channels.begin(); i != channels.end(); ++i) {
-            if (i.channel().type == Imf::PixelType::FLOAT) {
+            if (in_layer(i.name()) && i.channel().type == Imf::PixelType::FLOAT) {
                 exr_channels_to_load.emplace_back(i.name());
             }
         }
@@ -168,6 +214,213 @@ exr_channels_decision(Imf::InputFile &in, std::vector<std::string> &exr_channels
     return pixelType;
 }
 
+/* The part of the data window to load. Like EXR's own windows, window is
+inclusive. Only every decimate'th row and column of it is kept. */
+struct ExrReadRegion {
+    Imath::Box2i window;
+    int decimate = {1};
+};
+
+// the area of the image visible in the viewport, in image pixels, worked
+// out the same way as the viewport's vertex shader does
+Imath::Box2f visible_image_pixels(
+    const Imf::Header &header,
+    const Imath::Box2f &viewport_visible_area,
+    const Imath::M44f &image_transform) {
+
+    const Imath::V2i dims = header.displayWindow().size();
+    const float aspect    = header.pixelAspectRatio();
+
+    Imath::Box2f visible;
+    for (const auto &corner :
+         {viewport_visible_area.min,
+          viewport_visible_area.max,
+          Imath::V2f(viewport_visible_area.min.x, viewport_visible_area.max.y),
+          Imath::V2f(viewport_visible_area.max.x, viewport_visible_area.min.y)}) {
+        Imath::V3f p;
+        image_transform.multVecMatrix(Imath::V3f(corner.x, corner.y, 0.0f), p);
+        visible.extendBy(Imath::V2f(
+            (p.x + 1.0f) * float(dims.x) * 0.5f,
+            (p.y * aspect * float(dims.x) + float(dims.y)) * 0.5f));
+    }
+    return visible;
+}
+
+// data_window is the part of the file's data window we're allowed to load
+ExrReadRegion partial_region(
+    const Imf::Header &header,
+    const Imath::Box2i &data_window,
+    const Imath::Box2f &viewport_visible_area,
+    const Imath::V2i &viewport_size_screen_pixels,
+    const Imath::M44f &image_transform) {
+
+    const Imath::Box2f visible =
+        visible_image_pixels(header, viewport_visible_area, image_transform);
+
+    // with a margin, so panning a little doesn't need a reload
+    const Imath::V2f margin = visible.size() * 0.1f + Imath::V2f(16.0f, 16.0f);
+
+    ExrReadRegion region;
+    region.window.min.x = std::max(data_window.min.x, int(floor(visible.min.x - margin.x)));
+    region.window.min.y = std::max(data_window.min.y, int(floor(visible.min.y - margin.y)));
+    region.window.max.x = std::min(data_window.max.x, int(ceil(visible.max.x + margin.x)));
+    region.window.max.y = std::min(data_window.max.y, int(ceil(visible.max.y + margin.y)));
+    if (region.window.isEmpty()) {
+        // nothing in view, but we still need an image
+        region.window = Imath::Box2i(data_window.min, data_window.min);
+    }
+
+    // zoomed out, there are several image pixels to each screen pixel and
+    // we can skip all but one of them
+    const float screen_pixels =
+        float(viewport_size_screen_pixels.x) * viewport_visible_area.size().x * 0.5f;
+    const float image_pixels_per_screen_pixel =
+        screen_pixels > 0.0f ? visible.size().x / screen_pixels : 1.0f;
+    while (region.decimate < 8 && region.decimate * 2 <= image_pixels_per_screen_pixel)
+        region.decimate *= 2;
+
+    return region;
+}
+
+// if what we loaded last time has everything the region needs
+bool covers(
+    const ImageBufPtr &loaded, const media::AVFrameID &mptr, const ExrReadRegion &region) {
+    if (!loaded || loaded->media_key() != media_reader::partial_frame_key(mptr.key_, loaded) ||
+        loaded->shader_params().value("decimate", 1) > region.decimate)
+        return false;
+    const Imath::Box2i bounds = loaded->image_pixels_bounding_box();
+    return bounds.min.x <= region.window.min.x && bounds.min.y <= region.window.min.y &&
+           bounds.max.x > region.window.max.x && bounds.max.y > region.window.max.y;
+}
+
+// rows that OpenEXR decompresses together
+int rows_per_block(const Imf::Header &header) {
+    if (header.hasTileDescription())
+        return header.tileDescription().ySize;
+
+    switch (header.compression()) {
+    case Imf::ZIP_COMPRESSION:
+    case Imf::PXR24_COMPRESSION:
+        return 16;
+    case Imf::PIZ_COMPRESSION:
+    case Imf::B44_COMPRESSION:
+    case Imf::B44A_COMPRESSION:
+    case Imf::DWAA_COMPRESSION:
+        return 32;
+    case Imf::DWAB_COMPRESSION:
+        return 256;
+    default:
+        return 1;
+    }
+}
+
+void read_exr_pixels(
+    Imf::InputFile &in,
+    const std::vector<std::string> &exr_channels_to_load,
+    const Imf::PixelType pix_type,
+    const ExrReadRegion &region,
+    byte *buffer) {
+
+    const Imath::Box2i data_window = in.header().dataWindow();
+    const Imath::Box2i &window     = region.window;
+    const int decimate             = region.decimate;
+
+    const size_t bytes_per_channel = (pix_type == Imf::PixelType::HALF ? 2 : 4);
+    const size_t bytes_per_pixel   = bytes_per_channel * exr_channels_to_load.size();
+    const size_t out_width         = (window.size().x + decimate) / decimate;
+    const size_t out_line_stride   = out_width * bytes_per_pixel;
+
+    auto frame_buffer = [&](char *ptr, const size_t line_stride) {
+        Imf::FrameBuffer fb;
+        for (const auto &chan_name : exr_channels_to_load) {
+            fb.insert(
+                chan_name.c_str(),
+                Imf::Slice(pix_type, ptr, bytes_per_pixel, line_stride, 1, 1, 0));
+            ptr += bytes_per_channel;
+        }
+        return fb;
+    };
+
+    if (decimate == 1 && window.min.x == data_window.min.x &&
+        window.max.x == data_window.max.x) {
+        // whole lines, so OpenEXR can decode straight into our buffer
+        in.setFrameBuffer(frame_buffer(
+            (char *)buffer - window.min.x * bytes_per_pixel - window.min.y * out_line_stride,
+            out_line_stride));
+        in.readPixels(window.min.y, window.max.y);
+        return;
+    }
+
+    // Otherwise OpenEXR needs a buffer as wide as the data window to read into,
+    // then we copy out the pixels we want.
+    const size_t line_stride = (data_window.size().x + 1) * bytes_per_pixel;
+
+    auto copy_chunk = [&](const uint8_t *chunk, const int chunk_y_min, const int chunk_y_max) {
+        for (int y = chunk_y_min; y <= chunk_y_max; ++y) {
+            if ((y - window.min.y) % decimate)
+                continue;
+            const uint8_t *src = chunk + (y - chunk_y_min) * line_stride +
+                                 (window.min.x - data_window.min.x) * bytes_per_pixel;
+            byte *dst = buffer + ((y - window.min.y) / decimate) * out_line_stride;
+            if (decimate == 1) {
+                memcpy(dst, src, out_line_stride);
+            } else {
+                for (size_t x = 0; x < out_width; ++x)
+                    memcpy(
+                        dst + x * bytes_per_pixel,
+                        src + x * decimate * bytes_per_pixel,
+                        bytes_per_pixel);
+            }
+        }
+    };
+
+    if (decimate > rows_per_block(in.header())) {
+        // Some blocks have none of the rows we keep, so read only those rows
+        // and those blocks are never decompressed. A y stride of 0 puts every
+        // row OpenEXR reads in the one line buffer.
+        std::vector<uint8_t> line(line_stride);
+        in.setFrameBuffer(
+            frame_buffer((char *)line.data() - data_window.min.x * bytes_per_pixel, 0));
+        for (int y = window.min.y; y <= window.max.y; y += decimate) {
+            in.readPixels(y, y);
+            copy_chunk(line.data(), y, y);
+        }
+        return;
+    }
+
+    // We read in chunks in the Y dimension to take advantage of OpenEXR
+    // decompress threads that are (possibly) more efficient when decoding
+    // blocks of pixels at once. While OpenEXR decodes one chunk we copy out of
+    // the previous one, so there are two chunk buffers.
+    std::array<std::vector<uint8_t>, 2> tmp_bufs;
+
+    // declared after the buffers, so if a read throws we wait for the copy
+    // before they go
+    std::future<void> copying;
+
+    for (int chunk_y_min = window.min.y, chunk = 0; chunk_y_min <= window.max.y;
+         chunk_y_min += EXR_READ_BLOCK_HEIGHT, chunk++) {
+
+        const int chunk_y_max = std::min(chunk_y_min + EXR_READ_BLOCK_HEIGHT - 1, window.max.y);
+        auto &tmp_buf = tmp_bufs[chunk % 2];
+        tmp_buf.resize(line_stride * (chunk_y_max - chunk_y_min + 1));
+
+        in.setFrameBuffer(frame_buffer(
+            (char *)tmp_buf.data() - data_window.min.x * bytes_per_pixel -
+                chunk_y_min * line_stride,
+            line_stride));
+        in.readPixels(chunk_y_min, chunk_y_max);
+
+        if (copying.valid())
+            copying.get();
+        copying = std::async(
+            std::launch::async, copy_chunk, tmp_buf.data(), chunk_y_min, chunk_y_max);
+    }
+
+    if (copying.valid())
+        copying.get();
+}
+
 static Uuid openexr_shader_uuid{"1c9259fc-46a5-11ea-87fe-989096adb429"};
 static std::string shader{R"(
 #version 430 core
@@ -177,18 +430,28 @@ uniform int num_channels;
 uniform int pix_type;
 uniform ivec2 image_bounds_min;
 uniform ivec2 image_bounds_max;
+uniform int decimate;
 
 // we need to forward declare this function, which is defined by the base
 // gl shader class
 vec2 get_image_data_2floats(int byte_address);
 float get_image_data_float32(int byte_address);
 
+// index of the pixel in the buffer. When zoomed out we may only have loaded
+// every decimate'th row and column of the image bounds
+int pixel_index(ivec2 image_coord)
+{
+    int d = max(decimate, 1);
+    ivec2 p = (image_coord-image_bounds_min)/d;
+    return p.x + p.y*((image_bounds_max.x-image_bounds_min.x+d-1)/d);
+}
+
 vec4 fetch_pixel_32bitfloat(ivec2 image_coord)
 {
 	if (image_coord.x < image_bounds_min.x || image_coord.x >= image_bounds_max.x) return vec4(0.0,0.0,0.0,0.0);
 	if (image_coord.y < image_bounds_min.y || image_coord.y >= image_bounds_max.y) return vec4(0.0,0.0,0.0,0.0);
 
-    int pixel_address_bytes = ((image_coord.x-image_bounds_min.x) + (image_coord.y-image_bounds_min.y)*(image_bounds_max.x-image_bounds_min.x))*num_channels*4;
+    int pixel_address_bytes = pixel_index(image_coord)*num_channels*4;
 
     float R = get_image_data_float32(pixel_address_bytes);
 
@@ -227,7 +490,7 @@ vec4 fetch_pixel_16bitfloat(ivec2 image_coord)
 	if (image_coord.x < image_bounds_min.x || image_coord.x >= image_bounds_max.x) return vec4(0.0,0.0,0.0,0.0);
 	if (image_coord.y < image_bounds_min.y || image_coord.y >= image_bounds_max.y) return vec4(0.0,0.0,0.0,0.0);
 
-    int pixel_address_bytes = ((image_coord.x-image_bounds_min.x) + (image_coord.y-image_bounds_min.y)*(image_bounds_max.x-image_bounds_min.x))*num_channels*2;
+    int pixel_address_bytes = pixel_index(image_coord)*num_channels*2;
 
     vec2 pixRG = get_image_data_2floats(pixel_address_bytes);
 
@@ -290,6 +553,7 @@ OpenEXRMediaReader::OpenEXRMediaReader(const utility::JsonStore &prefs)
     Imf::setGlobalThreadCount(16);
     max_exr_overscan_percent_ = 5.0f;
     readers_per_source_       = 1;
+    load_float_as_half_       = true;
 
     update_preferences(prefs);
 }
@@ -309,9 +573,22 @@ void OpenEXRMediaReader::update_preferences(const utility::JsonStore &prefs) {
     } catch (const std::exception &e) {
         spdlog::warn("{} {}", __PRETTY_FUNCTION__, e.what());
     }
+    try {
+        load_float_as_half_ =
+            preference_value<bool>(prefs, "/plugin/media_reader/OpenEXR/load_float_as_half");
+    } catch (const std::exception &e) {
+        spdlog::warn("{} {}", __PRETTY_FUNCTION__, e.what());
+    }
 }
 
-ImageBufPtr OpenEXRMediaReader::image(const media::AVFrameID &mptr) {
+namespace {
+
+ImageBufPtr read_exr(
+    const media::AVFrameID &mptr,
+    const bool load_as_half,
+    const size_t max_channels,
+    const std::function<ExrReadRegion(const Imf::Header &)> &choose_region,
+    const ImageBufPtr &current_loaded = ImageBufPtr()) {
     try {
         std::string path = uri_to_posix_path(mptr.uri_);
 
@@ -321,32 +598,31 @@ ImageBufPtr OpenEXRMediaReader::image(const media::AVFrameID &mptr) {
 
         // decide which channels we are going to load
         std::vector<std::string> exr_channels_to_load;
-        Imf::PixelType pix_type = exr_channels_decision(in, exr_channels_to_load);
+        Imf::PixelType pix_type =
+            exr_channels_decision(in, mptr.stream_id_, load_as_half, exr_channels_to_load);
+        if (exr_channels_to_load.size() > max_channels)
+            exr_channels_to_load.resize(max_channels);
 
-        Imath::Box2i data_window    = in.header().dataWindow();
         Imath::Box2i display_window = in.header().displayWindow();
 
         // decide the area of the image we want to load
-        const bool cropped_data_window = false; /*crop_data_window(
-                 data_window,
-                 display_window,
-                 max_exr_overscan_percent_
-                 );*/
+        const ExrReadRegion region = choose_region(in.header());
+        if (covers(current_loaded, mptr, region))
+            return current_loaded;
 
         // compute the size of the buffer we need
-        const size_t n_pixels = (data_window.size().x + 1) * (data_window.size().y + 1);
+        const Imath::V2i out_size(
+            (region.window.size().x + region.decimate) / region.decimate,
+            (region.window.size().y + region.decimate) / region.decimate);
+        const size_t n_pixels          = size_t(out_size.x) * size_t(out_size.y);
         const size_t bytes_per_channel = (pix_type == Imf::PixelType::HALF ? 2 : 4);
         const size_t bytes_per_pixel   = bytes_per_channel * exr_channels_to_load.size();
         const size_t buf_size          = n_pixels * bytes_per_pixel;
 
-        // const size_t gl_line_size = 8192*4;
-        // const size_t padded_buf_size = (buf_size & (gl_line_size-1)) ?
-        // ((buf_size/gl_line_size) + 1)*gl_line_size : buf_size;
-
         JsonStore jsn;
         jsn["num_channels"] = exr_channels_to_load.size();
         jsn["pix_type"]     = int(pix_type);
-        // jsn["path"] = to_string(mptr.uri_);
+        jsn["decimate"]     = region.decimate;
 
         ImageBufPtr buf(new ImageBuffer(openexr_shader_uuid, jsn));
         buf->allocate(buf_size);
@@ -355,80 +631,12 @@ ImageBufPtr OpenEXRMediaReader::image(const media::AVFrameID &mptr) {
         buf->set_image_dimensions(
             display_window.size(),
             Imath::Box2i(
-                data_window.min, Imath::V2i(data_window.max.x + 1, data_window.max.y + 1)));
+                region.window.min,
+                Imath::V2i(region.window.max.x + 1, region.window.max.y + 1)));
 
         buf->params()["path"] = to_string(mptr.uri_);
 
-        if (cropped_data_window) {
-            // if we are not loading the whole data window, we need to provide a temporary
-            // buffer that matches the EXR data window width for OpenEXR to load pixels into, we
-            // then copy the pixels we want into our cropped image buffer. We do this in chunks
-            // in the Y dimension to take advantage of OpenEXR decompress threads that are
-            // (possibly) more efficient when decoding blocks of pixels at once
-            const Imath::Box2i actual_data_window = in.header().dataWindow();
-            const size_t actual_data_window_width = actual_data_window.size().x + 1;
-            const size_t line_stride              = actual_data_window_width * bytes_per_pixel;
-            const size_t cropped_line_stride = (data_window.size().x + 1) * bytes_per_pixel;
-            Imf::FrameBuffer fb;
-
-            std::vector<uint8_t> tmp_buf(
-                bytes_per_pixel * actual_data_window_width * EXR_READ_BLOCK_HEIGHT);
-            byte *buffer = buf->buffer();
-
-            for (int chunk_y_min = data_window.min.y; chunk_y_min < data_window.max.y;
-                 chunk_y_min += EXR_READ_BLOCK_HEIGHT) {
-
-                uint8_t *fPtr = tmp_buf.data() - actual_data_window.min.x * bytes_per_pixel -
-                                chunk_y_min * line_stride;
-
-                Imf::FrameBuffer fb;
-                std::for_each(
-                    exr_channels_to_load.begin(),
-                    exr_channels_to_load.end(),
-                    [&](const std::string chan_name) {
-                        fb.insert(
-                            chan_name.c_str(),
-                            Imf::Slice(
-                                pix_type, (char *)fPtr, bytes_per_pixel, line_stride, 1, 1, 0));
-                        fPtr += bytes_per_channel;
-                    });
-                in.setFrameBuffer(fb);
-
-                const int ymax =
-                    std::min(chunk_y_min + EXR_READ_BLOCK_HEIGHT - 1, data_window.max.y);
-                in.readPixels(chunk_y_min, ymax);
-
-                // TODO: this copy may benefit from threading
-                fPtr = tmp_buf.data() +
-                       (data_window.min.x - actual_data_window.min.x) * bytes_per_pixel;
-                for (int l = chunk_y_min; l < ymax; ++l) {
-                    memcpy(buffer, fPtr, cropped_line_stride);
-                    buffer += cropped_line_stride;
-                    fPtr += line_stride;
-                }
-            }
-
-        } else {
-
-            const size_t line_stride =
-                (data_window.max.x - data_window.min.x + 1) * bytes_per_pixel;
-            byte *buffer = buf->buffer() - data_window.min.x * bytes_per_pixel -
-                           data_window.min.y * line_stride;
-
-            Imf::FrameBuffer fb;
-            std::for_each(
-                exr_channels_to_load.begin(),
-                exr_channels_to_load.end(),
-                [&](const std::string chan_name) {
-                    fb.insert(
-                        chan_name.c_str(),
-                        Imf::Slice(
-                            pix_type, (char *)buffer, bytes_per_pixel, line_stride, 1, 1, 0));
-                    buffer += bytes_per_channel;
-                });
-            in.setFrameBuffer(fb);
-            in.readPixels(data_window.min.y, data_window.max.y);
-        }
+        read_exr_pixels(in, exr_channels_to_load, pix_type, region, buf->buffer());
         return buf;
     } catch (const std::exception &err) {
         throw media_corrupt_error(err.what());
@@ -438,6 +646,44 @@ ImageBufPtr OpenEXRMediaReader::image(const media::AVFrameID &mptr) {
     return ImageBufPtr();
 }
 
+} // namespace
+
+ImageBufPtr OpenEXRMediaReader::image(const media::AVFrameID &mptr) {
+    return read_exr(mptr, load_float_as_half_, 4, [this](const Imf::Header &header) {
+        ExrReadRegion region;
+        region.window = crop_data_window(
+            header.dataWindow(), header.displayWindow(), max_exr_overscan_percent_);
+        return region;
+    });
+}
+
+ImageBufPtr OpenEXRMediaReader::partial_image(
+    const media::AVFrameID &mptr,
+    ImageBufPtr &current_loaded,
+    const Imath::Box2f &viewport_visible_area,
+    const Imath::V2i &viewport_size_screen_pixels,
+    const Imath::M44f &image_transform) {
+    auto buf = read_exr(
+        mptr,
+        load_float_as_half_,
+        4,
+        [&](const Imf::Header &header) {
+            return partial_region(
+                header,
+                crop_data_window(
+                    header.dataWindow(), header.displayWindow(), max_exr_overscan_percent_),
+                viewport_visible_area,
+                viewport_size_screen_pixels,
+                image_transform);
+        },
+        current_loaded);
+
+    // labelled here, so the next call can tell what it holds
+    if (buf && buf != current_loaded)
+        buf->set_media_key(media_reader::partial_frame_key(mptr.key_, buf));
+    return buf;
+}
+
 MRCertainty
 OpenEXRMediaReader::supported(const caf::uri &, const std::array<uint8_t, 16> &sig) {
     if (sig[0] == 0x76 && sig[1] == 0x2f && sig[2] == 0x31 && sig[3] == 0x01)
@@ -450,6 +696,7 @@ xstudio::media::MediaDetail OpenEXRMediaReader::detail(const caf::uri &uri) cons
     const std::string path(uri_to_posix_path(uri));
     utility::FrameRateDuration frd;
     utility::Timecode tc("00:00:00:00");
+    std::vector<media::StreamDetail> streams;
 
     try {
         Imf::MultiPartInputFile input(path.c_str());
@@ -490,11 +737,14 @@ xstudio::media::MediaDetail OpenEXRMediaReader::detail(const caf::uri &uri) cons
         }
 
         frd.set_rate(utility::FrameRate(1.0 / fr));
+
+        for (const auto &stream : exr_layer_streams(h.channels()))
+            streams.emplace_back(frd, stream);
     } catch (const std::exception &e) {
         throw media_corrupt_error(e.what());
     }
 
-    return xstudio::media::MediaDetail(name(), {media::StreamDetail(frd)}, tc);
+    return xstudio::media::MediaDetail(name(), streams, tc);
 }
 
 thumbnail::ThumbnailBufferPtr
@@ -518,7 +768,18 @@ OpenEXRMediaReader::thumbnail(const media::AVFrameID &mptr, const size_t thumb_s
         return thumb;
     } else {
 
-        ImageBufPtr full_image_buffer = image(mptr);
+        // Every decimate'th row and column of the image is still enough for
+        // the thumbnail, and we only need RGB at half precision
+        ImageBufPtr full_image_buffer =
+            read_exr(mptr, true, 3, [&](const Imf::Header &header) {
+                ExrReadRegion region;
+                region.window = crop_data_window(
+                    header.dataWindow(), header.displayWindow(), max_exr_overscan_percent_);
+                const Imath::V2i dims = header.displayWindow().size() + Imath::V2i(1, 1);
+                while (std::max(dims.x, dims.y) / (region.decimate * 2) >= int(thumb_size))
+                    region.decimate *= 2;
+                return region;
+            });
 
         int exr_width     = full_image_buffer->image_size_in_pixels().x;
         int exr_height    = full_image_buffer->image_size_in_pixels().y;
@@ -555,6 +816,13 @@ PixelInfo OpenEXRMediaReader::exr_buffer_pixel_picker(
     int pix_type                      = buf.shader_params().value("pix_type", 0);
     const Imath::V2i image_bounds_min = buf.image_pixels_bounding_box().min;
     const Imath::V2i image_bounds_max = buf.image_pixels_bounding_box().max;
+    const int decimate                = std::max(buf.shader_params().value("decimate", 1), 1);
+
+    // see pixel_index in the shader
+    auto pixel_index = [&](const Imath::V2i image_coord) -> int {
+        const Imath::V2i p = (image_coord - image_bounds_min) / decimate;
+        return p.x + p.y * ((image_bounds_max.x - image_bounds_min.x + decimate - 1) / decimate);
+    };
 
     auto get_image_data_float32 = [&](const int address) -> float {
         if (address < 0 || address >= buf.size())
@@ -575,10 +843,7 @@ PixelInfo OpenEXRMediaReader::exr_buffer_pixel_picker(
         if (image_coord.y < image_bounds_min.y || image_coord.y >= image_bounds_max.y)
             return Imath::V4f(0.0, 0.0, 0.0, 0.0);
 
-        int pixel_address_bytes =
-            ((image_coord.x - image_bounds_min.x) +
-             (image_coord.y - image_bounds_min.y) * (image_bounds_max.x - image_bounds_min.x)) *
-            num_channels * 4;
+        int pixel_address_bytes = pixel_index(image_coord) * num_channels * 4;
 
         float R = get_image_data_float32(pixel_address_bytes);
 
@@ -610,10 +875,7 @@ PixelInfo OpenEXRMediaReader::exr_buffer_pixel_picker(
         if (image_coord.y < image_bounds_min.y || image_coord.y >= image_bounds_max.y)
             return Imath::V4f(0.0, 0.0, 0.0, 0.0);
 
-        int pixel_address_bytes =
-            ((image_coord.x - image_bounds_min.x) +
-             (image_coord.y - image_bounds_min.y) * (image_bounds_max.x - image_bounds_min.x)) *
-            num_channels * 2;
+        int pixel_address_bytes = pixel_index(image_coord) * num_channels * 2;
 
         Imath::V2f pixRG = get_image_data_2xhalf_float(pixel_address_bytes);
 
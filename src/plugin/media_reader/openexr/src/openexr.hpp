@@ -22,6 +22,13 @@ namespace media_reader {
         supported(const caf::uri &uri, const std::array<uint8_t, 16> &signature) override;
 
         ImageBufPtr image(const media::AVFrameID &mptr) override;
+        ImageBufPtr partial_image(
+            const media::AVFrameID &mptr,
+            ImageBufPtr &current_loaded,
+            const Imath::Box2f &viewport_visible_area,
+            const Imath::V2i &viewport_size_screen_pixels,
+            const Imath::M44f &image_transform) override;
+        [[nodiscard]] bool can_do_partial_frames() const override { return true; }
         media::MediaDetail detail(const caf::uri &uri) const override;
         thumbnail::ThumbnailBufferPtr
         thumbnail(const media::AVFrameID &mpr, const size_t thumb_size) override;
@@ -37,6 +44,7 @@ namespace media_reader {
 
         float max_exr_overscan_percent_;
         int readers_per_source_;
+        bool load_float_as_half_;
     };
 } // namespace media_reader
 } // namespace xstudio
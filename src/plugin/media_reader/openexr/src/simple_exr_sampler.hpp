@@ -13,10 +13,12 @@ namespace media_reader {
             exr_data_win = exr_buf->image_pixels_bounding_box();
             exr_chans    = exr_buf->shader_params()["num_channels"].get<int>();
             pix_type     = exr_buf->shader_params()["pix_type"].get<int>();
+            decimate     = std::max(exr_buf->shader_params().value("decimate", 1), 1);
 
             exr_bytes_per_pixel = exr_chans * (pix_type == Imf::PixelType::HALF ? 2 : 4);
             exr_bytes_per_line =
-                (exr_data_win.max.x - exr_data_win.min.x) * exr_bytes_per_pixel;
+                ((exr_data_win.max.x - exr_data_win.min.x + decimate - 1) / decimate) *
+                exr_bytes_per_pixel;
 
             xscale = float(exr_size.x) / float(thumbuf_->width());
             yscale = float(exr_size.y) / float(thumbuf_->height());
@@ -26,10 +28,17 @@ namespace media_reader {
         thumbnail::ThumbnailBufferPtr thumbuf_;
         Imath::V2i exr_size;
         Imath::Box2i exr_data_win;
-        int exr_chans, pix_type;
+        int exr_chans, pix_type, decimate;
         int exr_bytes_per_pixel, exr_bytes_per_line;
         float xscale, yscale;
 
+        // the buffer may only have every decimate'th row and column
+        [[nodiscard]] inline const byte *pixel_address(const int x, const int y) const {
+            return exr_buf_->buffer() +
+                   ((x - exr_data_win.min.x) / decimate) * exr_bytes_per_pixel +
+                   ((y - exr_data_win.min.y) / decimate) * exr_bytes_per_line;
+        }
+
         struct RGB {
 
             RGB() : r(0), g(0), b(0) {}
@@ -60,7 +69,7 @@ namespace media_reader {
                 y >= exr_data_win.max.y)
                 return RGB();
 
-            half * pix = (half *)(exr_buf_->buffer() + (x-exr_data_win.min.x)*exr_bytes_per_pixel + (y-exr_data_win.min.y)*exr_bytes_per_line);
+            half * pix = (half *)pixel_address(x, y);
             if (exr_chans <= 2) {
                 return RGB(pix[0]);
             } else {
@@ -73,7 +82,7 @@ namespace media_reader {
                 y >= exr_data_win.max.y)
                 return std::array<float, 3>({1.0f, 0.0f, 1.0f});
 
-            half * pix = (half *)(exr_buf_->buffer() + (x-exr_data_win.min.x)*exr_bytes_per_pixel + (y-exr_data_win.min.y)*exr_bytes_per_line);
+            half * pix = (half *)pixel_address(x, y);
             if (exr_chans <= 2)
                 return std::array<float, 3>({pix[0], pix[0], pix[0]});
 
@@ -86,10 +95,7 @@ namespace media_reader {
                 y >= exr_data_win.max.y)
                 return RGB();
 
-            float * pix = (float *)(exr_buf_->buffer()
-                + (x-exr_data_win.min.x)*exr_bytes_per_pixel
-                + (y-exr_data_win.min.y)*exr_bytes_per_line
-                );
+            float * pix = (float *)pixel_address(x, y);
             if (exr_chans <= 2) {
                 return RGB(pix[0]);
             } else {
@@ -103,10 +109,7 @@ namespace media_reader {
                 y >= exr_data_win.max.y)
                 return std::array<float, 3>();
 
-            float * pix = (float *)(exr_buf_->buffer()
-                + (x-exr_data_win.min.x)*exr_bytes_per_pixel
-                + (y-exr_data_win.min.y)*exr_bytes_per_line
-                );
+            float * pix = (float *)pixel_address(x, y);
             if (exr_chans <= 2)
                 return std::array<float, 3>({pix[0], pix[0], pix[0]});
 
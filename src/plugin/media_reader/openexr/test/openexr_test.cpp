@@ -1,6 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 
+#include <chrono>
+#include <filesystem>
+
+#include <ImfChannelList.h>
+#include <ImfOutputFile.h>
+#include <ImfRgbaFile.h>
+
 #include "openexr.hpp"
+#include "simple_exr_sampler.hpp"
 #include "xstudio/media/media.hpp"
 #include "xstudio/media_reader/media_reader.hpp"
 #include "xstudio/utility/helpers.hpp"
@@ -35,3 +43,241 @@ TEST(OpenEXRMediaReaderTest, Test) {
 
     EXPECT_TRUE(got_image) << "Should be supported";
 }
+
+TEST(OpenEXRMediaReaderTest, PartialImage) {
+    OpenEXRMediaReader mr;
+    const media::AVFrameID mptr(posix_path_to_uri(TEST_RESOURCE "/media/test.0001.exr"));
+    auto full = mr.image(mptr);
+    ASSERT_TRUE(full);
+
+    const size_t bytes_per_pixel = full->shader_params().value("num_channels", 0) *
+                                   (full->shader_params().value("pix_type", 0) == 1 ? 2 : 4);
+    const Imath::Box2i full_bounds = full->image_pixels_bounding_box();
+
+    auto same_pixel = [&](const ImageBufPtr &part, const Imath::V2i part_index) {
+        const Imath::Box2i bounds = part->image_pixels_bounding_box();
+        const int decimate        = part->shader_params().value("decimate", 1);
+        const int part_width      = (bounds.max.x - bounds.min.x + decimate - 1) / decimate;
+        const Imath::V2i p        = bounds.min + part_index * decimate - full_bounds.min;
+        return memcmp(
+                   part->buffer() +
+                       (part_index.x + part_index.y * part_width) * bytes_per_pixel,
+                   full->buffer() +
+                       (p.x + p.y * (full_bounds.max.x - full_bounds.min.x)) * bytes_per_pixel,
+                   bytes_per_pixel) == 0;
+    };
+
+    // zoomed in on the middle of the image
+    ImageBufPtr current;
+    auto zoomed_in = mr.partial_image(
+        mptr,
+        current,
+        Imath::Box2f(Imath::V2f(-0.1f, -0.1f), Imath::V2f(0.1f, 0.1f)),
+        Imath::V2i(4096, 4096),
+        Imath::M44f());
+    ASSERT_TRUE(zoomed_in);
+    const Imath::Box2i bounds = zoomed_in->image_pixels_bounding_box();
+    EXPECT_EQ(zoomed_in->shader_params().value("decimate", 0), 1);
+    EXPECT_TRUE(full_bounds.intersects(bounds));
+    EXPECT_LT(bounds.size().x, full_bounds.size().x);
+    EXPECT_LT(bounds.size().y, full_bounds.size().y);
+    EXPECT_TRUE(same_pixel(zoomed_in, Imath::V2i(0, 0)));
+    EXPECT_TRUE(same_pixel(zoomed_in, bounds.size() / 2));
+    EXPECT_TRUE(same_pixel(zoomed_in, bounds.size() - Imath::V2i(1, 1)));
+
+    // nothing has moved, so what we have will do
+    EXPECT_EQ(
+        mr.partial_image(
+            mptr,
+            zoomed_in,
+            Imath::Box2f(Imath::V2f(-0.1f, -0.1f), Imath::V2f(0.1f, 0.1f)),
+            Imath::V2i(4096, 4096),
+            Imath::M44f()),
+        zoomed_in);
+
+    // the whole image in a tiny viewport
+    auto zoomed_out = mr.partial_image(
+        mptr,
+        current,
+        Imath::Box2f(Imath::V2f(-1.0f, -1.0f), Imath::V2f(1.0f, 1.0f)),
+        Imath::V2i(4, 4),
+        Imath::M44f());
+    ASSERT_TRUE(zoomed_out);
+    EXPECT_EQ(zoomed_out->shader_params().value("decimate", 0), 8);
+    EXPECT_EQ(zoomed_out->image_pixels_bounding_box(), full_bounds);
+    EXPECT_TRUE(same_pixel(zoomed_out, Imath::V2i(0, 0)));
+    EXPECT_TRUE(same_pixel(zoomed_out, Imath::V2i(1, 3)));
+    EXPECT_TRUE(same_pixel(zoomed_out, Imath::V2i(7, 7)));
+
+    // each part of the image is keyed apart from the full frame and the others
+    EXPECT_NE(zoomed_in->media_key(), mptr.key_);
+    EXPECT_NE(zoomed_out->media_key(), mptr.key_);
+    EXPECT_NE(zoomed_in->media_key(), zoomed_out->media_key());
+}
+
+TEST(OpenEXRMediaReaderTest, OverscanCrop) {
+    // a 64x64 image with 32 pixels of overscan all round, each pixel holding
+    // its own coordinates
+    const auto path =
+        (std::filesystem::temp_directory_path() / "openexr_test_overscan.exr").string();
+    const Imath::Box2i display_window(Imath::V2i(0, 0), Imath::V2i(63, 63));
+    const Imath::Box2i data_window(Imath::V2i(-32, -32), Imath::V2i(95, 95));
+    {
+        std::vector<Imf::Rgba> pixels(128 * 128);
+        for (int y = 0; y < 128; y++)
+            for (int x = 0; x < 128; x++)
+                pixels[x + y * 128] = Imf::Rgba(x - 32, y - 32, 0, 1);
+        Imf::RgbaOutputFile out(path.c_str(), display_window, data_window);
+        out.setFrameBuffer(pixels.data() - data_window.min.x - data_window.min.y * 128, 1, 128);
+        out.writePixels(128);
+    }
+
+    OpenEXRMediaReader mr(JsonStore(nlohmann::json::parse(R"({
+        "plugin": {"media_reader": {"OpenEXR": {
+            "max_exr_overscan_percent": {"value": 10.0},
+            "readers_per_source": {"value": 1}}}}})")));
+
+    auto image = mr.image(media::AVFrameID(posix_path_to_uri(path)));
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image->shader_params().value("num_channels", 0), 4);
+
+    // 10% of 64 is 6 pixels
+    const Imath::Box2i bounds = image->image_pixels_bounding_box();
+    EXPECT_EQ(bounds, Imath::Box2i(Imath::V2i(-6, -6), Imath::V2i(70, 70)));
+
+    // channels are loaded as R, G, B, A halfs
+    auto pixel = [&](const int x, const int y) {
+        const half *p = (const half *)image->buffer() +
+                        ((x - bounds.min.x) + (y - bounds.min.y) * bounds.size().x) * 4;
+        return Imath::V2f(p[0], p[1]);
+    };
+    EXPECT_EQ(pixel(-6, -6), Imath::V2f(-6, -6));
+    EXPECT_EQ(pixel(30, 40), Imath::V2f(30, 40));
+    EXPECT_EQ(pixel(69, 69), Imath::V2f(69, 69));
+
+    std::filesystem::remove(path);
+}
+
+TEST(OpenEXRMediaReaderTest, Layers) {
+    // float R, G, B of 1, 2, 3 and a half "diffuse" layer of 4, 5, 6
+    const auto path =
+        (std::filesystem::temp_directory_path() / "openexr_test_layers.exr").string();
+    const int size = 16;
+    {
+        Imf::Header header(size, size);
+        Imf::FrameBuffer fb;
+        std::vector<std::vector<float>> float_chans;
+        std::vector<std::vector<half>> half_chans;
+        for (const auto &[name, value] :
+             std::vector<std::pair<std::string, float>>({{"R", 1}, {"G", 2}, {"B", 3}})) {
+            header.channels().insert(name, Imf::Channel(Imf::FLOAT));
+            float_chans.emplace_back(size * size, value);
+            fb.insert(
+                name,
+                Imf::Slice(
+                    Imf::FLOAT,
+                    (char *)float_chans.back().data(),
+                    sizeof(float),
+                    sizeof(float) * size));
+        }
+        for (const auto &[name, value] : std::vector<std::pair<std::string, float>>(
+                 {{"diffuse.R", 4}, {"diffuse.G", 5}, {"diffuse.B", 6}})) {
+            header.channels().insert(name, Imf::Channel(Imf::HALF));
+            half_chans.emplace_back(size * size, half(value));
+            fb.insert(
+                name,
+                Imf::Slice(
+                    Imf::HALF,
+                    (char *)half_chans.back().data(),
+                    sizeof(half),
+                    sizeof(half) * size));
+        }
+        Imf::OutputFile out(path.c_str(), header);
+        out.setFrameBuffer(fb);
+        out.writePixels(size);
+    }
+
+    OpenEXRMediaReader mr;
+    const caf::uri uri = posix_path_to_uri(path);
+    const auto detail  = mr.detail(uri);
+    ASSERT_EQ(detail.streams_.size(), size_t(2));
+    EXPECT_EQ(detail.streams_[0].name_, "Main");
+    EXPECT_EQ(detail.streams_[1].name_, "diffuse");
+
+    auto first_pixel = [](const ImageBufPtr &image) {
+        EXPECT_EQ(image->shader_params().value("num_channels", 0), 3);
+        EXPECT_EQ(image->shader_params().value("pix_type", 0), int(Imf::HALF));
+        const half *p = (const half *)image->buffer();
+        return Imath::V3f(p[0], p[1], p[2]);
+    };
+
+    // each layer is a stream with its own key, float is loaded as half
+    const media::AVFrameID main_frame(uri, 0, 0, FrameRate(), "Main");
+    const media::AVFrameID diffuse_frame(uri, 0, 0, FrameRate(), "diffuse");
+    EXPECT_NE(main_frame.key_, diffuse_frame.key_);
+    EXPECT_EQ(first_pixel(mr.image(main_frame)), Imath::V3f(1, 2, 3));
+    EXPECT_EQ(first_pixel(mr.image(diffuse_frame)), Imath::V3f(4, 5, 6));
+
+    std::filesystem::remove(path);
+}
+
+// Writes and reads several 4K frames, so only run on request with
+// --gtest_also_run_disabled_tests
+TEST(OpenEXRMediaReaderTest, DISABLED_ThumbnailBenchmark) {
+    // Logs thumbnails per second for a few 4K frames without preview images,
+    // ZIP compressed as renders usually are
+    const auto dir = std::filesystem::temp_directory_path() / "openexr_test_thumbnails";
+    std::filesystem::create_directories(dir);
+    const int width = 4096, height = 2160, frames = 4;
+    std::vector<caf::uri> uris;
+    {
+        std::vector<Imf::Rgba> pixels(size_t(width) * height);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                pixels[x + y * width] =
+                    Imf::Rgba(float(x) / width, float(y) / height, 0.5f, 1.0f);
+        for (int i = 0; i < frames; i++) {
+            const auto path = (dir / fmt::format("thumb.{:04d}.exr", i)).string();
+            Imf::RgbaOutputFile out(path.c_str(), width, height);
+            out.setFrameBuffer(pixels.data(), 1, width);
+            out.writePixels(height);
+            uris.push_back(posix_path_to_uri(path));
+        }
+    }
+
+    OpenEXRMediaReader mr;
+    const size_t thumb_size = 256;
+
+    auto thumbnails_per_second = [&](auto make_thumbnail) {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &uri : uris) {
+            auto thumb = make_thumbnail(media::AVFrameID(uri));
+            EXPECT_EQ(thumb->width(), thumb_size);
+        }
+        return double(frames) /
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // what thumbnail() did before, sampling the full resolution image
+    const double full = thumbnails_per_second([&](const media::AVFrameID &mptr) {
+        auto image      = mr.image(mptr);
+        const auto dims = image->image_size_in_pixels();
+        auto thumb      = std::make_shared<thumbnail::ThumbnailBuffer>(
+            thumb_size, thumb_size * dims.y / dims.x, thumbnail::TF_RGBF96);
+        SimpleExrSampler(image, thumb).fill_output();
+        return thumb;
+    });
+    const double decimated = thumbnails_per_second(
+        [&](const media::AVFrameID &mptr) { return mr.thumbnail(mptr, thumb_size); });
+
+    spdlog::info(
+        "{}x{} EXR thumbnails per second: full image {:.1f}, decimated {:.1f}",
+        width,
+        height,
+        full,
+        decimated);
+    EXPECT_GT(full, 0.0);
+    EXPECT_GT(decimated, 0.0);
+
+    std::filesystem::remove_all(dir);
+}
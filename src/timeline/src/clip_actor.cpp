@@ -246,151 +246,45 @@ void ClipActor::init() {
             const media::MediaType media_type,
             const std::vector<FrameRate> &timepoints,
             const FrameRate &override_rate) -> result<media::AVFrameIDs> {
-            if (media_) {
-                auto result = std::make_shared<media::AVFrameIDs>(timepoints.size());
-                auto rp     = make_response_promise<media::AVFrameIDs>();
-
-                auto trimmed_start = base_.item().trimmed_start();
-                auto active_start =
-                    (base_.item().active_start() ? *base_.item().active_start()
-                                                 : trimmed_start);
-                auto available_start =
-                    (base_.item().available_start() ? *base_.item().available_start()
-                                                    : trimmed_start);
-
-                // spdlog::warn("trs {} avs {} act {}", trimmed_start.to_seconds(),
-                // available_start.to_seconds(), active_start.to_seconds());
-
-                // build logical frame ranges.
-                auto ranges = media::LogicalFrameRanges();
-                auto indexs = std::vector<int>();
-                auto range  = std::pair<int, int>(-1, -1);
-
-                auto index = 0;
-                for (const auto timepoint : timepoints) {
-                    auto frd = FrameRateDuration(
-                        FrameRate(timepoint.to_flicks() - available_start.to_flicks()),
-                        override_rate);
-                    auto logical_frame = frd.frames(base_.item().rate());
-
-                    if (media_type == media::MediaType::MT_IMAGE and
-                        image_ptr_cache_.count(logical_frame)) {
-                        (*result)[index] = image_ptr_cache_[logical_frame];
-                        if (range.first != -1) {
-                            ranges.push_back(range);
-                            range.first  = -1;
-                            range.second = -1;
-                        }
-                    } else if (
-                        media_type == media::MediaType::MT_AUDIO and
-                        audio_ptr_cache_.count(logical_frame)) {
-                        (*result)[index] = audio_ptr_cache_[logical_frame];
-                        if (range.first != -1) {
-                            ranges.push_back(range);
-                            range.first  = -1;
-                            range.second = -1;
-                        }
-                    } else {
-                        // extend or flush rane
-                        if (range.first != -1) {
-                            if (logical_frame != range.second + 1) {
-                                ranges.push_back(range);
-                                range.first  = -1;
-                                range.second = -1;
-                            } else {
-                                range.second = logical_frame;
-                            }
-                        }
-
-                        if (range.first == -1) {
-                            range.first  = logical_frame;
-                            range.second = logical_frame;
-                            indexs.push_back(index);
-                        }
-                    }
-
-                    index++;
-                }
-
-                if (range.first != -1)
-                    ranges.push_back(range);
-
-                if (indexs.empty()) {
-                    rp.deliver(*result);
-                } else {
-                    request(
-                        caf::actor_cast<caf::actor>(media_),
-                        infinite,
-                        media::get_media_pointers_atom_v,
-                        media_type,
-                        ranges,
-                        FrameRate())
-                        .then(
-                            [=](const media::AVFrameIDs &mps) mutable {
-                                auto mp = mps.begin();
-                                for (size_t i = 0; i < indexs.size(); i++) {
-                                    auto ind = indexs[i];
-                                    auto rng = ranges[i];
-                                    for (auto ii = rng.first; ii <= rng.second; ii++, ind++) {
-                                        if (media_type == media::MediaType::MT_IMAGE) {
-                                            image_ptr_cache_[ii] = *mp;
-                                            (*result)[ind]       = image_ptr_cache_[ii];
-                                        } else if (media_type == media::MediaType::MT_AUDIO) {
-                                            audio_ptr_cache_[ii] = *mp;
-                                            (*result)[ind]       = audio_ptr_cache_[ii];
-                                        }
-                                        mp++;
-                                    }
-                                }
-                                // spdlog::warn("deliver {}", result->size());
-                                rp.deliver(*result);
-                            },
-                            [=](error &err) mutable {
-                                for (size_t i = 0; i < indexs.size(); i++) {
-                                    auto ind = indexs[i];
-                                    auto rng = ranges[i];
-                                    for (auto ii = rng.first; ii <= rng.second; ii++, ind++)
-                                        (*result)[ind] = media::make_blank_frame(media_type);
-                                }
-                                spdlog::warn("{} {}", __PRETTY_FUNCTION__, to_string(err));
-                                // rp.deliver(std::move(err));
-                                rp.deliver(*result);
-                            });
-
-                    // for(size_t i = 0; i < indexs.size(); i++) {
-                    //     auto ind = indexs[i];
-                    //     auto rng = ranges[i];
-
-                    //     try {
-                    //         // FrameRate() might need setting correctly..
-                    //         auto mps = request_receive<media::AVFrameIDs>(
-                    //             *sys, caf::actor_cast<caf::actor>(media_),
-                    //             media::get_media_pointers_atom_v, media_type,
-                    //             media::LogicalFrameRanges({rng}), FrameRate());
-
-                    //         for(auto mp : mps ){
-                    //             if(media_type == media::MediaType::MT_IMAGE) {
-                    //                 image_ptr_cache_[ind] = mp;
-                    //                 (*result)[ind] = image_ptr_cache_[ind];
-                    //             } else if(media_type == media::MediaType::MT_AUDIO) {
-                    //                 audio_ptr_cache_[ind] = mp;
-                    //                 (*result)[ind] = audio_ptr_cache_[ind];
-                    //             }
-                    //             ind++;
-                    //         }
-
-                    //     } catch (const std::exception &err) {
-                    //         for(auto ii = rng.first; ii <= rng.second; ii++, ind++)
-                    //             (*result)[ind] = make_blank_frame(media_type);
-                    //         spdlog::warn("{} {}", __PRETTY_FUNCTION__, err.what());
-                    //     }
-                    // }
-                    // rp.deliver(*result);
-                }
-                return rp;
-            }
+            if (not media_)
+                return make_error(xstudio_error::error, "No media assigned.");
+
+            auto logical_frames = std::vector<int>();
+            logical_frames.reserve(timepoints.size());
+            for (const auto &timepoint : timepoints)
+                logical_frames.push_back(to_logical_frame(timepoint, override_rate));
+
+            auto rp = make_response_promise<media::AVFrameIDs>();
+            get_media_pointers(
+                media_type, logical_frames, [=](const media::AVFrameIDs &mps) mutable {
+                    rp.deliver(mps);
+                });
+            return rp;
+        },
 
-            return make_error(xstudio_error::error, "No media assigned.");
+        // a span of clip time, from the timeline, starting at time and stepping
+        // by override_rate. The frames come back as spans, which the
+        // FrameTimeMap they end up in expands.
+        [=](media::get_media_pointer_atom,
+            const media::MediaType media_type,
+            const FrameRate &time,
+            const int frames,
+            const FrameRate &override_rate) -> result<media::AVFrameIDSpans> {
+            if (not media_)
+                return make_error(xstudio_error::error, "No media assigned.");
+
+            auto logical_frames = std::vector<int>();
+            logical_frames.reserve(std::max(frames, 0));
+            for (auto i = 0; i < frames; i++)
+                logical_frames.push_back(to_logical_frame(
+                    FrameRate(time.to_flicks() + i * override_rate.to_flicks()), override_rate));
+
+            auto rp = make_response_promise<media::AVFrameIDSpans>();
+            get_media_pointers(
+                media_type, logical_frames, [=](const media::AVFrameIDs &mps) mutable {
+                    rp.deliver(media::make_spans(mps));
+                });
+            return rp;
         },
 
         // [=](media::get_media_pointer_atom, const media::MediaType media_type, const FrameRate
@@ -461,6 +355,119 @@ void ClipActor::init() {
     );
 }
 
+int ClipActor::to_logical_frame(const FrameRate &timepoint, const FrameRate &override_rate) const {
+    auto trimmed_start = base_.item().trimmed_start();
+    auto available_start =
+        (base_.item().available_start() ? *base_.item().available_start() : trimmed_start);
+
+    auto frd = FrameRateDuration(
+        FrameRate(timepoint.to_flicks() - available_start.to_flicks()), override_rate);
+    return frd.frames(base_.item().rate());
+}
+
+void ClipActor::get_media_pointers(
+    const media::MediaType media_type,
+    const std::vector<int> &logical_frames,
+    std::function<void(const media::AVFrameIDs &)> deliver) {
+    auto result = std::make_shared<media::AVFrameIDs>(logical_frames.size());
+
+    // build logical frame ranges.
+    auto ranges = media::LogicalFrameRanges();
+    auto indexs = std::vector<int>();
+    auto range  = std::pair<int, int>(-1, -1);
+
+    auto index = 0;
+    for (const auto logical_frame : logical_frames) {
+        if (media_type == media::MediaType::MT_IMAGE and image_ptr_cache_.count(logical_frame)) {
+            (*result)[index] = image_ptr_cache_[logical_frame];
+            if (range.first != -1) {
+                ranges.push_back(range);
+                range.first  = -1;
+                range.second = -1;
+            }
+        } else if (
+            media_type == media::MediaType::MT_AUDIO and audio_ptr_cache_.count(logical_frame)) {
+            (*result)[index] = audio_ptr_cache_[logical_frame];
+            if (range.first != -1) {
+                ranges.push_back(range);
+                range.first  = -1;
+                range.second = -1;
+            }
+        } else {
+            // extend or flush rane
+            if (range.first != -1) {
+                if (logical_frame != range.second + 1) {
+                    ranges.push_back(range);
+                    range.first  = -1;
+                    range.second = -1;
+                } else {
+                    range.second = logical_frame;
+                }
+            }
+
+            if (range.first == -1) {
+                range.first  = logical_frame;
+                range.second = logical_frame;
+                indexs.push_back(index);
+            }
+        }
+
+        index++;
+    }
+
+    if (range.first != -1)
+        ranges.push_back(range);
+
+    if (indexs.empty()) {
+        deliver(*result);
+        return;
+    }
+
+    request(
+        caf::actor_cast<caf::actor>(media_),
+        infinite,
+        media::get_media_pointers_atom_v,
+        media_type,
+        ranges,
+        FrameRate())
+        .then(
+            [=](const media::AVFrameIDSpans &spans) mutable {
+                // the media's frames, in the order of our ranges
+                auto span  = spans.begin();
+                size_t pos = 0;
+                for (size_t i = 0; i < indexs.size(); i++) {
+                    auto ind = indexs[i];
+                    auto rng = ranges[i];
+                    for (auto ii = rng.first; ii <= rng.second; ii++, ind++) {
+                        while (span != spans.end() and pos == span->size()) {
+                            span++;
+                            pos = 0;
+                        }
+                        auto mp = span != spans.end() ? span->frame(pos++)
+                                                      : media::make_blank_frame(media_type);
+                        if (media_type == media::MediaType::MT_IMAGE) {
+                            image_ptr_cache_[ii] = mp;
+                            (*result)[ind]       = image_ptr_cache_[ii];
+                        } else if (media_type == media::MediaType::MT_AUDIO) {
+                            audio_ptr_cache_[ii] = mp;
+                            (*result)[ind]       = audio_ptr_cache_[ii];
+                        }
+                    }
+                }
+                deliver(*result);
+            },
+            [=](error &err) mutable {
+                for (size_t i = 0; i < indexs.size(); i++) {
+                    auto ind = indexs[i];
+                    auto rng = ranges[i];
+                    for (auto ii = rng.first; ii <= rng.second; ii++, ind++)
+                        (*result)[ind] = media::make_blank_frame(media_type);
+                }
+                spdlog::warn("{} {}", __PRETTY_FUNCTION__, to_string(err));
+                deliver(*result);
+            });
+}
+
 // void ClipActor::update_edit_list() {
 //     ClipList sl = media_edit_list_.section_list();
 
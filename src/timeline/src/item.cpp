@@ -170,7 +170,10 @@ utility::JsonStore Item::refresh(const int depth) {
 
     auto result = nlohmann::json::array();
 
-    for (auto &i : *this) {
+    // called after children have been changed directly, which we might not
+    // have seen
+    changed();
+    for (auto &i : static_cast<Items &>(*this)) {
         auto tmp = i.refresh(depth - 1);
         if (not tmp.is_null())
             result.insert(result.end(), tmp.begin(), tmp.end());
@@ -383,23 +386,13 @@ Item::resolve_time(const utility::FrameRate &time, const media::MediaType mt) co
 
     case IT_AUDIO_TRACK:
     case IT_VIDEO_TRACK:
-        // sequentail list of items.
+        // sequential list of items, found through the index
         {
-            auto ttp = time;
-            // spdlog::warn("{}", trimmed_start()/timebase::k_flicks_24fps);
-            // spdlog::warn("{}", ttp/timebase::k_flicks_24fps);
-            // spdlog::warn("{}", (ttp + trimmed_start())/timebase::k_flicks_24fps);
-            const auto ts = trimmed_start();
-            for (const auto &it : *this) {
-                const auto td = it.trimmed_duration();
-                if (ttp + ts >= td) {
-                    ttp -= td;
-                } else {
-                    auto t = it.resolve_time(ttp + ts, mt);
-                    if (t)
-                        return *t;
-                    break;
-                }
+            auto child = time_index_.find(*this, time + trimmed_start());
+            if (child) {
+                auto t = std::get<0>(*child)->resolve_time(std::get<1>(*child), mt);
+                if (t)
+                    return *t;
             }
         }
         break;
@@ -415,8 +408,137 @@ Item::resolve_time(const utility::FrameRate &time, const media::MediaType mt) co
     return {};
 }
 
+ResolvedSpan Item::resolve_span(const utility::FrameRate &time, const media::MediaType mt) const {
+    if (time >= trimmed_duration())
+        return {};
+
+    // nothing beyond the end of this item is ours to report
+    const auto remaining = utility::FrameRate(trimmed_duration() - time);
+    auto result          = ResolvedSpan{nullptr, utility::FrameRate(), remaining};
+
+    // a child span of zero means the child has ended, and stays empty for
+    // the rest of this item
+    const auto clamp = [&remaining](ResolvedSpan span) {
+        if (span.duration_ == utility::FrameRate() or span.duration_ > remaining)
+            span.duration_ = remaining;
+        return span;
+    };
+
+    if (transparent())
+        return result;
+
+    switch (item_type_) {
+    case IT_TIMELINE:
+        if (not empty())
+            result = clamp(front().resolve_span(time + trimmed_start(), mt));
+        break;
+
+    case IT_STACK:
+        // the first track with something at time wins, until one of the tracks
+        // above it stops being empty
+        for (const auto &it : *this) {
+            if (it.transparent() or
+                it.item_type() ==
+                    (mt == media::MediaType::MT_IMAGE ? IT_AUDIO_TRACK : IT_VIDEO_TRACK))
+                continue;
+
+            const auto span = clamp(it.resolve_span(time + trimmed_start(), mt));
+            if (span.duration_ < result.duration_)
+                result.duration_ = span.duration_;
+
+            if (span.item_) {
+                result.item_ = span.item_;
+                result.time_ = span.time_;
+                break;
+            }
+        }
+        break;
 
-void Item::set_enabled_direct(const bool &value) { enabled_ = value; }
+    case IT_AUDIO_TRACK:
+    case IT_VIDEO_TRACK: {
+        auto child = time_index_.find(*this, time + trimmed_start());
+        if (child)
+            result = clamp(std::get<0>(*child)->resolve_span(std::get<1>(*child), mt));
+    } break;
+
+    case IT_GAP:
+    case IT_CLIP:
+        result.item_ = this;
+        result.time_ = time + trimmed_start();
+        break;
+    case IT_NONE:
+    default:
+        break;
+    }
+
+    return result;
+}
+
+std::optional<std::tuple<const Item *, utility::FrameRate>>
+Item::TimeIndex::find(const Item &track, const utility::FrameRate &time) const {
+    std::lock_guard<std::mutex> l(mutex_);
+    update(track);
+
+    // the first child that ends after time
+    const auto it = std::upper_bound(ends_.begin(), ends_.end(), time);
+    if (it == ends_.end())
+        return {};
+
+    const auto index = std::distance(ends_.begin(), it);
+    const auto start = index ? ends_[index - 1] : utility::FrameRate();
+    return std::make_tuple(items_[index], utility::FrameRate(time - start));
+}
+
+std::vector<std::pair<const Item *, utility::FrameRate>> Item::TimeIndex::find_range(
+    const Item &track, const utility::FrameRate &start, const utility::FrameRate &end) const {
+    std::lock_guard<std::mutex> l(mutex_);
+    update(track);
+
+    std::vector<std::pair<const Item *, utility::FrameRate>> result;
+    // from the first child that ends after start, to the last one that
+    // starts before end
+    auto index = std::distance(
+        ends_.begin(), std::upper_bound(ends_.begin(), ends_.end(), start));
+    for (; index < static_cast<long>(ends_.size()); index++) {
+        const auto child_start = index ? ends_[index - 1] : utility::FrameRate();
+        if (not(child_start < end))
+            break;
+        result.emplace_back(items_[index], child_start);
+    }
+    return result;
+}
+
+void Item::TimeIndex::update(const Item &track) const {
+    if (generation_ == track.generation_)
+        return;
+
+    ends_.clear();
+    items_.clear();
+    auto end = utility::FrameRate();
+    for (const auto &i : track) {
+        end += i.trimmed_duration();
+        ends_.push_back(end);
+        items_.push_back(&i);
+    }
+    generation_ = track.generation_;
+}
+
+std::vector<std::pair<const Item *, utility::FrameRate>> Item::children_in_range(
+    const utility::FrameRate &time, const utility::FrameRate &duration) const {
+    if (item_type_ != IT_AUDIO_TRACK and item_type_ != IT_VIDEO_TRACK)
+        return {};
+
+    const auto start = time + trimmed_start();
+    auto result      = time_index_.find_range(*this, start, start + duration);
+    for (auto &i : result)
+        i.second = i.second - trimmed_start();
+    return result;
+}
+
+void Item::set_enabled_direct(const bool &value) {
+    changed();
+    enabled_ = value;
+}
 
 utility::JsonStore Item::set_enabled(const bool &value) {
     if (enabled_ != value) {
@@ -432,7 +554,10 @@ utility::JsonStore Item::set_enabled(const bool &value) {
     return utility::JsonStore();
 }
 
-void Item::set_actor_addr_direct(const caf::actor_addr &value) { uuid_addr_.second = value; }
+void Item::set_actor_addr_direct(const caf::actor_addr &value) {
+    changed();
+    uuid_addr_.second = value;
+}
 
 utility::JsonStore Item::make_actor_addr_update() const {
     utility::JsonStore jsn(R"([{"undo":{}, "redo":{}}])"_json);
@@ -468,6 +593,7 @@ utility::JsonStore Item::set_actor_addr(const caf::actor_addr &value) {
 }
 
 void Item::set_active_range_direct(const utility::FrameRange &value) {
+    changed();
     has_active_range_ = true;
     active_range_     = value;
 }
@@ -491,6 +617,7 @@ utility::JsonStore Item::set_active_range(const utility::FrameRange &value) {
 }
 
 void Item::set_available_range_direct(const utility::FrameRange &value) {
+    changed();
     has_available_range_ = true;
     available_range_     = value;
 }
@@ -515,6 +642,7 @@ utility::JsonStore Item::set_available_range(const utility::FrameRange &value) {
 }
 
 Items::iterator Item::insert_direct(Items::iterator position, const Item &val) {
+    changed();
     auto it = Items::insert(position, val);
     it->set_system(the_system_);
     return it;
@@ -541,7 +669,10 @@ Item::insert(Items::iterator position, const Item &value, const utility::JsonSto
     return jsn;
 }
 
-Items::iterator Item::erase_direct(Items::iterator position) { return Items::erase(position); }
+Items::iterator Item::erase_direct(Items::iterator position) {
+    changed();
+    return Items::erase(position);
+}
 
 utility::JsonStore Item::erase(Items::iterator position) {
     utility::JsonStore jsn(R"([{"undo":{}, "redo":{}}])"_json);
@@ -568,6 +699,7 @@ void Item::splice_direct(
     Items &other,
     Items::const_iterator first,
     Items::const_iterator last) {
+    changed();
     Items::splice(pos, other, first, last);
 }
 
@@ -667,10 +799,12 @@ bool Item::process_event(const utility::JsonStore &event) {
         if (item_event_callback_)
             item_event_callback_(event, *this);
     } else {
-        // child ?
-        for (auto &i : *this) {
-            if (i.process_event(event))
+        // child ? If so it may have moved our other children.
+        for (auto &i : static_cast<Items &>(*this)) {
+            if (i.process_event(event)) {
+                changed();
                 return true;
+            }
         }
 
         return false;
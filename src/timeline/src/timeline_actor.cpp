@@ -698,145 +698,97 @@ void TimelineActor::init() {
         [=](media::get_media_pointers_atom atom,
             const media::MediaType media_type,
             const media::LogicalFrameRanges &ranges,
-            const FrameRate &override_rate) -> caf::result<media::AVFrameIDs> {
+            const FrameRate &override_rate) -> caf::result<media::AVFrameIDSpans> {
             // spdlog::stopwatch sw;
-            auto num_frames = 0;
-            for (const auto &i : ranges)
-                num_frames += (i.second - i.first) + 1;
 
-
-            auto result = std::make_shared<media::AVFrameIDs>(num_frames);
-            auto count  = std::make_shared<int>();
-            *count      = 0;
-            // spdlog::warn("{} {} {} {}", media_type, num_frames, start_frame,
-            // override_rate.to_fps());
-
-            caf::scoped_actor sys(system());
-
-            auto item_tp = std::vector<std::optional<std::tuple<Item, utility::FrameRate>>>();
-            item_tp.reserve(num_frames);
+            // resolve the timeline a span at a time, each span being a run of
+            // frames from one clip, so the clips get one request per edit
+            // rather than one timepoint per frame. Clips answer with spans of
+            // frames too, which we pass on in order.
+            struct Span {
+                caf::actor actor_;
+                FrameRate time_;
+                int frames_;
+            };
+            auto spans = std::vector<Span>();
+            auto bf    = media::make_blank_frame(media_type);
+            auto step  = std::max(override_rate.to_flicks().count(), timebase::flicks::rep(1));
 
             for (const auto &r : ranges) {
-                for (auto i = r.first; i <= r.second; i++) {
-                    auto ii = base_.item().resolve_time(
+                for (auto i = r.first; i <= r.second;) {
+                    auto span = base_.item().resolve_span(
                         FrameRate(i * override_rate.to_flicks()), media_type);
-                    if (ii) {
-                        item_tp.emplace_back(*ii);
-                        (*count)++;
-                    } else {
-                        item_tp.emplace_back();
-                    }
+
+                    // the frames that start inside the span, or all of
+                    // them if we're past the end
+                    auto frames = r.second - i + 1;
+                    if (span.duration_ > FrameRate())
+                        frames = std::min(
+                            frames,
+                            static_cast<int>((span.duration_.count() + step - 1) / step));
+
+                    auto actor = span.item_ ? span.item_->actor() : caf::actor();
+                    spans.push_back(Span{actor, span.time_, frames});
+                    i += frames;
                 }
             }
 
-            // spdlog::error("resolve_time elapsed {:.3}", sw);
+            // spdlog::error("resolve_span elapsed {:.3}", sw);
+
+            // gaps and empty stretches are blank frames
+            auto blank = [=](const int frames) {
+                auto result = media::AVFrameIDSpan(bf);
+                for (auto i = 1; i < frames; i++)
+                    result.push_back(bf);
+                return result;
+            };
+
+            auto result  = std::make_shared<std::vector<media::AVFrameIDSpans>>(spans.size());
+            auto pending = std::make_shared<int>(0);
+            for (size_t i = 0; i < spans.size(); i++) {
+                if (spans[i].actor_)
+                    (*pending)++;
+                else if (spans[i].frames_ > 0)
+                    (*result)[i].push_back(blank(spans[i].frames_));
+            }
+
+            auto flatten = [=]() {
+                auto frames = media::AVFrameIDSpans();
+                for (const auto &i : *result)
+                    frames.insert(frames.end(), i.begin(), i.end());
+                return frames;
+            };
 
             //  only blank fraems
-            auto bf = media::make_blank_frame(media_type);
-            if (not *count) {
-                for (auto i = 0; i < num_frames; i++)
-                    (*result)[i] = bf;
-                // spdlog::error("blank output elapsed {:.3}", sw);
-                return *result;
-            }
+            if (not *pending)
+                return flatten();
 
-            auto rp = make_response_promise<media::AVFrameIDs>();
-
-            auto start = 0;
-            auto end   = 0;
-            auto tps   = std::vector<FrameRate>();
-            auto act   = caf::actor();
-
-            for (auto i = 0; i < num_frames; i++) {
-                auto item = item_tp[i];
-
-                // dispatch on actor change
-                if (not tps.empty() and (not item or std::get<0>(*item).actor() != act)) {
-                    request(
-                        act,
-                        infinite,
-                        media::get_media_pointer_atom_v,
-                        media_type,
-                        tps,
-                        override_rate)
-                        .then(
-                            [=, s = start, e = end](const media::AVFrameIDs &mps) mutable {
-                                for (auto ii = s; ii <= e; ii++) {
-                                    (*result)[ii] = mps[ii - s];
-                                    (*count)--;
-                                    // spdlog::error("s {} e {} ii {} c {}", s, e, ii, *count);
-                                    if (not *count) {
-                                        rp.deliver(*result);
-                                        // spdlog::error("get_media_pointers_atom elapsed
-                                        // {:.3}", sw);
-                                    }
-                                }
-                            },
-
-                            [=, s = start, e = end](error &err) mutable {
-                                for (auto ii = s; ii <= e; ii++) {
-                                    (*result)[ii] = bf;
-                                    (*count)--;
-                                    // spdlog::error("s {} e {} ii {} c {}", s, e, ii, *count);
-                                    if (not *count) {
-                                        rp.deliver(*result);
-                                        // spdlog::error("get_media_pointers_atom elapsed
-                                        // {:.3}", sw);
-                                    }
-                                }
-                            });
-
-                    start = end = i;
-                    tps.clear();
-                    act = (item ? std::get<0>(*item).actor() : caf::actor());
-                }
+            auto rp = make_response_promise<media::AVFrameIDSpans>();
 
-                if (not item) {
-                    (*result)[i] = bf;
-                } else {
-                    if (tps.empty()) {
-                        start = i;
-                        act   = std::get<0>(*item).actor();
-                    }
-                    end = i;
-                    tps.push_back(std::get<1>(*item));
-                }
-            }
+            for (size_t i = 0; i < spans.size(); i++) {
+                const auto &span = spans[i];
+                if (not span.actor_)
+                    continue;
 
-            // catch all
-            if (not tps.empty()) {
                 request(
-                    act,
+                    span.actor_,
                     infinite,
                     media::get_media_pointer_atom_v,
                     media_type,
-                    tps,
+                    span.time_,
+                    span.frames_,
                     override_rate)
                     .then(
-                        [=, s = start, e = end](const media::AVFrameIDs &mps) mutable {
-                            for (auto ii = s; ii <= e; ii++) {
-                                (*result)[ii] = mps[ii - s];
-                                (*count)--;
-                                // spdlog::error("s {} e {} ii {} c {}", s, e, ii, *count);
-                                if (not *count) {
-                                    rp.deliver(*result);
-                                    // spdlog::error("get_media_pointers_atom elapsed {:.3}",
-                                    // sw);
-                                }
-                            }
+                        [=](const media::AVFrameIDSpans &mps) mutable {
+                            (*result)[i] = mps;
+                            if (not --(*pending))
+                                rp.deliver(flatten());
                         },
 
-                        [=, s = start, e = end](error &err) mutable {
-                            for (auto ii = s; ii <= e; ii++) {
-                                (*result)[ii] = bf;
-                                (*count)--;
-                                // spdlog::error("s {} e {} ii {} c {}", s, e, ii, *count);
-                                if (not *count) {
-                                    rp.deliver(*result);
-                                    // spdlog::error("get_media_pointers_atom elapsed {:.3}",
-                                    // sw);
-                                }
-                            }
+                        [=, n = span.frames_](error &err) mutable {
+                            (*result)[i] = media::AVFrameIDSpans({blank(n)});
+                            if (not --(*pending))
+                                rp.deliver(flatten());
                         });
             }
 
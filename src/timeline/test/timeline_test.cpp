@@ -287,4 +287,34 @@ TEST(TimelineTestFull, Test) {
         EXPECT_EQ(i.uuid(), c004.item().uuid());
         EXPECT_EQ(t, timebase::k_flicks_24fps * 105);
     }
+
+    // spans must agree with resolve_time on every frame they cover, and
+    // together cover the timeline
+    {
+        auto spans = 0;
+        auto frame = 0;
+        while (frame < 19) {
+            auto span = s.item().resolve_span(timebase::k_flicks_24fps * frame);
+            EXPECT_GT(span.duration_, FrameRate());
+            if (span.duration_ <= FrameRate())
+                break;
+
+            auto end = frame + static_cast<int>(span.duration_ / timebase::k_flicks_24fps);
+            for (auto f = frame; f < end; f++) {
+                auto rt = s.item().resolve_time(timebase::k_flicks_24fps * f);
+                EXPECT_EQ(static_cast<bool>(rt), span.item_ != nullptr);
+                if (rt and span.item_) {
+                    auto [i, t] = *rt;
+                    EXPECT_EQ(i.uuid(), span.item_->uuid());
+                    EXPECT_EQ(t, span.time_ + timebase::k_flicks_24fps * (f - frame));
+                }
+            }
+            frame = end;
+            spans++;
+        }
+
+        EXPECT_EQ(frame, 19);
+        EXPECT_LT(spans, 19);
+        EXPECT_EQ(s.item().resolve_span(timebase::k_flicks_24fps * 19).duration_, FrameRate());
+    }
 }
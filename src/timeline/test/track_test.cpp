@@ -3,9 +3,11 @@
 
 #include "xstudio/media/media_actor.hpp"
 #include "xstudio/timeline/track.hpp"
+#include "xstudio/timeline/clip.hpp"
 #include "xstudio/timeline/gap.hpp"
 #include "xstudio/utility/helpers.hpp"
 #include "xstudio/utility/uuid.hpp"
+#include "xstudio/utility/logging.hpp"
 
 using namespace xstudio;
 using namespace xstudio::utility;
@@ -31,3 +33,190 @@ TEST(TrackTest, Test) {
     t.refresh_item();
     EXPECT_EQ(t.item().trimmed_range().duration(), timebase::k_flicks_24fps * 20);
 }
+
+TEST(TrackTest, ResolveTimeAfterEdit) {
+    Track t("Track", MediaType::MT_IMAGE);
+
+    Clip c1("Clip-001");
+    c1.item().set_available_range(FrameRange(
+        FrameRateDuration(0, timebase::k_flicks_24fps),
+        FrameRateDuration(5, timebase::k_flicks_24fps)));
+    Clip c2("Clip-002");
+    c2.item().set_available_range(FrameRange(
+        FrameRateDuration(10, timebase::k_flicks_24fps),
+        FrameRateDuration(3, timebase::k_flicks_24fps)));
+
+    t.children().push_back(c1.item());
+    t.children().push_back(c2.item());
+    t.refresh_item();
+
+    {
+        auto [i, f] = *(t.item().resolve_time(timebase::k_flicks_24fps * 5));
+        EXPECT_EQ(i.uuid(), c2.uuid());
+        EXPECT_EQ(f, timebase::k_flicks_24fps * 10);
+    }
+
+    // lengthen the first clip, the second must move along
+    t.children().front().set_available_range(FrameRange(
+        FrameRateDuration(0, timebase::k_flicks_24fps),
+        FrameRateDuration(7, timebase::k_flicks_24fps)));
+    t.refresh_item();
+
+    {
+        auto [i, f] = *(t.item().resolve_time(timebase::k_flicks_24fps * 5));
+        EXPECT_EQ(i.uuid(), c1.uuid());
+        EXPECT_EQ(f, timebase::k_flicks_24fps * 5);
+    }
+    {
+        auto [i, f] = *(t.item().resolve_time(timebase::k_flicks_24fps * 9));
+        EXPECT_EQ(i.uuid(), c2.uuid());
+        EXPECT_EQ(f, timebase::k_flicks_24fps * 12);
+    }
+    EXPECT_FALSE(t.item().resolve_time(timebase::k_flicks_24fps * 10));
+
+    // remove the first clip
+    t.children().pop_front();
+    t.refresh_item();
+
+    {
+        auto [i, f] = *(t.item().resolve_time(timebase::k_flicks_24fps * 0));
+        EXPECT_EQ(i.uuid(), c2.uuid());
+        EXPECT_EQ(f, timebase::k_flicks_24fps * 10);
+    }
+
+    // copies resolve to their own children
+    auto copy = t.item();
+    auto [i, f] = *(copy.resolve_time(timebase::k_flicks_24fps * 1));
+    EXPECT_EQ(i.uuid(), c2.uuid());
+    EXPECT_EQ(&i, &(copy.front()));
+}
+
+TEST(TrackTest, ResolveTimeAfterEvent) {
+    auto clip_range = [](const int duration) {
+        return FrameRange(
+            FrameRateDuration(0, timebase::k_flicks_24fps),
+            FrameRateDuration(duration, timebase::k_flicks_24fps));
+    };
+
+    Item track(ItemType::IT_VIDEO_TRACK);
+    Item clip(
+        ItemType::IT_CLIP,
+        UuidActorAddr(Uuid::generate(), caf::actor_addr()),
+        std::optional<FrameRange>(),
+        clip_range(5));
+    track.emplace_back(clip);
+    track.emplace_back(
+        ItemType::IT_CLIP,
+        UuidActorAddr(Uuid::generate(), caf::actor_addr()),
+        std::optional<FrameRange>(),
+        clip_range(3));
+
+    const auto &ctrack = track;
+    auto child_at      = [&](const int frame) {
+        return &(std::get<0>(*ctrack.resolve_time(timebase::k_flicks_24fps * frame)));
+    };
+    EXPECT_EQ(child_at(5), &ctrack.back());
+
+    // lengthen the first clip through an event, as a timeline actor would,
+    // without touching the track's children or refreshing it
+    track.update(clip.set_available_range(clip_range(7)));
+    EXPECT_EQ(child_at(5), &ctrack.front());
+    EXPECT_EQ(child_at(7), &ctrack.back());
+}
+
+TEST(TrackTest, ChildrenInRange) {
+    Item track(ItemType::IT_VIDEO_TRACK);
+    for (const auto duration : {4, 2, 6})
+        track.emplace_back(
+            ItemType::IT_CLIP,
+            UuidActorAddr(Uuid::generate(), caf::actor_addr()),
+            std::optional<FrameRange>(),
+            FrameRange(
+                FrameRateDuration(0, timebase::k_flicks_24fps),
+                FrameRateDuration(duration, timebase::k_flicks_24fps)));
+    const auto &ctrack = track;
+
+    auto starts = [&](const int time, const int duration) {
+        std::vector<timebase::flicks> result;
+        for (const auto &i : ctrack.children_in_range(
+                 timebase::k_flicks_24fps * time, timebase::k_flicks_24fps * duration))
+            result.push_back(i.second);
+        return result;
+    };
+
+    EXPECT_EQ(starts(0, 4), std::vector<timebase::flicks>({timebase::k_flicks_zero_seconds}));
+    EXPECT_EQ(
+        starts(3, 2),
+        std::vector<timebase::flicks>(
+            {timebase::k_flicks_zero_seconds, timebase::k_flicks_24fps * 4}));
+    EXPECT_EQ(
+        starts(5, 20),
+        std::vector<timebase::flicks>(
+            {timebase::k_flicks_24fps * 4, timebase::k_flicks_24fps * 6}));
+    EXPECT_TRUE(starts(12, 2).empty());
+
+    const auto in_range =
+        ctrack.children_in_range(timebase::k_flicks_24fps * 5, timebase::k_flicks_24fps);
+    ASSERT_EQ(in_range.size(), size_t(1));
+    EXPECT_EQ(in_range[0].first, &(*std::next(ctrack.begin())));
+}
+
+TEST(TrackTest, DISABLED_ResolveTimeBenchmark) {
+    const int tracks        = 8;
+    const int clips         = 250;
+    const int clip_duration = 8;
+
+    Item stack(ItemType::IT_STACK);
+    for (int i = 0; i < tracks; i++) {
+        Item track(ItemType::IT_VIDEO_TRACK);
+        for (int j = 0; j < clips; j++)
+            track.emplace_back(
+                ItemType::IT_CLIP,
+                Uuid::generate(),
+                std::optional<FrameRange>(),
+                FrameRange(
+                    FrameRateDuration(0, timebase::k_flicks_24fps),
+                    FrameRateDuration(clip_duration, timebase::k_flicks_24fps)));
+        stack.emplace_back(track);
+    }
+    stack.refresh();
+
+    const auto &cstack = stack;
+    const int frames   = clips * clip_duration;
+
+    auto start   = std::chrono::steady_clock::now();
+    int resolved = 0;
+    for (const auto &track : cstack)
+        for (int f = 0; f < frames; f++)
+            if (track.resolve_time(timebase::k_flicks_24fps * f))
+                resolved++;
+    auto indexed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(resolved, tracks * frames);
+
+    // the walk resolve_time used to do
+    start    = std::chrono::steady_clock::now();
+    resolved = 0;
+    for (const auto &track : cstack)
+        for (int f = 0; f < frames; f++) {
+            auto time = FrameRate(timebase::k_flicks_24fps * f);
+            for (const auto &clip : track) {
+                if (time < clip.trimmed_duration()) {
+                    if (clip.resolve_time(time))
+                        resolved++;
+                    break;
+                }
+                time -= clip.trimmed_duration();
+            }
+        }
+    auto linear = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(resolved, tracks * frames);
+
+    spdlog::info(
+        "resolve_time {} clips {} frames, indexed {}us linear {}us",
+        tracks * clips,
+        tracks * frames,
+        std::chrono::duration_cast<std::chrono::microseconds>(indexed).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(linear).count());
+}
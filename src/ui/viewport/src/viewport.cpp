@@ -614,6 +614,32 @@ void Viewport::update_fit_mode_matrix(
     fit_mode_matrix_.makeIdentity();
     fit_mode_matrix_.scale(Imath::V3f(state_.fit_mode_zoom_, state_.fit_mode_zoom_, 1.0f));
     fit_mode_matrix_.translate(Imath::V3f(tx, ty, 0.0f));
+
+    send_view_to_playhead();
+}
+
+void Viewport::send_view_to_playhead() {
+
+    // a second viewer may show the same playhead at another zoom, so only
+    // the main viewer decides what gets loaded
+    if (!is_main_viewer_ || !playhead_addr_)
+        return;
+
+    // takes viewport coordinates (-1 to 1) into image space
+    const Imath::M44f transform = (fit_mode_matrix() * inv_projection_matrix()).inverse();
+    const Imath::V2i size(int(round(state_.size_.x)), int(round(state_.size_.y)));
+    if (transform == view_sent_transform_ && size == view_sent_size_)
+        return;
+
+    view_sent_transform_ = transform;
+    view_sent_size_      = size;
+    anon_send(
+        caf::actor_cast<caf::actor>(playhead_addr_),
+        playhead::viewport_view_atom_v,
+        Imath::V2f(-1.0f, -1.0f),
+        Imath::V2f(1.0f, 1.0f),
+        size,
+        transform);
 }
 
 float Viewport::pixel_zoom() const {
@@ -986,6 +1012,10 @@ void Viewport::set_playhead(caf::actor playhead, const bool wait_for_refresh) {
     if (playhead)
         sys->anon_send(playhead, playhead::jump_atom_v);
     playhead_addr_ = caf::actor_cast<caf::actor_addr>(playhead);
+
+    // the new playhead hasn't been told what's in view
+    view_sent_size_ = Imath::V2i(0, 0);
+    send_view_to_playhead();
 }
 
 void Viewport::attribute_changed(const utility::Uuid &attr_uuid, const int role) {
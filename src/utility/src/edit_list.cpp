@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <experimental/numeric>
 #include <functional>
 #include <iostream>
@@ -77,6 +78,34 @@ EditList::flick_durations(const TimeSourceMode tsm, const FrameRate &fr) const {
 }
 
 
+size_t EditList::section_frames(
+    const size_t first,
+    const size_t count,
+    const TimeSourceMode tsm,
+    const FrameRate &override_rate) const {
+    size_t frames = 0;
+    for (auto i = first; i < std::min(first + count, sl_.size()); i++)
+        frames += static_cast<size_t>(sl_[i].frame_rate_and_duration_.frames(
+            tsm == TimeSourceMode::FIXED ? override_rate : FrameRate()));
+    return frames;
+}
+
+timebase::flicks EditList::section_flicks(
+    const size_t first,
+    const size_t count,
+    const TimeSourceMode tsm,
+    const FrameRate &override_rate) const {
+    timebase::flicks _flicks = timebase::k_flicks_zero_seconds;
+    for (auto i = first; i < std::min(first + count, sl_.size()); i++) {
+        const auto &frd = sl_[i].frame_rate_and_duration_;
+        if (tsm == TimeSourceMode::FIXED)
+            _flicks += override_rate.to_flicks() * frd.frames(override_rate);
+        else
+            _flicks += frd.rate().to_flicks() * frd.frames();
+    }
+    return _flicks;
+}
+
 size_t EditList::duration_frames(const TimeSourceMode tsm, const FrameRate &fr) const {
     long int frames = 0;
 
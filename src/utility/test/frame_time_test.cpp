@@ -185,6 +185,17 @@ TEST(EditListTest1, Test) {
         timebase::to_seconds(edit_list.duration_flicks(TimeSourceMode::DYNAMIC, r24)), 1.5f);
     EXPECT_EQ(
         timebase::to_seconds(edit_list.duration_flicks(TimeSourceMode::REMAPPED, r24)), 1.5f);
+
+    // as a playhead steps through them, fixed mode shows every section at r24
+    EXPECT_EQ(edit_list.section_frames(0, 3, TimeSourceMode::FIXED, r24), size_t(36));
+    EXPECT_EQ(edit_list.section_frames(1, 5, TimeSourceMode::DYNAMIC, r24), size_t(30));
+    EXPECT_EQ(edit_list.section_flicks(0, 3, TimeSourceMode::FIXED, r24), r24.to_flicks() * 36);
+    EXPECT_EQ(
+        edit_list.section_flicks(0, 3, TimeSourceMode::DYNAMIC, r24),
+        edit_list.duration_flicks(TimeSourceMode::DYNAMIC, r24));
+    EXPECT_EQ(
+        edit_list.section_flicks(2, 1, TimeSourceMode::DYNAMIC, r24),
+        timebase::to_flicks(0.5));
 }
 
 TEST(EditListTest2, Test) {
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+
+#include "xstudio/utility/helpers.hpp"
+#include "xstudio/media/media.hpp"
+#include "xstudio/utility/sharded_time_cache.hpp"
+#include "xstudio/utility/time_cache.hpp"
+#include "xstudio/utility/uuid.hpp"
+
+using namespace xstudio::utility;
+
+TEST(ShardedTimeCacheTest, Test) {
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>> mc(4);
+    EXPECT_EQ(mc.shard_count(), unsigned(4));
+    EXPECT_EQ(mc.count(), unsigned(0));
+
+    mc.store("test", std::make_shared<std::string>("testing"));
+    mc.store("test2", std::make_shared<std::string>("testing"));
+    EXPECT_EQ(mc.count(), unsigned(2));
+    EXPECT_EQ(mc.size(), unsigned(14));
+    EXPECT_EQ(*(mc.retrieve("test")), "testing");
+    EXPECT_FALSE(mc.retrieve("missing"));
+    EXPECT_TRUE(mc.preserve("test"));
+    EXPECT_FALSE(mc.preserve("missing"));
+
+    EXPECT_TRUE(mc.erase("test"));
+    EXPECT_FALSE(mc.erase("test"));
+    EXPECT_EQ(mc.keys(), std::vector<std::string>({"test2"}));
+
+    Uuid uuid(Uuid::generate());
+    mc.store("test", std::make_shared<std::string>("testing"), clock::now(), false, uuid);
+    EXPECT_TRUE(mc.erase(uuid));
+    EXPECT_EQ(mc.count(), unsigned(1));
+
+    mc.clear();
+    EXPECT_EQ(mc.count(), unsigned(0));
+}
+
+TEST(ShardedTimeCacheTest, Limits) {
+    using namespace std::chrono_literals;
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>> mc(4);
+    mc.set_max_count(40);
+    EXPECT_EQ(mc.max_count(), unsigned(40));
+
+    auto now = clock::now();
+    for (size_t i = 0; i < 200; i++)
+        mc.store(std::to_string(i), std::make_shared<std::string>("testing"), now + i * 1s);
+
+    // later entries are no further from now than the ones already stored, so
+    // once the budget is used up they are turned away.
+    EXPECT_EQ(mc.count(), unsigned(40));
+    EXPECT_EQ(mc.size(), unsigned(40 * 7));
+    EXPECT_TRUE(mc.retrieve("39"));
+    EXPECT_FALSE(mc.retrieve("40"));
+
+    mc.set_max_count(10);
+    EXPECT_EQ(mc.count(), unsigned(10));
+}
+
+namespace {
+struct OneShard {
+    size_t operator()(const std::string &) const { return 0; }
+};
+} // namespace
+
+TEST(ShardedTimeCacheTest, GlobalBudget) {
+    using namespace std::chrono_literals;
+
+    // the budget isn't divided between shards, one shard can use all of it
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>, OneShard> lopsided(16);
+    lopsided.set_max_count(4);
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_TRUE(lopsided.store(std::to_string(i), std::make_shared<std::string>("testing")));
+    EXPECT_EQ(lopsided.count(), unsigned(4));
+
+    // and entries go in the same order as from a single TimeCache, whichever
+    // shard they are in
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>> mc(4);
+    TimeCache<std::string, std::shared_ptr<std::string>> single;
+    mc.set_max_count(8);
+    single.set_max_count(8);
+
+    auto now = clock::now();
+    for (size_t i = 0; i < 8; i++) {
+        const auto when = now + std::chrono::seconds(8 - i);
+        mc.store(std::to_string(i), std::make_shared<std::string>("testing"), when);
+        single.store(std::to_string(i), std::make_shared<std::string>("testing"), when);
+    }
+
+    for (size_t i = 8; i < 12; i++) {
+        const auto when = now + 500ms;
+        EXPECT_TRUE(mc.store(std::to_string(i), std::make_shared<std::string>("testing"), when));
+        EXPECT_TRUE(
+            single.store(std::to_string(i), std::make_shared<std::string>("testing"), when));
+    }
+
+    auto keys          = mc.keys();
+    auto expected_keys = single.keys();
+    std::sort(keys.begin(), keys.end());
+    std::sort(expected_keys.begin(), expected_keys.end());
+    EXPECT_EQ(keys, expected_keys);
+    EXPECT_EQ(mc.count(), unsigned(8));
+    // the four wanted furthest in the future went
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_FALSE(mc.retrieve(std::to_string(i)));
+}
+
+TEST(ShardedTimeCacheTest, Changes) {
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>> mc(4);
+    int notified = 0;
+    mc.bind_change_callback([&notified]() { notified++; });
+
+    mc.store("test", std::make_shared<std::string>("testing"));
+    mc.store("test2", std::make_shared<std::string>("testing"));
+    mc.erase("test2");
+    EXPECT_EQ(notified, 1);
+
+    std::vector<std::string> stored, erased;
+    mc.take_changes(stored, erased);
+    EXPECT_EQ(stored, std::vector<std::string>({"test"}));
+    EXPECT_EQ(erased, std::vector<std::string>({"test2"}));
+
+    mc.take_changes(stored, erased);
+    EXPECT_TRUE(stored.empty());
+    EXPECT_TRUE(erased.empty());
+
+    mc.erase("test");
+    EXPECT_EQ(notified, 2);
+}
+
+TEST(ShardedTimeCacheTest, ConcurrentRetrieve) {
+    const size_t entries    = 2000;
+    const size_t threads    = 16;
+    const size_t iterations = 20000;
+
+    ShardedTimeCache<std::string, std::shared_ptr<std::string>> sharded;
+    // single lock around one cache, the same serialisation as sending every
+    // retrieve to the cache actor.
+    std::mutex single_mutex;
+    TimeCache<std::string, std::shared_ptr<std::string>> single;
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < entries; i++) {
+        keys.push_back(std::to_string(i));
+        sharded.store(keys.back(), std::make_shared<std::string>("testing"));
+        single.store(keys.back(), std::make_shared<std::string>("testing"));
+    }
+
+    auto run = [&](auto fn) {
+        std::vector<std::thread> pool;
+        auto start = clock::now();
+        for (size_t t = 0; t < threads; t++)
+            pool.emplace_back([&, t]() {
+                for (size_t i = 0; i < iterations; i++)
+                    fn(keys[(i * threads + t) % entries]);
+            });
+        for (auto &i : pool)
+            i.join();
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    std::atomic<size_t> hits{0};
+    auto sharded_time = run([&](const std::string &key) {
+        if (sharded.retrieve(key))
+            hits++;
+    });
+    EXPECT_EQ(hits, threads * iterations);
+
+    hits = 0;
+    auto single_time = run([&](const std::string &key) {
+        std::lock_guard<std::mutex> l(single_mutex);
+        if (single.retrieve(key))
+            hits++;
+    });
+    EXPECT_EQ(hits, threads * iterations);
+
+    spdlog::info(
+        "{} threads, {} retrieves: sharded {:.0f}/sec, single lock {:.0f}/sec",
+        threads,
+        threads * iterations,
+        (threads * iterations) / sharded_time,
+        (threads * iterations) / single_time);
+}
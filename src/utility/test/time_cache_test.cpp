@@ -179,3 +179,94 @@ TEST(TimeCacheTest2, Test) {
     // new
     EXPECT_TRUE(mc.store_check("test", 1000));
 }
+
+TEST(TimeCacheTest, EvictionOrder) {
+    using namespace std::chrono_literals;
+    TimeCache<std::string, std::shared_ptr<std::string>> mc;
+    std::vector<std::string> evicted;
+
+    mc.bind_change_callback(
+        [&evicted](const std::vector<std::string> &, const std::vector<std::string> &erase) {
+            evicted.insert(evicted.end(), erase.begin(), erase.end());
+        });
+
+    auto now    = clock::now();
+    auto buffer = std::make_shared<std::string>("testing");
+
+    mc.store("ahead", buffer, now + 10s);
+    mc.store("behind", buffer, now - 5s);
+    mc.store("soon", buffer, now + 1s);
+    // straddling entries, nearest time point decides.
+    mc.store("straddle_near", buffer, now - 20s);
+    mc.store("straddle_near", buffer, now + 2s);
+    mc.store("straddle_far", buffer, now - 3s);
+    mc.store("straddle_far", buffer, now + 30s);
+
+    while (mc.release())
+        ;
+
+    EXPECT_EQ(
+        evicted,
+        std::vector<std::string>(
+            {"ahead", "behind", "straddle_far", "straddle_near", "soon"}));
+    EXPECT_EQ(mc.count(), unsigned(0));
+
+    // out of date release picks the oldest most recent time point.
+    evicted.clear();
+    mc.store("old", buffer, now - 10s);
+    mc.store("older", buffer, now - 20s);
+    mc.store("future", buffer, now + 10s);
+    EXPECT_TRUE(mc.release_out_of_date(now));
+    EXPECT_TRUE(mc.release_out_of_date(now));
+    EXPECT_FALSE(mc.release_out_of_date(now));
+    EXPECT_EQ(evicted, std::vector<std::string>({"older", "old"}));
+}
+
+TEST(TimeCacheTest, EvictionCallback) {
+    using namespace std::chrono_literals;
+    TimeCache<std::string, std::shared_ptr<std::string>> mc(14);
+    std::vector<std::pair<std::string, std::string>> evicted;
+
+    mc.bind_eviction_callback(
+        [&evicted](const std::string &key, const std::shared_ptr<std::string> &value) {
+            evicted.emplace_back(key, *value);
+        });
+
+    auto now = clock::now();
+    mc.store("a", std::make_shared<std::string>("aaaaaaa"), now + 10s);
+    mc.store("b", std::make_shared<std::string>("bbbbbbb"), now + 1s);
+    // explicit erase isn't an eviction
+    mc.erase("b");
+    EXPECT_TRUE(evicted.empty());
+
+    // making room is
+    mc.store("b", std::make_shared<std::string>("bbbbbbb"), now + 1s);
+    mc.store("c", std::make_shared<std::string>("ccccccc"), now + 2s, true);
+    EXPECT_EQ(
+        evicted, (std::vector<std::pair<std::string, std::string>>({{"a", "aaaaaaa"}})));
+}
+
+TEST(TimeCacheTest, DISABLED_StoreThroughput) {
+    using namespace std::chrono_literals;
+    const size_t entries = 50000;
+    TimeCache<std::string, std::shared_ptr<std::string>> mc(
+        std::numeric_limits<size_t>::max(), entries);
+
+    auto buffer = std::make_shared<std::string>("testing");
+    auto now    = clock::now();
+    auto start  = clock::now();
+
+    // fill, then keep storing so every store has to evict.
+    for (size_t i = 0; i < entries * 2; i++)
+        mc.store(std::to_string(i), buffer, now + (i % entries) * 40ms, true);
+
+    auto elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    spdlog::info(
+        "TimeCache {} stores ({} evicting) in {:.3f}s, {:.0f} stores/sec",
+        entries * 2,
+        entries,
+        elapsed,
+        (entries * 2) / elapsed);
+
+    EXPECT_EQ(mc.count(), entries);
+}